@@ -81,6 +81,51 @@ function(copy_assets)
 endfunction()
 
 
+function(pack_assets)
+    if(NOT asset_files)
+        return()
+    endif()
+
+    cmake_parse_arguments(arg "COMPRESS" "COMPRESSION_LEVEL" "" ${ARGN})
+
+    set(pack_options)
+    if(arg_COMPRESS)
+        list(APPEND pack_options --compress)
+    endif()
+    if(arg_COMPRESSION_LEVEL)
+        list(APPEND pack_options --level ${arg_COMPRESSION_LEVEL})
+    endif()
+
+    # Name assets by their path relative to the app, same as copied assets
+    set(file_mappings)
+    foreach(file ${asset_files})
+        get_base_dir(${file} base_dir)
+        file(RELATIVE_PATH rel_path ${base_dir} ${file})
+        list(APPEND file_mappings "${file}@${rel_path}")
+    endforeach()
+
+    # Create a single memory-mapped asset pack via the asset-packer example
+    set(output "${runtime_output_dir}/${app_name}-assets.pack")
+    add_custom_command(
+        OUTPUT
+            ${output}
+        DEPENDS
+            ${asset_files}
+            asset-packer
+        COMMAND
+            $<TARGET_FILE:asset-packer>
+            ${output}
+            ${file_mappings}
+            ${pack_options}
+        COMMENT
+            "Packing asset files"
+    )
+
+    add_custom_target(${app_name}-assets DEPENDS ${output})
+    add_dependencies(${app_name} ${app_name}-assets)
+endfunction()
+
+
 function(package_assets)
     if(NOT asset_files)
         return()
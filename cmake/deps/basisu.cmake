@@ -0,0 +1,73 @@
+if(TARGET basisu::transcoder)
+    return()
+endif()
+
+include(FetchContent)
+
+FetchContent_Declare(
+    basisu
+    URL https://github.com/BinomialLLC/basis_universal/archive/refs/tags/v1_50_0_2.zip
+)
+
+FetchContent_GetProperties(basisu)
+if(NOT ${basisu_POPULATED})
+    FetchContent_Populate(basisu)
+endif()
+
+# NOTE(dr): Zstd's single-file decoder is needed for UASTC payloads with Zstandard
+# supercompression and for reading compressed asset packs at runtime
+add_library(
+    basisu-zstd-decoder STATIC
+    "${basisu_SOURCE_DIR}/zstd/zstddeclib.c"
+)
+add_library(basisu::zstd-decoder ALIAS basisu-zstd-decoder)
+
+target_include_directories(
+    basisu-zstd-decoder
+    SYSTEM # Ignore warnings
+    INTERFACE
+        "${basisu_SOURCE_DIR}/zstd"
+)
+
+# NOTE(dr): The full library is only needed by tools that compress asset packs. It defines the
+# same decoder symbols so it's built as an object library. Its objects are then part of whatever
+# links it and are always linked ahead of the decoder archive, which is never pulled in.
+add_library(
+    basisu-zstd OBJECT
+    "${basisu_SOURCE_DIR}/zstd/zstd.c"
+)
+add_library(basisu::zstd ALIAS basisu-zstd)
+
+target_include_directories(
+    basisu-zstd
+    SYSTEM # Ignore warnings
+    INTERFACE
+        "${basisu_SOURCE_DIR}/zstd"
+)
+
+# NOTE(dr): Only the transcoder is built
+add_library(
+    basisu-transcoder STATIC
+    "${basisu_SOURCE_DIR}/transcoder/basisu_transcoder.cpp"
+)
+add_library(basisu::transcoder ALIAS basisu-transcoder)
+
+target_link_libraries(
+    basisu-transcoder
+    PRIVATE
+        basisu-zstd-decoder
+)
+
+target_include_directories(
+    basisu-transcoder
+    SYSTEM # Ignore warnings
+    INTERFACE
+        "${basisu_SOURCE_DIR}/transcoder"
+)
+
+target_compile_definitions(
+    basisu-transcoder
+    PUBLIC
+        BASISD_SUPPORT_KTX2=1
+        BASISD_SUPPORT_KTX2_ZSTD=1
+)
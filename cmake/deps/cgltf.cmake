@@ -0,0 +1,26 @@
+if(TARGET cgltf::cgltf)
+    return()
+endif()
+
+include(FetchContent)
+
+FetchContent_Declare(
+    cgltf
+    URL https://raw.githubusercontent.com/jkuhlmann/cgltf/v1.14/cgltf.h
+    DOWNLOAD_NO_EXTRACT TRUE
+)
+
+FetchContent_GetProperties(cgltf)
+if(NOT ${cgltf_POPULATED})
+    FetchContent_Populate(cgltf)
+endif()
+
+add_library(cgltf INTERFACE)
+add_library(cgltf::cgltf ALIAS cgltf)
+
+target_include_directories(
+    cgltf
+    SYSTEM # Ignore warnings
+    INTERFACE 
+        "${cgltf_SOURCE_DIR}"
+)
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <dr/basic_types.hpp>
+
+#include <asset_pack.hpp>
+#include <asset_pack_writer.hpp>
+
+#include "../dr_shim.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+struct Options
+{
+    char const* dst_path;
+    std::vector<AssetPackSource> sources;
+    AssetPackOptions pack;
+    bool compress;
+};
+
+// Sources are given as <file>@<name>, same as Emscripten's file packager. Without a name, assets
+// are named after their file path.
+AssetPackSource parse_source(std::string_view const arg)
+{
+    usize const split = arg.rfind('@');
+    if (split == std::string_view::npos)
+        return {std::string{arg}, std::string{arg}};
+
+    return {std::string{arg.substr(split + 1)}, std::string{arg.substr(0, split)}};
+}
+
+Options parse_options(int const argc, char** const argv)
+{
+    Options result{};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* const arg = argv[i];
+        char const* const val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(arg, "--compress") == 0)
+            result.compress = true;
+        else if (std::strcmp(arg, "--level") == 0 && val)
+            result.pack.compression_level = int(std::strtol(argv[++i], nullptr, 10));
+        else if (!result.dst_path)
+            result.dst_path = arg;
+        else
+            result.sources.push_back(parse_source(arg));
+    }
+
+    for (AssetPackSource& src : result.sources)
+        src.compress = result.compress;
+
+    return result;
+}
+
+} // namespace
+} // namespace wgpu::sandbox
+
+int main(int argc, char** argv)
+{
+    using namespace wgpu::sandbox;
+
+    Options const options = parse_options(argc, argv);
+    if (!options.dst_path || options.sources.empty())
+    {
+        fmt::println(
+            "Usage: asset-packer <output.pack> <file>[@<name>]... [--compress] [--level <n>]");
+        return EXIT_FAILURE;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto const t0 = Clock::now();
+
+    if (!write_asset_pack(options.dst_path, options.sources, options.pack))
+    {
+        fmt::println("Failed to write {}", options.dst_path);
+        return EXIT_FAILURE;
+    }
+
+    AssetPack pack = AssetPack::make(options.dst_path);
+    if (!pack.is_valid())
+    {
+        fmt::println("Failed to read back {}", options.dst_path);
+        return EXIT_FAILURE;
+    }
+
+    u64 size = 0;
+    usize compressed_count = 0;
+    for (AssetPackEntry const& entry : pack.get_entries())
+    {
+        size += entry.size;
+        compressed_count += (entry.compression != AssetCompression::None);
+    }
+
+    fmt::println(
+        "Wrote {} ({} assets, {} compressed, {:.1f} KB from {:.1f} KB, {:.1f} ms)",
+        options.dst_path,
+        pack.header->entry_count,
+        compressed_count,
+        f64(pack.file.size) / 1024.0,
+        f64(size) / 1024.0,
+        std::chrono::duration<f64, std::milli>(Clock::now() - t0).count());
+
+    AssetPack::release(pack);
+    return EXIT_SUCCESS;
+}
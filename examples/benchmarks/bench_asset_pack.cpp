@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <asset_pack.hpp>
+#include <asset_pack_writer.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize asset_count = 10000;
+constexpr usize assets_per_dir = 100;
+constexpr usize min_asset_size = 256;
+constexpr usize max_asset_size = 4096;
+constexpr usize run_count = 5;
+
+enum class Method : u8
+{
+    LooseFiles,
+    Pack,
+    PackCompressed,
+};
+
+char const* to_string(Method const value)
+{
+    static constexpr char const* names[]{
+        "loose files (fread)",
+        "pack (mmap)",
+        "pack (mmap + zstd)",
+    };
+    return names[int(value)];
+}
+
+// Text-like contents, similar to small shaders and config files
+std::string make_contents(std::mt19937& rng)
+{
+    static constexpr char const* words[]{
+        "fn",
+        "let",
+        "var",
+        "return",
+        "vec4f",
+        "texture",
+        "sampler",
+        "uniform",
+        "@group(0)",
+        "@binding(1)",
+        "position",
+        "normal",
+    };
+
+    usize const size = std::uniform_int_distribution<usize>{min_asset_size, max_asset_size}(rng);
+    std::uniform_int_distribution<usize> pick{0, std::size(words) - 1};
+
+    std::string result{};
+    while (result.size() < size)
+    {
+        result += words[pick(rng)];
+        result += (rng() % 8 == 0) ? '\n' : ' ';
+    }
+    result.resize(size);
+
+    return result;
+}
+
+// Writes each asset as a loose file and returns them as pack sources
+std::vector<AssetPackSource> write_loose_files(std::filesystem::path const& dir)
+{
+    std::vector<AssetPackSource> result{};
+    result.reserve(asset_count);
+    std::mt19937 rng{1};
+
+    for (usize i = 0; i < asset_count; ++i)
+    {
+        std::string const name = fmt::format("assets/{:03}/{:05}.txt", i / assets_per_dir, i);
+        std::filesystem::path const path = dir / name;
+        std::filesystem::create_directories(path.parent_path());
+
+        std::string const contents = make_contents(rng);
+        std::FILE* const file = std::fopen(path.string().c_str(), "wb");
+        assert(file);
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+
+        result.push_back({name, path.string(), true});
+    }
+
+    return result;
+}
+
+// Reads every asset in the given order and returns a checksum of their contents so that all bytes
+// are touched
+u64 load(
+    std::filesystem::path const& dir,
+    std::filesystem::path const& pack_path,
+    std::vector<std::string> const& names,
+    Method const method)
+{
+    u64 result = 0;
+    auto const add = [&](std::span<u8 const> const data) {
+        for (u8 const b : data)
+            result = result * 31 + b;
+    };
+
+    if (method == Method::LooseFiles)
+    {
+        // Baseline: what the runtime did with copied assets, one open per asset
+        std::vector<u8> buffer{};
+        for (std::string const& name : names)
+        {
+            std::FILE* const file = std::fopen((dir / name).string().c_str(), "rb");
+            assert(file);
+
+            std::fseek(file, 0, SEEK_END);
+            buffer.resize(usize(std::ftell(file)));
+            std::fseek(file, 0, SEEK_SET);
+            [[maybe_unused]] usize const n = std::fread(buffer.data(), 1, buffer.size(), file);
+            assert(n == buffer.size());
+            std::fclose(file);
+
+            add(buffer);
+        }
+    }
+    else
+    {
+        AssetPack pack = AssetPack::make(pack_path.string().c_str());
+        assert(pack.is_valid());
+        auto const drop_pack = defer([&]() { AssetPack::release(pack); });
+
+        std::vector<u8> buffer{};
+        for (std::string const& name : names)
+        {
+            AssetPackEntry const* const entry = pack.find(name);
+            assert(entry);
+            add(pack.read(*entry, buffer));
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
+void run_asset_pack_benchmark(GpuContext const& /*gpu*/)
+{
+    std::filesystem::path const dir =
+        std::filesystem::temp_directory_path() / "wgpu-sandbox-bench-assets";
+    std::filesystem::path const pack_paths[]{dir / "stored.pack", dir / "compressed.pack"};
+    auto const drop_dir = defer([&]() { std::filesystem::remove_all(dir); });
+
+    std::vector<AssetPackSource> sources{};
+    {
+        Stopwatch const timer{};
+        sources = write_loose_files(dir);
+        fmt::println("\tWrote {} loose files in {:.1f} ms", sources.size(), timer.wall_ms());
+    }
+
+    u64 loose_size = 0;
+    for (AssetPackSource const& src : sources)
+        loose_size += std::filesystem::file_size(src.path);
+
+    for (usize i = 0; i < 2; ++i)
+    {
+        bool const compress = (i == 1);
+        for (AssetPackSource& src : sources)
+            src.compress = compress;
+
+        // NOTE(dr): Packs are compressed at build time so use a fast level to keep setup short
+        Stopwatch const timer{};
+        if (!write_asset_pack(pack_paths[i].string().c_str(), sources, {.compression_level = 3}))
+        {
+            fmt::println("\tSkipped: couldn't write {}", pack_paths[i].string());
+            return;
+        }
+
+        fmt::println(
+            "\tWrote {} pack in {:.1f} ms ({:.1f} KB from {:.1f} KB)",
+            compress ? "compressed" : "stored",
+            timer.wall_ms(),
+            f64(std::filesystem::file_size(pack_paths[i])) / 1024.0,
+            f64(loose_size) / 1024.0);
+    }
+
+    // Look assets up in a different order than they're stored
+    std::vector<std::string> names{};
+    names.reserve(sources.size());
+    for (AssetPackSource const& src : sources)
+        names.push_back(src.name);
+    std::shuffle(names.begin(), names.end(), std::mt19937{2});
+
+    // NOTE(dr): Files were just written so they're likely in the page cache. This measures the
+    // per-asset cost of opening and reading rather than disk throughput.
+    fmt::println(
+        "\t{:<24} {:>14} {:>14} {:>16}",
+        "method",
+        "load (ms)",
+        "cpu (ms)",
+        "per asset (us)");
+
+    u64 expected_checksum = 0;
+    for (Method const method : {Method::LooseFiles, Method::Pack, Method::PackCompressed})
+    {
+        std::filesystem::path const& pack_path =
+            pack_paths[(method == Method::PackCompressed) ? 1 : 0];
+
+        f64 wall_ms = 0.0;
+        f64 cpu_ms = 0.0;
+
+        for (usize i = 0; i < run_count; ++i)
+        {
+            Stopwatch const timer{};
+            u64 const checksum = load(dir, pack_path, names, method);
+            wall_ms += timer.wall_ms();
+            cpu_ms += timer.cpu_ms();
+
+            if (method == Method::LooseFiles && i == 0)
+                expected_checksum = checksum;
+            else if (checksum != expected_checksum)
+                fmt::println("\t{}: contents don't match loose files", to_string(method));
+        }
+
+        fmt::println(
+            "\t{:<24} {:>14.2f} {:>14.2f} {:>16.2f}",
+            to_string(method),
+            wall_ms / run_count,
+            cpu_ms / run_count,
+            1000.0 * wall_ms / (run_count * names.size()));
+    }
+}
+
+} // namespace wgpu::sandbox
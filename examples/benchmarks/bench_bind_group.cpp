@@ -0,0 +1,138 @@
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_bind_group_cache.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize buffer_count = 64;
+constexpr usize rebind_count = 100'000;
+constexpr u64 buffer_size = 256;
+
+WGPUBindGroupLayout make_bind_group_layout(WGPUDevice const device)
+{
+    WGPUBindGroupLayoutEntry const entries[]{
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer{.type = WGPUBufferBindingType_Storage},
+        },
+    };
+    WGPUBindGroupLayoutDescriptor const desc{
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroupLayout(device, &desc);
+}
+
+WGPUBindGroupDescriptor make_bind_group_desc(
+    WGPUBindGroupLayout const layout,
+    WGPUBindGroupEntry& entry,
+    WGPUBuffer const buffer)
+{
+    entry = {
+        .binding = 0,
+        .buffer = buffer,
+        .size = buffer_size,
+    };
+    return {
+        .layout = layout,
+        .entryCount = 1,
+        .entries = &entry,
+    };
+}
+
+// Re-creates the bind group on every rebind
+f64 run_uncached(
+    WGPUDevice const device,
+    WGPUBindGroupLayout const layout,
+    std::vector<WGPUBuffer> const& buffers)
+{
+    std::minstd_rand rng{1};
+    Stopwatch const timer{};
+
+    for (usize i = 0; i < rebind_count; ++i)
+    {
+        WGPUBindGroupEntry entry;
+        WGPUBindGroupDescriptor const desc =
+            make_bind_group_desc(layout, entry, buffers[rng() % buffers.size()]);
+
+        WGPUBindGroup const bind_group = wgpuDeviceCreateBindGroup(device, &desc);
+        wgpuBindGroupRelease(bind_group);
+    }
+
+    return timer.wall_ms();
+}
+
+// Looks up the bind group in the cache on every rebind
+f64 run_cached(
+    BindGroupCache& cache,
+    WGPUBindGroupLayout const layout,
+    std::vector<WGPUBuffer> const& buffers)
+{
+    std::minstd_rand rng{1};
+    Stopwatch const timer{};
+
+    for (usize i = 0; i < rebind_count; ++i)
+    {
+        WGPUBindGroupEntry entry;
+        WGPUBindGroupDescriptor const desc =
+            make_bind_group_desc(layout, entry, buffers[rng() % buffers.size()]);
+
+        WGPUBindGroup const bind_group = cache.get(desc);
+        wgpuBindGroupRelease(bind_group);
+    }
+
+    return timer.wall_ms();
+}
+
+} // namespace
+
+void run_bind_group_benchmark(GpuContext const& gpu)
+{
+    WGPUBindGroupLayout const layout = make_bind_group_layout(gpu.device);
+    auto const drop_layout = defer([=]() { wgpuBindGroupLayoutRelease(layout); });
+
+    std::vector<WGPUBuffer> buffers(buffer_count);
+    for (WGPUBuffer& buf : buffers)
+    {
+        WGPUBufferDescriptor const desc{
+            .usage = WGPUBufferUsage_Storage,
+            .size = buffer_size,
+        };
+        buf = wgpuDeviceCreateBuffer(gpu.device, &desc);
+    }
+
+    BindGroupCache cache = BindGroupCache::make(gpu.device);
+    auto const drop_cache = defer([&]() { BindGroupCache::release(cache); });
+
+    f64 const uncached_ms = run_uncached(gpu.device, layout, buffers);
+    f64 const cached_ms = run_cached(cache, layout, buffers);
+
+    // Bind groups that refer to a buffer are dropped from the cache before it's released
+    for (WGPUBuffer const buf : buffers)
+        cache.release_resource(buf);
+
+    fmt::println("\t{:<16} {:>12} {:>12}", "strategy", "rebind (ms)", "creates");
+    fmt::println("\t{:<16} {:>12.2f} {:>12}", "create per bind", uncached_ms, rebind_count);
+    fmt::println("\t{:<16} {:>12.2f} {:>12}", "cache", cached_ms, cache.stats.misses);
+    fmt::println(
+        "\n\tcache hits: {}, invalidated on release: {}",
+        cache.stats.hits,
+        cache.stats.invalidations);
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,223 @@
+#include <cassert>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_bundle_cache.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_uniform_ring.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+#include "box_scene.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 box_count = 10'000;
+constexpr u32 grid_size = 100;
+constexpr usize frame_count = 60;
+constexpr u32 target_size = 512;
+
+struct Renderer
+{
+    WGPUBindGroupLayout bind_layout;
+    WGPURenderPipeline pipeline;
+    UniformRing uniform_ring;
+    WGPUBindGroup bind_group;
+    RenderBundleCache bundles;
+
+    static Renderer make(WGPUDevice const device, BoxScene const& scene)
+    {
+        Renderer result{};
+        result.bind_layout = make_box_bind_group_layout(device, true);
+        result.pipeline = make_box_pipeline(device, result.bind_layout);
+        assert(result.pipeline);
+
+        result.uniform_ring = UniformRing::make(device, box_count, sizeof(BoxUniforms));
+        result.bind_group = make_box_bind_group(
+            device,
+            result.bind_layout,
+            scene,
+            result.uniform_ring.buffer);
+
+        result.bundles = RenderBundleCache::make(
+            device,
+            &box_color_format,
+            1,
+            box_depth_format,
+            result.uniform_ring.frame_count);
+
+        return result;
+    }
+
+    static void release(Renderer& renderer)
+    {
+        RenderBundleCache::release(renderer.bundles);
+        wgpuBindGroupRelease(renderer.bind_group);
+        UniformRing::release(renderer.uniform_ring);
+        wgpuRenderPipelineRelease(renderer.pipeline);
+        wgpuBindGroupLayoutRelease(renderer.bind_layout);
+        renderer = {};
+    }
+
+    void render_frame(
+        WGPUDevice const device,
+        BoxScene const& scene,
+        OffscreenTarget const& target,
+        usize const frame,
+        bool const use_cache)
+    {
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+        // Uniforms change every frame in either case
+        u32 const base_offset = uniform_ring.reserve(box_count, sizeof(BoxUniforms));
+        u32 const stride = u32(uniform_ring.get_stride(sizeof(BoxUniforms)));
+
+        for (u32 i = 0; i < box_count; ++i)
+        {
+            BoxUniforms uniforms;
+            get_box_transform(i, grid_size, frame, uniforms);
+            uniform_ring.write(base_offset + i * stride, uniforms);
+        }
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        WGPURenderPassEncoder const pass = begin_box_pass(cmd_encoder, target);
+
+        if (use_cache)
+        {
+            // Draws only depend on the uniform region so the key is just its offset
+            WGPURenderBundle const bundle = bundles.get(
+                uniform_ring.frame_index,
+                base_offset,
+                [&](WGPURenderBundleEncoder const encoder) {
+                    wgpuRenderBundleEncoderSetPipeline(encoder, pipeline);
+                    wgpuRenderBundleEncoderSetVertexBuffer(
+                        encoder,
+                        0,
+                        scene.vertices,
+                        0,
+                        wgpuBufferGetSize(scene.vertices));
+                    wgpuRenderBundleEncoderSetIndexBuffer(
+                        encoder,
+                        scene.indices,
+                        WGPUIndexFormat_Uint16,
+                        0,
+                        wgpuBufferGetSize(scene.indices));
+
+                    for (u32 i = 0; i < box_count; ++i)
+                    {
+                        u32 const offset = base_offset + i * stride;
+                        wgpuRenderBundleEncoderSetBindGroup(encoder, 0, bind_group, 1, &offset);
+                        wgpuRenderBundleEncoderDrawIndexed(
+                            encoder,
+                            scene.index_count,
+                            1,
+                            0,
+                            0,
+                            0);
+                    }
+                });
+            wgpuRenderPassEncoderExecuteBundles(pass, 1, &bundle);
+        }
+        else
+        {
+            wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+            wgpuRenderPassEncoderSetVertexBuffer(
+                pass,
+                0,
+                scene.vertices,
+                0,
+                wgpuBufferGetSize(scene.vertices));
+            wgpuRenderPassEncoderSetIndexBuffer(
+                pass,
+                scene.indices,
+                WGPUIndexFormat_Uint16,
+                0,
+                wgpuBufferGetSize(scene.indices));
+
+            for (u32 i = 0; i < box_count; ++i)
+            {
+                u32 const offset = base_offset + i * stride;
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, bind_group, 1, &offset);
+                wgpuRenderPassEncoderDrawIndexed(pass, scene.index_count, 1, 0, 0, 0);
+            }
+        }
+
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+        uniform_ring.flush(queue);
+        wgpuQueueSubmit(queue, 1, &cmds);
+    }
+};
+
+} // namespace
+
+void run_bundle_cache_benchmark(GpuContext const& gpu)
+{
+    BoxScene scene = BoxScene::make(gpu.device);
+    auto const drop_scene = defer([&]() { BoxScene::release(scene); });
+
+    OffscreenTarget target = OffscreenTarget::make(
+        gpu.device,
+        target_size,
+        target_size,
+        box_color_format,
+        box_depth_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    fmt::println("\t{} boxes per frame, uniforms written every frame", box_count);
+    fmt::println(
+        "\t{:<24} {:>14} {:>14} {:>10}",
+        "method",
+        "encode (ms)",
+        "first (ms)",
+        "misses");
+
+    for (bool const use_cache : {false, true})
+    {
+        Renderer renderer = Renderer::make(gpu.device, scene);
+        auto const drop_renderer = defer([&]() { Renderer::release(renderer); });
+
+        f64 first_ms = 0.0;
+        f64 encode_ms = 0.0;
+
+        for (usize i = 0; i < frame_count; ++i)
+        {
+            Stopwatch const timer{};
+            renderer.render_frame(gpu.device, scene, target, i, use_cache);
+            f64 const dt = timer.wall_ms();
+
+            // Frames that record a bundle for the first time are reported separately
+            if (i < renderer.uniform_ring.frame_count)
+                first_ms += dt;
+            else
+                encode_ms += dt;
+
+            // Keep GPU work out of the measurement
+            poll_device(gpu.device, true);
+        }
+
+        u32 const warm_count = renderer.uniform_ring.frame_count;
+        fmt::println(
+            "\t{:<24} {:>14.3f} {:>14.3f} {:>10}",
+            use_cache ? "cached bundle" : "direct",
+            encode_ms / (frame_count - warm_count),
+            first_ms / warm_count,
+            renderer.bundles.stats.misses);
+    }
+}
+
+} // namespace wgpu::sandbox
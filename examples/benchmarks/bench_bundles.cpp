@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <task_pool.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_render_bundles.hpp>
+#include <wgpu_uniform_ring.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+#include "box_scene.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 box_count = 40'000;
+constexpr u32 grid_size = 200;
+constexpr usize frame_count = 30;
+constexpr u32 target_size = 512;
+
+struct Renderer
+{
+    WGPUBindGroupLayout bind_layout;
+    WGPURenderPipeline pipeline;
+    UniformRing uniform_ring;
+    WGPUBindGroup bind_group;
+
+    static Renderer make(WGPUDevice const device, BoxScene const& scene)
+    {
+        Renderer result{};
+        result.bind_layout = make_box_bind_group_layout(device, true);
+        result.pipeline = make_box_pipeline(device, result.bind_layout);
+        assert(result.pipeline);
+
+        result.uniform_ring = UniformRing::make(device, box_count, sizeof(BoxUniforms));
+        result.bind_group = make_box_bind_group(
+            device,
+            result.bind_layout,
+            scene,
+            result.uniform_ring.buffer);
+
+        return result;
+    }
+
+    static void release(Renderer& renderer)
+    {
+        wgpuBindGroupRelease(renderer.bind_group);
+        UniformRing::release(renderer.uniform_ring);
+        wgpuRenderPipelineRelease(renderer.pipeline);
+        wgpuBindGroupLayoutRelease(renderer.bind_layout);
+        renderer = {};
+    }
+
+    // Encodes all draws into the pass on the calling thread
+    void render_frame_direct(
+        WGPUDevice const device,
+        BoxScene const& scene,
+        OffscreenTarget const& target,
+        usize const frame)
+    {
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        WGPURenderPassEncoder const pass = begin_box_pass(cmd_encoder, target);
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        wgpuRenderPassEncoderSetVertexBuffer(
+            pass,
+            0,
+            scene.vertices,
+            0,
+            wgpuBufferGetSize(scene.vertices));
+        wgpuRenderPassEncoderSetIndexBuffer(
+            pass,
+            scene.indices,
+            WGPUIndexFormat_Uint16,
+            0,
+            wgpuBufferGetSize(scene.indices));
+
+        for (u32 i = 0; i < box_count; ++i)
+        {
+            BoxUniforms uniforms;
+            get_box_transform(i, grid_size, frame, uniforms);
+
+            u32 const offset = uniform_ring.push(uniforms);
+            wgpuRenderPassEncoderSetBindGroup(pass, 0, bind_group, 1, &offset);
+            wgpuRenderPassEncoderDrawIndexed(pass, scene.index_count, 1, 0, 0, 0);
+        }
+
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+        uniform_ring.flush(queue);
+        wgpuQueueSubmit(queue, 1, &cmds);
+    }
+
+    // Records draws into one bundle per thread and executes them in a single pass
+    void render_frame_bundles(
+        WGPUDevice const device,
+        TaskPool& pool,
+        BoxScene const& scene,
+        OffscreenTarget const& target,
+        usize const frame)
+    {
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+        // Reserve uniforms up front so that each task can write its own slice
+        u32 const base_offset = uniform_ring.reserve(box_count, sizeof(BoxUniforms));
+        u32 const stride = u32(uniform_ring.get_stride(sizeof(BoxUniforms)));
+
+        WGPURenderBundleEncoderDescriptor const bundle_desc{
+            .colorFormatCount = 1,
+            .colorFormats = &box_color_format,
+            .depthStencilFormat = box_depth_format,
+            .sampleCount = 1,
+        };
+        std::vector<WGPURenderBundle> bundles(pool.get_thread_count());
+        auto const drop_bundles = defer([&]() {
+            for (WGPURenderBundle const bundle : bundles)
+                wgpuRenderBundleRelease(bundle);
+        });
+
+        record_render_bundles(
+            pool,
+            device,
+            bundle_desc,
+            box_count,
+            bundles,
+            [&](WGPURenderBundleEncoder const encoder, usize const begin, usize const end) {
+                wgpuRenderBundleEncoderSetPipeline(encoder, pipeline);
+                wgpuRenderBundleEncoderSetVertexBuffer(
+                    encoder,
+                    0,
+                    scene.vertices,
+                    0,
+                    wgpuBufferGetSize(scene.vertices));
+                wgpuRenderBundleEncoderSetIndexBuffer(
+                    encoder,
+                    scene.indices,
+                    WGPUIndexFormat_Uint16,
+                    0,
+                    wgpuBufferGetSize(scene.indices));
+
+                for (usize i = begin; i < end; ++i)
+                {
+                    BoxUniforms uniforms;
+                    get_box_transform(u32(i), grid_size, frame, uniforms);
+
+                    u32 const offset = base_offset + u32(i) * stride;
+                    uniform_ring.write(offset, uniforms);
+                    wgpuRenderBundleEncoderSetBindGroup(encoder, 0, bind_group, 1, &offset);
+                    wgpuRenderBundleEncoderDrawIndexed(encoder, scene.index_count, 1, 0, 0, 0);
+                }
+            });
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        WGPURenderPassEncoder const pass = begin_box_pass(cmd_encoder, target);
+        wgpuRenderPassEncoderExecuteBundles(pass, bundles.size(), bundles.data());
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+        uniform_ring.flush(queue);
+        wgpuQueueSubmit(queue, 1, &cmds);
+    }
+};
+
+template <typename Func>
+f64 measure_encode_ms(WGPUDevice const device, Func&& render_frame)
+{
+    f64 total_ms = 0.0;
+
+    for (usize i = 0; i < frame_count; ++i)
+    {
+        Stopwatch const timer{};
+        render_frame(i);
+        total_ms += timer.wall_ms();
+
+        // Keep GPU work out of the measurement
+        poll_device(device, true);
+    }
+
+    return total_ms / frame_count;
+}
+
+std::vector<usize> get_thread_counts()
+{
+    usize const max_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<usize> result{};
+    for (usize n = 1; n < max_count; n *= 2)
+        result.push_back(n);
+
+    result.push_back(max_count);
+    return result;
+}
+
+} // namespace
+
+void run_bundles_benchmark(GpuContext const& gpu)
+{
+    BoxScene scene = BoxScene::make(gpu.device);
+    auto const drop_scene = defer([&]() { BoxScene::release(scene); });
+
+    OffscreenTarget target = OffscreenTarget::make(
+        gpu.device,
+        target_size,
+        target_size,
+        box_color_format,
+        box_depth_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    Renderer renderer = Renderer::make(gpu.device, scene);
+    auto const drop_renderer = defer([&]() { Renderer::release(renderer); });
+
+    fmt::println("\t{} boxes per frame", box_count);
+    fmt::println("\t{:<24} {:>14} {:>10}", "method", "encode (ms)", "speedup");
+
+    f64 const direct_ms = measure_encode_ms(gpu.device, [&](usize const frame) {
+        renderer.render_frame_direct(gpu.device, scene, target, frame);
+    });
+    fmt::println("\t{:<24} {:>14.3f} {:>9.2f}x", "direct, 1 thread", direct_ms, 1.0);
+
+    for (usize const thread_count : get_thread_counts())
+    {
+        TaskPool pool = TaskPool::make(thread_count);
+        auto const drop_pool = defer([&]() { TaskPool::release(pool); });
+
+        f64 const bundles_ms = measure_encode_ms(gpu.device, [&](usize const frame) {
+            renderer.render_frame_bundles(gpu.device, pool, scene, target, frame);
+        });
+
+        fmt::println(
+            "\t{:<24} {:>14.3f} {:>9.2f}x",
+            fmt::format("bundles, {} thread(s)", pool.get_thread_count()),
+            bundles_ms,
+            direct_ms / bundles_ms);
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+#include <dr/memory.hpp>
+
+#include <wgpu_culling.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+#include "box_scene.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+// Transforms are looked up through the list of visible instances
+constexpr char const* shader_src = R"(
+struct Instance {
+    local_to_world: mat4x4f,
+    bounds: vec4f,
+};
+
+@group(0) @binding(0) var<uniform> world_to_clip: mat4x4f;
+@group(0) @binding(1) var<storage, read> instances: array<Instance>;
+@group(0) @binding(2) var<storage, read> visible: array<u32>;
+
+struct VertexOut {
+    @builtin(position) position: vec4f,
+    @location(0) tex_coords: vec2f,
+};
+
+@vertex
+fn vs_main(
+    @builtin(instance_index) instance_index: u32,
+    @location(0) position: vec3f,
+    @location(1) tex_coords: vec2f,
+) -> VertexOut {
+    let local_to_world = instances[visible[instance_index]].local_to_world;
+    return VertexOut(world_to_clip * local_to_world * vec4f(position, 1.0), tex_coords);
+}
+
+@fragment
+fn fs_main(@location(0) tex_coords: vec2f) -> @location(0) vec4f {
+    return vec4f(tex_coords, 0.5, 1.0);
+}
+)";
+
+constexpr u32 instance_counts[]{1'000, 10'000, 100'000};
+constexpr usize frame_count = 30;
+constexpr u32 target_size = 512;
+constexpr f32 spacing = 1.5f;
+
+enum class Strategy : u8
+{
+    CpuCulling,
+    GpuCulling,
+};
+
+char const* to_string(Strategy const value)
+{
+    static constexpr char const* names[]{
+        "CPU cull, draw per object",
+        "GPU cull, indirect draw",
+    };
+    return names[int(value)];
+}
+
+WGPUBindGroupLayout make_bind_group_layout(WGPUDevice const device)
+{
+    WGPUBindGroupLayoutEntry const entries[]{
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer{
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = sizeof(f32[16]),
+            },
+        },
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer{.type = WGPUBufferBindingType_ReadOnlyStorage},
+        },
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer{.type = WGPUBufferBindingType_ReadOnlyStorage},
+        },
+    };
+    WGPUBindGroupLayoutDescriptor const desc{
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroupLayout(device, &desc);
+}
+
+WGPUBindGroup make_bind_group(
+    WGPUDevice const device,
+    WGPUBindGroupLayout const layout,
+    WGPUBuffer const uniforms,
+    WGPUBuffer const instances,
+    WGPUBuffer const visible)
+{
+    WGPUBindGroupEntry const entries[]{
+        {
+            .binding = 0,
+            .buffer = uniforms,
+            .size = sizeof(f32[16]),
+        },
+        {
+            .binding = 1,
+            .buffer = instances,
+            .size = WGPU_WHOLE_SIZE,
+        },
+        {
+            .binding = 2,
+            .buffer = visible,
+            .size = WGPU_WHOLE_SIZE,
+        },
+    };
+    WGPUBindGroupDescriptor const desc{
+        .layout = layout,
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroup(device, &desc);
+}
+
+WGPURenderPipeline make_pipeline(WGPUDevice const device, WGPUBindGroupLayout const bind_layout)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUPipelineLayoutDescriptor const layout_desc{
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = &bind_layout,
+    };
+    WGPUPipelineLayout const layout = wgpuDeviceCreatePipelineLayout(device, &layout_desc);
+    auto const drop_layout = defer([=]() { wgpuPipelineLayoutRelease(layout); });
+
+    WGPUVertexAttribute const vert_attrs[]{
+        {
+            .format = WGPUVertexFormat_Float32x3,
+            .offset = 0,
+            .shaderLocation = 0,
+        },
+        {
+            .format = WGPUVertexFormat_Float32x2,
+            .offset = sizeof(f32[3]),
+            .shaderLocation = 1,
+        },
+    };
+    WGPUVertexBufferLayout const vert_buf_layout{
+        .stepMode = WGPUVertexStepMode_Vertex,
+        .arrayStride = sizeof(f32[5]),
+        .attributeCount = size(vert_attrs),
+        .attributes = vert_attrs,
+    };
+
+    WGPUDepthStencilState const depth_state{
+        .format = box_depth_format,
+        .depthWriteEnabled = WGPUOptionalBool_True,
+        .depthCompare = WGPUCompareFunction_LessEqual,
+    };
+    WGPUColorTargetState const color_targ{
+        .format = box_color_format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState const frag_state{
+        .module = shader,
+        .entryPoint{"fs_main", WGPU_STRLEN},
+        .targetCount = 1,
+        .targets = &color_targ,
+    };
+    WGPURenderPipelineDescriptor const pipe_desc{
+        .layout = layout,
+        .vertex{
+            .module = shader,
+            .entryPoint{"vs_main", WGPU_STRLEN},
+            .bufferCount = 1,
+            .buffers = &vert_buf_layout,
+        },
+        .primitive{
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .frontFace = WGPUFrontFace_CCW,
+            .cullMode = WGPUCullMode_None,
+        },
+        .depthStencil = &depth_state,
+        .multisample{
+            .count = 1,
+            .mask = ~0u,
+        },
+        .fragment = &frag_state,
+    };
+    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+}
+
+// Lays unit boxes out on a square grid in the xy plane
+std::vector<GpuCuller::Instance> make_instances(u32 const count, u32 const grid_size)
+{
+    std::vector<GpuCuller::Instance> result(count);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        f32 const x = spacing * f32(i % grid_size);
+        f32 const y = spacing * f32(i / grid_size);
+
+        GpuCuller::Instance& inst = result[i];
+        inst = {};
+        inst.local_to_world[0] = 1.0f;
+        inst.local_to_world[5] = 1.0f;
+        inst.local_to_world[10] = 1.0f;
+        inst.local_to_world[12] = x;
+        inst.local_to_world[13] = y;
+        inst.local_to_world[15] = 1.0f;
+
+        inst.bounds[0] = x + 0.5f;
+        inst.bounds[1] = y + 0.5f;
+        inst.bounds[2] = 0.5f;
+        inst.bounds[3] = 0.5f * std::sqrt(3.0f);
+    }
+
+    return result;
+}
+
+// Orthographic view of a quarter of the grid that pans a little each frame
+void get_world_to_clip(u32 const grid_size, usize const frame, f32 result[16])
+{
+    f32 const extent = spacing * f32(grid_size);
+    f32 const scale = 4.0f / extent;
+    f32 const center = 0.25f * extent + 0.01f * extent * f32(frame % 50);
+
+    std::fill_n(result, 16, 0.0f);
+    result[0] = scale;
+    result[5] = scale;
+    result[10] = 0.5f;
+    result[12] = -center * scale;
+    result[13] = -center * scale;
+    result[14] = 0.25f;
+    result[15] = 1.0f;
+}
+
+struct Renderer
+{
+    WGPUBindGroupLayout bind_layout;
+    WGPURenderPipeline pipeline;
+    WGPUBuffer uniforms;
+    GpuCuller culler;
+    std::vector<GpuCuller::Instance> instances;
+    u32 grid_size;
+
+    // Used by CpuCulling. Maps each instance to itself.
+    WGPUBuffer identity;
+    WGPUBindGroup identity_bind_group;
+
+    // Used by GpuCulling
+    WGPUBindGroup culled_bind_group;
+
+    static Renderer make(WGPUDevice const device, u32 const instance_count)
+    {
+        Renderer result{};
+        result.bind_layout = make_bind_group_layout(device);
+        result.pipeline = make_pipeline(device, result.bind_layout);
+        assert(result.pipeline);
+
+        WGPUBufferDescriptor const uniforms_desc{
+            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+            .size = sizeof(f32[16]),
+        };
+        result.uniforms = wgpuDeviceCreateBuffer(device, &uniforms_desc);
+
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+        result.grid_size = u32(std::ceil(std::sqrt(f32(instance_count))));
+        result.instances = make_instances(instance_count, result.grid_size);
+        result.culler = GpuCuller::make(device, instance_count);
+        result.culler.set_instances(queue, result.instances.data(), instance_count);
+
+        std::vector<u32> indices(instance_count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        WGPUBufferDescriptor const identity_desc{
+            .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+            .size = indices.size() * sizeof(u32),
+        };
+        result.identity = wgpuDeviceCreateBuffer(device, &identity_desc);
+        wgpuQueueWriteBuffer(queue, result.identity, 0, indices.data(), identity_desc.size);
+
+        result.identity_bind_group = make_bind_group(
+            device,
+            result.bind_layout,
+            result.uniforms,
+            result.culler.instances,
+            result.identity);
+        result.culled_bind_group = make_bind_group(
+            device,
+            result.bind_layout,
+            result.uniforms,
+            result.culler.instances,
+            result.culler.visible);
+
+        return result;
+    }
+
+    static void release(Renderer& renderer)
+    {
+        wgpuBindGroupRelease(renderer.culled_bind_group);
+        wgpuBindGroupRelease(renderer.identity_bind_group);
+        wgpuBufferRelease(renderer.identity);
+        GpuCuller::release(renderer.culler);
+        wgpuBufferRelease(renderer.uniforms);
+        wgpuRenderPipelineRelease(renderer.pipeline);
+        wgpuBindGroupLayoutRelease(renderer.bind_layout);
+        renderer = {};
+    }
+
+    // Returns the number of draws issued from the CPU
+    u32 render_frame(
+        WGPUDevice const device,
+        BoxScene const& scene,
+        OffscreenTarget const& target,
+        usize const frame,
+        Strategy const strategy)
+    {
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+        f32 world_to_clip[16];
+        get_world_to_clip(grid_size, frame, world_to_clip);
+        wgpuQueueWriteBuffer(queue, uniforms, 0, world_to_clip, sizeof(world_to_clip));
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        if (strategy == Strategy::GpuCulling)
+            culler.cull(cmd_encoder, queue, world_to_clip, scene.index_count);
+
+        WGPURenderPassEncoder const pass = begin_box_pass(cmd_encoder, target);
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        wgpuRenderPassEncoderSetVertexBuffer(
+            pass,
+            0,
+            scene.vertices,
+            0,
+            wgpuBufferGetSize(scene.vertices));
+        wgpuRenderPassEncoderSetIndexBuffer(
+            pass,
+            scene.indices,
+            WGPUIndexFormat_Uint16,
+            0,
+            wgpuBufferGetSize(scene.indices));
+
+        u32 draw_count = 0;
+
+        if (strategy == Strategy::CpuCulling)
+        {
+            f32 planes[6][4];
+            get_frustum_planes(world_to_clip, planes);
+
+            wgpuRenderPassEncoderSetBindGroup(pass, 0, identity_bind_group, 0, nullptr);
+            for (u32 i = 0; i < instances.size(); ++i)
+            {
+                if (!is_sphere_visible(planes, instances[i].bounds))
+                    continue;
+
+                wgpuRenderPassEncoderDrawIndexed(pass, scene.index_count, 1, 0, 0, i);
+                ++draw_count;
+            }
+        }
+        else
+        {
+            wgpuRenderPassEncoderSetBindGroup(pass, 0, culled_bind_group, 0, nullptr);
+            culler.draw(pass);
+            ++draw_count;
+        }
+
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+        wgpuQueueSubmit(queue, 1, &cmds);
+
+        return draw_count;
+    }
+};
+
+} // namespace
+
+void run_culling_benchmark(GpuContext const& gpu)
+{
+    BoxScene scene = BoxScene::make(gpu.device);
+    auto const drop_scene = defer([&]() { BoxScene::release(scene); });
+
+    OffscreenTarget target = OffscreenTarget::make(
+        gpu.device,
+        target_size,
+        target_size,
+        box_color_format,
+        box_depth_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    fmt::println(
+        "\t{:<28} {:>10} {:>14} {:>12} {:>14}",
+        "strategy",
+        "instances",
+        "encode (ms)",
+        "CPU draws",
+        "frame (ms)");
+
+    for (u32 const instance_count : instance_counts)
+    {
+        Renderer renderer = Renderer::make(gpu.device, instance_count);
+        auto const drop_renderer = defer([&]() { Renderer::release(renderer); });
+
+        for (Strategy const strategy : {Strategy::CpuCulling, Strategy::GpuCulling})
+        {
+            f64 encode_ms = 0.0;
+            f64 frame_ms = 0.0;
+            u32 draw_count = 0;
+
+            for (usize i = 0; i < frame_count; ++i)
+            {
+                Stopwatch const timer{};
+                draw_count = renderer.render_frame(gpu.device, scene, target, i, strategy);
+                encode_ms += timer.wall_ms();
+
+                // Frame time includes waiting on the GPU
+                poll_device(gpu.device, true);
+                frame_ms += timer.wall_ms();
+            }
+
+            fmt::println(
+                "\t{:<28} {:>10} {:>14.3f} {:>12} {:>14.3f}",
+                to_string(strategy),
+                instance_count,
+                encode_ms / frame_count,
+                draw_count,
+                frame_ms / frame_count);
+        }
+    }
+}
+
+} // namespace wgpu::sandbox
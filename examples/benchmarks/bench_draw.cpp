@@ -0,0 +1,216 @@
+#include <cassert>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_offscreen.hpp>
+#include <wgpu_uniform_ring.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+#include "box_scene.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 box_count = 10'000;
+constexpr u32 grid_size = 100;
+constexpr usize frame_count = 30;
+constexpr u32 target_size = 512;
+
+enum class Strategy : u8
+{
+    BindGroupPerDraw,
+    DynamicOffset,
+};
+
+char const* to_string(Strategy const value)
+{
+    static constexpr char const* names[]{
+        "buffer + bind group per draw",
+        "uniform ring, dynamic offsets",
+    };
+    return names[int(value)];
+}
+
+struct Renderer
+{
+    Strategy strategy;
+    WGPUBindGroupLayout bind_layout;
+    WGPURenderPipeline pipeline;
+
+    // Used by BindGroupPerDraw
+    std::vector<WGPUBuffer> uniform_buffers;
+    std::vector<WGPUBindGroup> bind_groups;
+
+    // Used by DynamicOffset
+    UniformRing uniform_ring;
+    WGPUBindGroup ring_bind_group;
+
+    static Renderer make(WGPUDevice const device, BoxScene const& scene, Strategy const strategy)
+    {
+        Renderer result{};
+        result.strategy = strategy;
+        result.bind_layout =
+            make_box_bind_group_layout(device, strategy == Strategy::DynamicOffset);
+        result.pipeline = make_box_pipeline(device, result.bind_layout);
+        assert(result.pipeline);
+
+        if (strategy == Strategy::BindGroupPerDraw)
+        {
+            for (u32 i = 0; i < box_count; ++i)
+            {
+                WGPUBufferDescriptor const desc{
+                    .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(BoxUniforms),
+                };
+                WGPUBuffer const buffer = wgpuDeviceCreateBuffer(device, &desc);
+                result.uniform_buffers.push_back(buffer);
+                result.bind_groups.push_back(
+                    make_box_bind_group(device, result.bind_layout, scene, buffer));
+            }
+        }
+        else
+        {
+            result.uniform_ring = UniformRing::make(device, box_count, sizeof(BoxUniforms));
+            result.ring_bind_group = make_box_bind_group(
+                device,
+                result.bind_layout,
+                scene,
+                result.uniform_ring.buffer);
+        }
+
+        return result;
+    }
+
+    static void release(Renderer& renderer)
+    {
+        for (WGPUBindGroup const bind_group : renderer.bind_groups)
+            wgpuBindGroupRelease(bind_group);
+
+        for (WGPUBuffer const buffer : renderer.uniform_buffers)
+            wgpuBufferRelease(buffer);
+
+        if (renderer.ring_bind_group)
+        {
+            wgpuBindGroupRelease(renderer.ring_bind_group);
+            UniformRing::release(renderer.uniform_ring);
+        }
+
+        wgpuRenderPipelineRelease(renderer.pipeline);
+        wgpuBindGroupLayoutRelease(renderer.bind_layout);
+        renderer = {};
+    }
+
+    void render_frame(
+        WGPUDevice const device,
+        BoxScene const& scene,
+        OffscreenTarget const& target,
+        usize const frame)
+    {
+        WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        WGPURenderPassEncoder const pass = begin_box_pass(cmd_encoder, target);
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        wgpuRenderPassEncoderSetVertexBuffer(
+            pass,
+            0,
+            scene.vertices,
+            0,
+            wgpuBufferGetSize(scene.vertices));
+        wgpuRenderPassEncoderSetIndexBuffer(
+            pass,
+            scene.indices,
+            WGPUIndexFormat_Uint16,
+            0,
+            wgpuBufferGetSize(scene.indices));
+
+        for (u32 i = 0; i < box_count; ++i)
+        {
+            BoxUniforms uniforms;
+            get_box_transform(i, grid_size, frame, uniforms);
+
+            if (strategy == Strategy::BindGroupPerDraw)
+            {
+                wgpuQueueWriteBuffer(queue, uniform_buffers[i], 0, &uniforms, sizeof(uniforms));
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, bind_groups[i], 0, nullptr);
+            }
+            else
+            {
+                u32 const offset = uniform_ring.push(uniforms);
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, ring_bind_group, 1, &offset);
+            }
+
+            wgpuRenderPassEncoderDrawIndexed(pass, scene.index_count, 1, 0, 0, 0);
+        }
+
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+        if (strategy == Strategy::DynamicOffset)
+            uniform_ring.flush(queue);
+
+        wgpuQueueSubmit(queue, 1, &cmds);
+    }
+};
+
+} // namespace
+
+void run_draw_benchmark(GpuContext const& gpu)
+{
+    BoxScene scene = BoxScene::make(gpu.device);
+    auto const drop_scene = defer([&]() { BoxScene::release(scene); });
+
+    OffscreenTarget target = OffscreenTarget::make(
+        gpu.device,
+        target_size,
+        target_size,
+        box_color_format,
+        box_depth_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    fmt::println("\t{} boxes per frame", box_count);
+    fmt::println("\t{:<32} {:>14} {:>14}", "strategy", "encode (ms)", "setup (ms)");
+
+    for (Strategy const strategy : {Strategy::BindGroupPerDraw, Strategy::DynamicOffset})
+    {
+        Stopwatch const setup_timer{};
+        Renderer renderer = Renderer::make(gpu.device, scene, strategy);
+        auto const drop_renderer = defer([&]() { Renderer::release(renderer); });
+        f64 const setup_ms = setup_timer.wall_ms();
+
+        f64 encode_ms = 0.0;
+
+        for (usize i = 0; i < frame_count; ++i)
+        {
+            Stopwatch const timer{};
+            renderer.render_frame(gpu.device, scene, target, i);
+            encode_ms += timer.wall_ms();
+
+            // Keep GPU work out of the measurement
+            poll_device(gpu.device, true);
+        }
+
+        fmt::println(
+            "\t{:<32} {:>14.3f} {:>14.2f}",
+            to_string(strategy),
+            encode_ms / frame_count,
+            setup_ms);
+    }
+}
+
+} // namespace wgpu::sandbox
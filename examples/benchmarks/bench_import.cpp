@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <scene_importer.hpp>
+#include <task_pool.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 grid_size = 512;
+constexpr u32 gltf_mesh_count = 16;
+
+using Path = std::filesystem::path;
+
+// Writes a grid as an OBJ file with one quad per face
+bool write_obj(Path const& path)
+{
+    std::FILE* const file = std::fopen(path.string().c_str(), "w");
+    if (!file)
+        return false;
+
+    auto const drop_file = defer([=]() { std::fclose(file); });
+
+    for (u32 i = 0; i <= grid_size; ++i)
+    {
+        for (u32 j = 0; j <= grid_size; ++j)
+        {
+            f32 const u = f32(j) / grid_size;
+            f32 const v = f32(i) / grid_size;
+            fmt::print(file, "v {} {} 0\nvt {} {}\nvn 0 0 1\n", u, v, u, v);
+        }
+    }
+
+    for (u32 i = 0; i < grid_size; ++i)
+    {
+        for (u32 j = 0; j < grid_size; ++j)
+        {
+            u32 const v0 = i * (grid_size + 1) + j + 1;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + grid_size + 1;
+            u32 const v3 = v2 + 1;
+            fmt::print(file, "f {0}/{0}/{0} {1}/{1}/{1} {3}/{3}/{3} {2}/{2}/{2}\n", v0, v1, v2, v3);
+        }
+    }
+
+    return true;
+}
+
+// Writes the same grid split into several glTF meshes, each with a node of its own. Meshes share
+// one external buffer.
+bool write_gltf(Path const& path, Path const& bin_path)
+{
+    u32 const rows = grid_size / gltf_mesh_count;
+    u32 const vertex_count = (rows + 1) * (grid_size + 1);
+    u32 const index_count = rows * grid_size * 6;
+
+    std::vector<f32> positions{};
+    std::vector<f32> tex_coords{};
+    std::vector<u32> indices{};
+
+    for (u32 i = 0; i <= rows; ++i)
+    {
+        for (u32 j = 0; j <= grid_size; ++j)
+        {
+            f32 const u = f32(j) / grid_size;
+            f32 const v = f32(i) / grid_size;
+            positions.insert(positions.end(), {u, v, 0.0f});
+            tex_coords.insert(tex_coords.end(), {u, v});
+        }
+    }
+
+    for (u32 i = 0; i < rows; ++i)
+    {
+        for (u32 j = 0; j < grid_size; ++j)
+        {
+            u32 const v0 = i * (grid_size + 1) + j;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + grid_size + 1;
+            u32 const v3 = v2 + 1;
+            indices.insert(indices.end(), {v0, v1, v3, v0, v3, v2});
+        }
+    }
+
+    // Every mesh refers to the same data so only one copy is stored
+    {
+        std::FILE* const file = std::fopen(bin_path.string().c_str(), "wb");
+        if (!file)
+            return false;
+
+        auto const drop_file = defer([=]() { std::fclose(file); });
+        std::fwrite(positions.data(), sizeof(f32), positions.size(), file);
+        std::fwrite(tex_coords.data(), sizeof(f32), tex_coords.size(), file);
+        std::fwrite(indices.data(), sizeof(u32), indices.size(), file);
+    }
+
+    std::FILE* const file = std::fopen(path.string().c_str(), "w");
+    if (!file)
+        return false;
+
+    auto const drop_file = defer([=]() { std::fclose(file); });
+
+    usize const pos_size = positions.size() * sizeof(f32);
+    usize const uv_size = tex_coords.size() * sizeof(f32);
+    usize const index_size = indices.size() * sizeof(u32);
+
+    fmt::print(file, R"({{"asset": {{"version": "2.0"}},)");
+    fmt::print(
+        file,
+        R"("buffers": [{{"uri": "{}", "byteLength": {}}}],)",
+        bin_path.filename().string(),
+        pos_size + uv_size + index_size);
+    fmt::print(
+        file,
+        R"("bufferViews": [{{"buffer": 0, "byteLength": {}}}, )"
+        R"({{"buffer": 0, "byteOffset": {}, "byteLength": {}}}, )"
+        R"({{"buffer": 0, "byteOffset": {}, "byteLength": {}}}],)",
+        pos_size,
+        pos_size,
+        uv_size,
+        pos_size + uv_size,
+        index_size);
+    fmt::print(
+        file,
+        R"("accessors": [)"
+        R"({{"bufferView": 0, "componentType": 5126, "count": {0}, "type": "VEC3", )"
+        R"("min": [0, 0, 0], "max": [1, 1, 0]}}, )"
+        R"({{"bufferView": 1, "componentType": 5126, "count": {0}, "type": "VEC2"}}, )"
+        R"({{"bufferView": 2, "componentType": 5125, "count": {1}, "type": "SCALAR"}}],)",
+        vertex_count,
+        index_count);
+
+    fmt::print(file, R"("meshes": [)");
+    for (u32 i = 0; i < gltf_mesh_count; ++i)
+    {
+        fmt::print(
+            file,
+            R"({{"primitives": [{{"attributes": {{"POSITION": 0, "TEXCOORD_0": 1}}, )"
+            R"("indices": 2}}]}}{})",
+            (i + 1 < gltf_mesh_count) ? ", " : "");
+    }
+
+    fmt::print(file, R"(], "nodes": [)");
+    for (u32 i = 0; i < gltf_mesh_count; ++i)
+    {
+        fmt::print(
+            file,
+            R"({{"mesh": {}, "translation": [0, {}, 0]}}{})",
+            i,
+            f32(i * rows) / grid_size,
+            (i + 1 < gltf_mesh_count) ? ", " : "");
+    }
+
+    fmt::print(file, "]}}\n");
+    return true;
+}
+
+void print_row(char const* const format, usize const thread_count, ImportTimings const& t)
+{
+    fmt::println(
+        "\t{:<6} {:>8} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f}",
+        format,
+        thread_count,
+        t.read_ms,
+        t.mesh_ms,
+        t.optimize_ms,
+        t.total_ms);
+}
+
+} // namespace
+
+void run_import_benchmark(GpuContext const& /*gpu*/)
+{
+    Path const dir = std::filesystem::temp_directory_path();
+    Path const obj_path = dir / "wgpu-sandbox-bench.obj";
+    Path const gltf_path = dir / "wgpu-sandbox-bench.gltf";
+    Path const bin_path = dir / "wgpu-sandbox-bench.bin";
+    auto const drop_files = defer([&]() {
+        for (Path const& path : {obj_path, gltf_path, bin_path})
+            std::filesystem::remove(path);
+    });
+
+    if (!write_obj(obj_path) || !write_gltf(gltf_path, bin_path))
+    {
+        fmt::println("\tSkipped: couldn't write files to {}", dir.string());
+        return;
+    }
+
+    fmt::println(
+        "\t{}x{} grid, {:.1f} MB obj, {} glTF meshes",
+        grid_size,
+        grid_size,
+        f64(std::filesystem::file_size(obj_path)) / (1024.0 * 1024.0),
+        gltf_mesh_count);
+    fmt::println(
+        "\t{:<6} {:>8} {:>10} {:>10} {:>10} {:>10}",
+        "format",
+        "threads",
+        "read ms",
+        "mesh ms",
+        "opt ms",
+        "total ms");
+
+    usize const max_thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (usize thread_count = 1;; thread_count = std::min(thread_count * 2, max_thread_count))
+    {
+        TaskPool pool = TaskPool::make(thread_count);
+        auto const drop_pool = defer([&]() { TaskPool::release(pool); });
+
+        ImportedScene scene{};
+        if (import_obj(obj_path.string().c_str(), pool, {}, scene))
+            print_row("obj", pool.get_thread_count(), scene.timings);
+
+        if (import_gltf(gltf_path.string().c_str(), pool, {}, scene))
+            print_row("gltf", pool.get_thread_count(), scene.timings);
+
+        if (thread_count == max_thread_count)
+            break;
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,219 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+#include <dr/math.hpp>
+
+#include <mesh_file.hpp>
+#include <wgpu_upload.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 sphere_stacks = 1024;
+constexpr u32 sphere_slices = 2048;
+constexpr usize run_count = 5;
+constexpr u64 ring_chunk_size = 16 << 20;
+
+enum class Method : u8
+{
+    ReadAndWrite,
+    MappedAtCreation,
+    StreamedRing,
+};
+
+char const* to_string(Method const value)
+{
+    static constexpr char const* names[]{
+        "fread + queue write",
+        "mmap + mapped at creation",
+        "mmap + upload ring",
+    };
+    return names[int(value)];
+}
+
+// Position and tex coords, matching the layout used by textured-mesh
+MeshBuffers make_sphere(u32 const stacks, u32 const slices)
+{
+    MeshBuffers result{};
+    result.vertex_stride = sizeof(f32[5]);
+
+    for (u32 i = 0; i <= stacks; ++i)
+    {
+        f32 const phi = pi<f32> * f32(i) / stacks;
+        for (u32 j = 0; j <= slices; ++j)
+        {
+            f32 const theta = 2.0f * pi<f32> * f32(j) / slices;
+            f32 const v[]{
+                std::sin(phi) * std::cos(theta),
+                std::sin(phi) * std::sin(theta),
+                std::cos(phi),
+                f32(j) / slices,
+                f32(i) / stacks,
+            };
+
+            auto const src = reinterpret_cast<u8 const*>(v);
+            result.vertices.insert(result.vertices.end(), src, src + sizeof(v));
+        }
+    }
+
+    for (u32 i = 0; i < stacks; ++i)
+    {
+        for (u32 j = 0; j < slices; ++j)
+        {
+            u32 const v0 = i * (slices + 1) + j;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + slices + 1;
+            u32 const v3 = v2 + 1;
+            result.indices.insert(result.indices.end(), {v0, v2, v3, v0, v3, v1});
+        }
+    }
+
+    return result;
+}
+
+WGPUBuffer make_buffer(WGPUDevice const device, u64 const size, WGPUBufferUsage const usage)
+{
+    WGPUBufferDescriptor const desc{
+        .usage = usage | WGPUBufferUsage_CopyDst,
+        .size = (size + 3) & ~u64{3},
+    };
+    return wgpuDeviceCreateBuffer(device, &desc);
+}
+
+// Loads vertex and index buffers from the file and waits for the GPU to receive them
+void load(GpuContext const& gpu, char const* const path, Method const method, WGPUBuffer result[2])
+{
+    WGPUBufferUsage const usages[]{WGPUBufferUsage_Vertex, WGPUBufferUsage_Index};
+
+    if (method == Method::ReadAndWrite)
+    {
+        // Baseline: read sections into heap memory then hand them to the queue
+        std::FILE* const file = std::fopen(path, "rb");
+        assert(file);
+        auto const drop_file = defer([=]() { std::fclose(file); });
+
+        MeshFileHeader header;
+        [[maybe_unused]] usize const n = std::fread(&header, sizeof(header), 1, file);
+        assert(n == 1);
+
+        u64 const offsets[]{header.vertex_offset, header.index_offset};
+        u64 const sizes[]{header.vertex_size, header.index_size};
+        WGPUQueue const queue = wgpuDeviceGetQueue(gpu.device);
+
+        for (usize i = 0; i < 2; ++i)
+        {
+            std::vector<u8> data((sizes[i] + 3) & ~u64{3});
+            std::fseek(file, long(offsets[i]), SEEK_SET);
+            [[maybe_unused]] usize const read = std::fread(data.data(), 1, sizes[i], file);
+            assert(read == sizes[i]);
+
+            result[i] = make_buffer(gpu.device, sizes[i], usages[i]);
+            wgpuQueueWriteBuffer(queue, result[i], 0, data.data(), data.size());
+        }
+    }
+    else
+    {
+        MeshFile file = MeshFile::make(path);
+        assert(file.is_valid());
+        auto const drop_file = defer([&]() { MeshFile::release(file); });
+
+        u64 const offsets[]{file.header->vertex_offset, file.header->index_offset};
+        u64 const sizes[]{file.header->vertex_size, file.header->index_size};
+
+        if (method == Method::MappedAtCreation)
+        {
+            for (usize i = 0; i < 2; ++i)
+            {
+                result[i] =
+                    make_buffer_from_file(gpu.device, file.file, offsets[i], sizes[i], usages[i]);
+            }
+        }
+        else
+        {
+            UploadRing uploads = UploadRing::make(gpu.device, ring_chunk_size);
+            auto const drop_uploads = defer([&]() { UploadRing::release(uploads); });
+
+            for (usize i = 0; i < 2; ++i)
+            {
+                result[i] = make_buffer(gpu.device, sizes[i], usages[i]);
+                upload_file_range(file.file, offsets[i], sizes[i], uploads, result[i], 0, true);
+            }
+        }
+    }
+
+    poll_device(gpu.device, true);
+}
+
+} // namespace
+
+void run_mesh_file_benchmark(GpuContext const& gpu)
+{
+    std::filesystem::path const path =
+        std::filesystem::temp_directory_path() / "wgpu-sandbox-bench.mesh";
+    auto const drop_path = defer([&]() { std::filesystem::remove(path); });
+
+    {
+        MeshBuffers const mesh = make_sphere(sphere_stacks, sphere_slices);
+        VertexAttributes const attributes{.position = 0, .tex_coords = sizeof(f32[3])};
+
+        Stopwatch const timer{};
+        if (!write_mesh_file(path.string().c_str(), mesh, attributes))
+        {
+            fmt::println("\tSkipped: couldn't write {}", path.string());
+            return;
+        }
+
+        fmt::println(
+            "\t{} vertices, {} triangles, {:.1f} MB written in {:.1f} ms",
+            mesh.get_vertex_count(),
+            mesh.get_triangle_count(),
+            f64(std::filesystem::file_size(path)) / (1024.0 * 1024.0),
+            timer.wall_ms());
+    }
+
+    // NOTE(dr): The file was just written so it's likely in the page cache. This measures the cost
+    // of getting data from the cache to the GPU rather than disk throughput.
+    fmt::println("\t{:<28} {:>14} {:>14}", "method", "load (ms)", "cpu (ms)");
+
+    for (Method const method :
+         {Method::ReadAndWrite, Method::MappedAtCreation, Method::StreamedRing})
+    {
+        f64 wall_ms = 0.0;
+        f64 cpu_ms = 0.0;
+
+        for (usize i = 0; i < run_count; ++i)
+        {
+            WGPUBuffer buffers[2]{};
+
+            Stopwatch const timer{};
+            load(gpu, path.string().c_str(), method, buffers);
+            wall_ms += timer.wall_ms();
+            cpu_ms += timer.cpu_ms();
+
+            for (WGPUBuffer const buffer : buffers)
+                wgpuBufferRelease(buffer);
+        }
+
+        fmt::println(
+            "\t{:<28} {:>14.2f} {:>14.2f}",
+            to_string(method),
+            wall_ms / run_count,
+            cpu_ms / run_count);
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/math.hpp>
+
+#include <mesh_optimizer.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+struct Vertex
+{
+    f32 position[3];
+    f32 normal[3];
+    f32 tex_coords[2];
+};
+
+// Unindexed triangle soup in random order, as might come out of a naive exporter
+MeshBuffers make_soup(std::vector<Vertex> const& vertices, std::vector<u32> const& indices)
+{
+    std::vector<u32> triangles(indices.size() / 3);
+    for (u32 i = 0; i < triangles.size(); ++i)
+        triangles[i] = i;
+
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937{1});
+
+    MeshBuffers result{};
+    result.vertex_stride = sizeof(Vertex);
+
+    for (u32 const t : triangles)
+    {
+        for (u32 i = 0; i < 3; ++i)
+        {
+            auto const src = reinterpret_cast<u8 const*>(&vertices[indices[t * 3 + i]]);
+            result.vertices.insert(result.vertices.end(), src, src + sizeof(Vertex));
+            result.indices.push_back(u32(result.indices.size()));
+        }
+    }
+
+    return result;
+}
+
+MeshBuffers make_grid(u32 const size)
+{
+    std::vector<Vertex> vertices{};
+    for (u32 i = 0; i <= size; ++i)
+    {
+        for (u32 j = 0; j <= size; ++j)
+        {
+            f32 const u = f32(j) / size;
+            f32 const v = f32(i) / size;
+            vertices.push_back({{u, v, 0.0f}, {0.0f, 0.0f, 1.0f}, {u, v}});
+        }
+    }
+
+    std::vector<u32> indices{};
+    for (u32 i = 0; i < size; ++i)
+    {
+        for (u32 j = 0; j < size; ++j)
+        {
+            u32 const v0 = i * (size + 1) + j;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + size + 1;
+            u32 const v3 = v2 + 1;
+            indices.insert(indices.end(), {v0, v1, v3, v0, v3, v2});
+        }
+    }
+
+    return make_soup(vertices, indices);
+}
+
+MeshBuffers make_sphere(u32 const stacks, u32 const slices)
+{
+    std::vector<Vertex> vertices{};
+    for (u32 i = 0; i <= stacks; ++i)
+    {
+        f32 const phi = pi<f32> * f32(i) / stacks;
+        for (u32 j = 0; j <= slices; ++j)
+        {
+            f32 const theta = 2.0f * pi<f32> * f32(j) / slices;
+            f32 const x = std::sin(phi) * std::cos(theta);
+            f32 const y = std::sin(phi) * std::sin(theta);
+            f32 const z = std::cos(phi);
+            vertices.push_back({{x, y, z}, {x, y, z}, {f32(j) / slices, f32(i) / stacks}});
+        }
+    }
+
+    std::vector<u32> indices{};
+    for (u32 i = 0; i < stacks; ++i)
+    {
+        for (u32 j = 0; j < slices; ++j)
+        {
+            u32 const v0 = i * (slices + 1) + j;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + slices + 1;
+            u32 const v3 = v2 + 1;
+            indices.insert(indices.end(), {v0, v2, v3, v0, v3, v1});
+        }
+    }
+
+    return make_soup(vertices, indices);
+}
+
+void print_row(char const* const step, MeshBuffers const& mesh, f64 const ms)
+{
+    VertexCacheStats const stats = get_vertex_cache_stats(mesh);
+    fmt::println(
+        "\t  {:<16} {:>10} {:>8.3f} {:>8.3f} {:>12.2f}",
+        step,
+        mesh.get_vertex_count(),
+        stats.get_acmr(),
+        stats.get_atvr(),
+        ms);
+}
+
+void run_pipeline(char const* const name, MeshBuffers mesh)
+{
+    fmt::println("\t{} ({} triangles)", name, mesh.get_triangle_count());
+    print_row("input", mesh, 0.0);
+
+    auto const run_step = [&](char const* const step, auto&& func) {
+        Stopwatch const timer{};
+        func(mesh);
+        print_row(step, mesh, timer.wall_ms());
+    };
+    run_step("dedup", [](MeshBuffers& m) { dedup_vertices(m); });
+    run_step("vertex cache", [](MeshBuffers& m) { optimize_vertex_cache(m); });
+    run_step("overdraw", [](MeshBuffers& m) { optimize_overdraw(m); });
+    run_step("vertex fetch", [](MeshBuffers& m) { optimize_vertex_fetch(m); });
+
+    bool const is_u16 = select_index_format(mesh.get_vertex_count()) == WGPUIndexFormat_Uint16;
+    fmt::println("\t  index format: {}", is_u16 ? "u16" : "u32");
+}
+
+} // namespace
+
+void run_mesh_optimizer_benchmark(GpuContext const& /*gpu*/)
+{
+    fmt::println(
+        "\t  {:<16} {:>10} {:>8} {:>8} {:>12}",
+        "step",
+        "vertices",
+        "ACMR",
+        "ATVR",
+        "time (ms)");
+
+    run_pipeline("grid 512x512", make_grid(512));
+    run_pipeline("sphere 128x256", make_sphere(128, 256));
+    run_pipeline("sphere 32x64", make_sphere(32, 64));
+}
+
+} // namespace wgpu::sandbox
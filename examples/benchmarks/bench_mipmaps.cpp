@@ -0,0 +1,338 @@
+#include <cassert>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+#include <dr/memory.hpp>
+
+#include <wgpu_mipmaps.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize run_count = 5;
+constexpr u32 batch_size = 16;
+constexpr u32 sample_texture_size = 4096;
+constexpr u32 target_size = 512;
+constexpr u32 draws_per_frame = 16;
+constexpr usize warmup_frame_count = 5;
+constexpr usize frame_count = 30;
+constexpr WGPUTextureFormat color_format = WGPUTextureFormat_RGBA8Unorm;
+
+// Full screen triangle with tex coords scaled so that the texture is heavily minified
+constexpr char const* shader_src = R"(
+@group(0) @binding(0) var color_texture: texture_2d<f32>;
+@group(0) @binding(1) var color_sampler: sampler;
+
+struct VertexOut {
+    @builtin(position) position: vec4f,
+    @location(0) tex_coords: vec2f,
+};
+
+@vertex
+fn vs_main(
+    @builtin(vertex_index) vertex: u32,
+    @builtin(instance_index) instance: u32,
+) -> VertexOut {
+    let p = vec2f(f32((vertex << 1u) & 2u), f32(vertex & 2u));
+    let shift = 0.1 * f32(instance);
+    return VertexOut(vec4f(2.0 * p - 1.0, 0.0, 1.0), 2.0 * p + shift);
+}
+
+@fragment
+fn fs_main(in: VertexOut) -> @location(0) vec4f {
+    return textureSample(color_texture, color_sampler, in.tex_coords);
+}
+)";
+
+struct TextureSize
+{
+    u32 width;
+    u32 height;
+};
+
+WGPUTexture make_texture(WGPUDevice const device, u32 const width, u32 const height)
+{
+    WGPUTextureDescriptor const desc{
+        .usage = mipmap_texture_usage | WGPUTextureUsage_CopyDst,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {width, height, 1},
+        .format = WGPUTextureFormat_RGBA8Unorm,
+        .mipLevelCount = get_mip_level_count(width, height),
+        .sampleCount = 1,
+    };
+    WGPUTexture const result = wgpuDeviceCreateTexture(device, &desc);
+
+    // Checkerboard with noise so that level 0 isn't trivially compressible
+    std::vector<u32> data(usize(width) * height);
+    u32 state = 0x12345678;
+    for (u32 i = 0; i < height; ++i)
+    {
+        for (u32 j = 0; j < width; ++j)
+        {
+            state = state * 1664525u + 1013904223u;
+            u32 const check = (((i >> 4) ^ (j >> 4)) & 1) ? 0xc0 : 0x40;
+            u32 const noise = (state >> 24) & 0x1f;
+            u32 const c = check + noise;
+            data[usize(i) * width + j] = c | (c << 8) | (c << 16) | 0xff000000;
+        }
+    }
+
+    WGPUTexelCopyTextureInfo const copy_info{.texture = result};
+    WGPUTexelCopyBufferLayout const copy_layout{
+        .bytesPerRow = u32(width * sizeof(u32)),
+        .rowsPerImage = height,
+    };
+    wgpuQueueWriteTexture(
+        wgpuDeviceGetQueue(device),
+        &copy_info,
+        data.data(),
+        data.size() * sizeof(u32),
+        &copy_layout,
+        &desc.size);
+
+    return result;
+}
+
+// Returns the average wall time to generate mips for all textures, including GPU work
+f64 measure_generate(
+    GpuContext const& gpu,
+    MipmapGenerator const& mipmaps,
+    WGPUTexture const* const textures,
+    usize const texture_count,
+    bool const is_batched)
+{
+    // Upload level 0 and compile pipelines before timing
+    mipmaps.generate(gpu.device, textures, texture_count, true);
+    poll_device(gpu.device, true);
+
+    f64 total_ms = 0.0;
+    for (usize i = 0; i < run_count; ++i)
+    {
+        Stopwatch const timer{};
+
+        if (is_batched)
+        {
+            mipmaps.generate(gpu.device, textures, texture_count, true);
+        }
+        else
+        {
+            for (usize j = 0; j < texture_count; ++j)
+                mipmaps.generate(gpu.device, &textures[j], 1, true);
+        }
+
+        poll_device(gpu.device, true);
+        total_ms += timer.wall_ms();
+    }
+
+    return total_ms / run_count;
+}
+
+WGPURenderPipeline make_pipeline(WGPUDevice const device)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUColorTargetState const color_targ{
+        .format = color_format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState const frag_state{
+        .module = shader,
+        .entryPoint{"fs_main", WGPU_STRLEN},
+        .targetCount = 1,
+        .targets = &color_targ,
+    };
+    WGPURenderPipelineDescriptor const pipe_desc{
+        .vertex{
+            .module = shader,
+            .entryPoint{"vs_main", WGPU_STRLEN},
+        },
+        .primitive{
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .cullMode = WGPUCullMode_None,
+        },
+        .multisample{
+            .count = 1,
+            .mask = ~0u,
+        },
+        .fragment = &frag_state,
+    };
+    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+}
+
+// Returns the average wall time per frame when sampling the given view
+f64 measure_sampling(
+    GpuContext const& gpu,
+    WGPURenderPipeline const pipeline,
+    WGPUTexture const texture,
+    u32 const level_count,
+    OffscreenTarget const& target)
+{
+    WGPUTextureViewDescriptor const view_desc{
+        .format = color_format,
+        .dimension = WGPUTextureViewDimension_2D,
+        .mipLevelCount = level_count,
+        .arrayLayerCount = 1,
+    };
+    WGPUTextureView const view = wgpuTextureCreateView(texture, &view_desc);
+    auto const drop_view = defer([=]() { wgpuTextureViewRelease(view); });
+
+    WGPUSamplerDescriptor const sampler_desc{
+        .addressModeU = WGPUAddressMode_Repeat,
+        .addressModeV = WGPUAddressMode_Repeat,
+        .magFilter = WGPUFilterMode_Linear,
+        .minFilter = WGPUFilterMode_Linear,
+        .mipmapFilter = WGPUMipmapFilterMode_Linear,
+        .lodMaxClamp = f32(level_count),
+        .maxAnisotropy = 1,
+    };
+    WGPUSampler const sampler = wgpuDeviceCreateSampler(gpu.device, &sampler_desc);
+    auto const drop_sampler = defer([=]() { wgpuSamplerRelease(sampler); });
+
+    WGPUBindGroupEntry const entries[]{
+        {.binding = 0, .textureView = view},
+        {.binding = 1, .sampler = sampler},
+    };
+    WGPUBindGroupDescriptor const bind_group_desc{
+        .layout = wgpuRenderPipelineGetBindGroupLayout(pipeline, 0),
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    WGPUBindGroup const bind_group = wgpuDeviceCreateBindGroup(gpu.device, &bind_group_desc);
+    wgpuBindGroupLayoutRelease(bind_group_desc.layout);
+    assert(bind_group);
+    auto const drop_bind_group = defer([=]() { wgpuBindGroupRelease(bind_group); });
+
+    f64 total_ms = 0.0;
+    for (usize i = 0; i < warmup_frame_count + frame_count; ++i)
+    {
+        Stopwatch const timer{};
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(gpu.device, nullptr);
+        {
+            WGPURenderPassColorAttachment const color_att{
+                .view = target.color_view,
+                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                .loadOp = WGPULoadOp_Clear,
+                .storeOp = WGPUStoreOp_Store,
+            };
+            WGPURenderPassDescriptor const desc{
+                .colorAttachmentCount = 1,
+                .colorAttachments = &color_att,
+            };
+            WGPURenderPassEncoder const pass =
+                wgpuCommandEncoderBeginRenderPass(cmd_encoder, &desc);
+            wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+            wgpuRenderPassEncoderSetBindGroup(pass, 0, bind_group, 0, nullptr);
+            wgpuRenderPassEncoderDraw(pass, 3, draws_per_frame, 0, 0);
+            wgpuRenderPassEncoderEnd(pass);
+            wgpuRenderPassEncoderRelease(pass);
+        }
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        wgpuQueueSubmit(wgpuDeviceGetQueue(gpu.device), 1, &cmds);
+        wgpuCommandBufferRelease(cmds);
+        wgpuCommandEncoderRelease(cmd_encoder);
+        poll_device(gpu.device, true);
+
+        if (i >= warmup_frame_count)
+            total_ms += timer.wall_ms();
+    }
+
+    return total_ms / frame_count;
+}
+
+} // namespace
+
+void run_mipmaps_benchmark(GpuContext const& gpu)
+{
+    MipmapGenerator mipmaps = MipmapGenerator::make(gpu.device);
+    auto const drop_mipmaps = defer([&]() { MipmapGenerator::release(mipmaps); });
+
+    // Generation time for batches of textures, including non-power-of-two sizes
+    fmt::println("\tgenerating mips for {} textures per batch", batch_size);
+    fmt::println(
+        "\t{:<12} {:<10} {:>12} {:>14}",
+        "size",
+        "submits",
+        "time (ms)",
+        "ms / MP");
+
+    for (TextureSize const size : {
+             TextureSize{512, 512},
+             TextureSize{1024, 1024},
+             TextureSize{1000, 700},
+             TextureSize{2048, 2048},
+             TextureSize{1920, 1080},
+         })
+    {
+        std::vector<WGPUTexture> textures(batch_size);
+        for (WGPUTexture& texture : textures)
+            texture = make_texture(gpu.device, size.width, size.height);
+
+        f64 const megapixels = f64(size.width) * size.height * batch_size * 1.0e-6;
+        for (bool const is_batched : {true, false})
+        {
+            f64 const ms =
+                measure_generate(gpu, mipmaps, textures.data(), textures.size(), is_batched);
+            fmt::println(
+                "\t{:<12} {:<10} {:>12.2f} {:>14.3f}",
+                fmt::format("{}x{}", size.width, size.height),
+                is_batched ? "1" : fmt::format("{}", batch_size),
+                ms,
+                ms / megapixels);
+        }
+
+        for (WGPUTexture const texture : textures)
+            wgpuTextureRelease(texture);
+    }
+
+    // Sampling cost of a minified texture with and without mips
+    WGPUTexture const texture =
+        make_texture(gpu.device, sample_texture_size, sample_texture_size);
+    auto const drop_texture = defer([=]() { wgpuTextureRelease(texture); });
+    mipmaps.generate(gpu.device, &texture, 1, true);
+
+    WGPURenderPipeline const pipeline = make_pipeline(gpu.device);
+    assert(pipeline);
+    auto const drop_pipeline = defer([=]() { wgpuRenderPipelineRelease(pipeline); });
+
+    OffscreenTarget target =
+        OffscreenTarget::make(gpu.device, target_size, target_size, color_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    fmt::println(
+        "\tsampling {0}x{0} texture into {1}x{1} target, {2} draws per frame",
+        sample_texture_size,
+        target_size,
+        draws_per_frame);
+    fmt::println("\t{:<12} {:>14}", "levels", "frame (ms)");
+
+    u32 const level_count = wgpuTextureGetMipLevelCount(texture);
+    for (u32 const count : {1u, level_count})
+    {
+        f64 const frame_ms = measure_sampling(gpu, pipeline, texture, count, target);
+        fmt::println("\t{:<12} {:>14.3f}", count, frame_ms);
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,215 @@
+#include <cassert>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <frame_timer.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize warmup_frame_count = 30;
+constexpr usize frame_count = 300;
+constexpr int window_width = 640;
+constexpr int window_height = 480;
+
+using Clock = Stopwatch::Clock;
+
+struct FrameRecord
+{
+    Clock::time_point start;
+    Clock::time_point done;
+    bool is_done;
+};
+
+struct Result
+{
+    FrameTimer::History interval_ms;
+    FrameTimer::History acquire_ms;
+    FrameTimer::History latency_ms;
+};
+
+f32 to_ms(Clock::duration const dt) { return std::chrono::duration<f32, std::milli>(dt).count(); }
+
+void render_frame(
+    WGPUDevice const device,
+    WGPUSurface const surface,
+    FrameRecord& record,
+    f32& acquire_ms)
+{
+    Stopwatch const acquire_timer{};
+    WGPUSurfaceTexture srf_tex;
+    wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
+    acquire_ms = f32(acquire_timer.wall_ms());
+    assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
+
+    WGPUTextureView const view = wgpuTextureCreateView(srf_tex.texture, nullptr);
+    auto const drop_view = defer([=]() { wgpuTextureViewRelease(view); });
+
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+    {
+        WGPURenderPassColorAttachment const color_att{
+            .view = view,
+            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+            .loadOp = WGPULoadOp_Clear,
+            .storeOp = WGPUStoreOp_Store,
+            .clearValue{0.15, 0.15, 0.15, 1.0},
+        };
+        WGPURenderPassDescriptor const desc{
+            .colorAttachmentCount = 1,
+            .colorAttachments = &color_att,
+        };
+        WGPURenderPassEncoder const pass = wgpuCommandEncoderBeginRenderPass(cmd_encoder, &desc);
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+    }
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+    wgpuQueueSubmit(queue, 1, &cmds);
+
+    // Record when the GPU is done with the frame
+    WGPUQueueWorkDoneCallbackInfo cb_info{};
+    cb_info.userdata1 = &record;
+    cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+    cb_info.callback =
+        [](WGPUQueueWorkDoneStatus /*status*/, void* userdata1, void* /*userdata2*/) {
+            auto& record = *static_cast<FrameRecord*>(userdata1);
+            record.done = Clock::now();
+            record.is_done = true;
+        };
+    wgpuQueueOnSubmittedWorkDone(queue, cb_info);
+
+    wgpuSurfacePresent(surface);
+}
+
+Result run_mode(GpuContext const& gpu, WGPUSurface const surface, WGPUPresentMode const mode)
+{
+    WGPUSurfaceConfiguration config{};
+    {
+        config.device = gpu.device;
+        config.width = window_width;
+        config.height = window_height;
+        config.format = default_surface_format;
+        config.usage = WGPUTextureUsage_RenderAttachment;
+        config.presentMode = mode;
+    }
+    wgpuSurfaceConfigure(surface, &config);
+
+    std::vector<FrameRecord> records(warmup_frame_count + frame_count);
+    Result result{};
+
+    for (usize i = 0; i < records.size(); ++i)
+    {
+        glfwPollEvents();
+
+        records[i].start = Clock::now();
+        f32 acquire_ms;
+        render_frame(gpu.device, surface, records[i], acquire_ms);
+
+        if (i > warmup_frame_count)
+        {
+            result.interval_ms.push(to_ms(records[i].start - records[i - 1].start));
+            result.acquire_ms.push(acquire_ms);
+        }
+    }
+
+    SubmissionIndex const submission = get_submission_index(wgpuDeviceGetQueue(gpu.device));
+    wait_for_condition(gpu.device, submission, [&]() { return records.back().is_done; });
+
+    for (usize i = warmup_frame_count; i < records.size(); ++i)
+        result.latency_ms.push(to_ms(records[i].done - records[i].start));
+
+    return result;
+}
+
+} // namespace
+
+void run_present_benchmark(GpuContext const& gpu)
+{
+    if (!glfwInit())
+    {
+        fmt::println("\tSkipped: GLFW could not be initialized");
+        return;
+    }
+    auto const drop_glfw = defer([]() { glfwTerminate(); });
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    GLFWwindow* const window = glfwCreateWindow(
+        window_width,
+        window_height,
+        "WebGPU Sandbox: Present Benchmark",
+        nullptr,
+        nullptr);
+    if (!window)
+    {
+        fmt::println("\tSkipped: no window could be created");
+        return;
+    }
+    auto const drop_window = defer([=]() { glfwDestroyWindow(window); });
+
+    WGPUSurface const surface = make_surface(gpu.instance, {window, nullptr});
+    assert(surface);
+    auto const drop_surface = defer([=]() {
+        wgpuSurfaceUnconfigure(surface);
+        wgpuSurfaceRelease(surface);
+    });
+
+    WGPUSurfaceCapabilities caps{};
+    wgpuSurfaceGetCapabilities(surface, gpu.adapter, &caps);
+    auto const drop_caps = defer([&]() { wgpuSurfaceCapabilitiesFreeMembers(caps); });
+
+    if (!is_supported(caps, default_surface_format))
+    {
+        fmt::println("\tSkipped: surface doesn't support {}", to_string(default_surface_format));
+        return;
+    }
+
+    fmt::println(
+        "\t{:<12} {:>14} {:>14} {:>14} {:>18}",
+        "mode",
+        "interval p50",
+        "interval p95",
+        "acquire p95",
+        "start-to-done p95");
+
+    constexpr WGPUPresentMode modes[]{
+        WGPUPresentMode_Fifo,
+        WGPUPresentMode_FifoRelaxed,
+        WGPUPresentMode_Mailbox,
+        WGPUPresentMode_Immediate,
+    };
+    for (WGPUPresentMode const mode : modes)
+    {
+        if (!is_supported(caps, mode))
+        {
+            fmt::println("\t{:<12} {:>14}", to_string(mode), "unsupported");
+            continue;
+        }
+
+        Result const res = run_mode(gpu, surface, mode);
+        fmt::println(
+            "\t{:<12} {:>11.2f} ms {:>11.2f} ms {:>11.2f} ms {:>15.2f} ms",
+            to_string(mode),
+            res.interval_ms.get_percentile(0.5f),
+            res.interval_ms.get_percentile(0.95f),
+            res.acquire_ms.get_percentile(0.95f),
+            res.latency_ms.get_percentile(0.95f));
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,178 @@
+#include <cassert>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_readback.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize slot_count = 4;
+
+struct Workload
+{
+    char const* name;
+    u64 size;
+    usize count;
+};
+
+constexpr Workload workloads[]{
+    {"256 B", 256, 4096},
+    {"64 KB", 64 << 10, 1024},
+    {"4 MB", 4 << 20, 64},
+};
+
+void submit_copy(
+    WGPUDevice const device,
+    WGPUBuffer const src,
+    WGPUBuffer const dst,
+    u64 const size)
+{
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+    wgpuCommandEncoderCopyBufferToBuffer(cmd_encoder, src, 0, dst, 0, size);
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+    wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &cmds);
+}
+
+// Previous approach: one staging buffer, each readback waits for its own map
+u64 run_serial(WGPUDevice const device, WGPUBuffer const src, Workload const& work)
+{
+    WGPUBufferDescriptor const desc{
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+        .size = work.size,
+    };
+    WGPUBuffer const staging = wgpuDeviceCreateBuffer(device, &desc);
+    assert(staging);
+    auto const drop_staging = defer([=]() { wgpuBufferRelease(staging); });
+
+    u64 checksum = 0;
+
+    for (usize i = 0; i < work.count; ++i)
+    {
+        submit_copy(device, src, staging, work.size);
+
+        bool is_mapped = false;
+        WGPUBufferMapCallbackInfo cb_info{};
+        cb_info.userdata1 = &is_mapped;
+        cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+        cb_info.callback = //
+            [](WGPUMapAsyncStatus status,
+               WGPUStringView /*msg*/,
+               void* userdata1,
+               void* /*userdata2*/) {
+                assert(status == WGPUMapAsyncStatus_Success);
+                *static_cast<bool*>(userdata1) = true;
+            };
+        wgpuBufferMapAsync(staging, WGPUMapMode_Read, 0, work.size, cb_info);
+
+        SubmissionIndex const submission = get_submission_index(wgpuDeviceGetQueue(device));
+        wait_for_condition(device, submission, [&]() { return is_mapped; });
+
+        auto const data = static_cast<u8 const*>(
+            wgpuBufferGetConstMappedRange(staging, 0, work.size));
+        checksum += data[0];
+        wgpuBufferUnmap(staging);
+    }
+
+    return checksum;
+}
+
+// Readbacks are pipelined through a ring and consumed via callback as each slot is mapped
+u64 run_ring(WGPUDevice const device, WGPUBuffer const src, Workload const& work)
+{
+    ReadbackRing ring = ReadbackRing::make(device, slot_count, work.size);
+    auto const drop_ring = defer([&]() { ReadbackRing::release(ring); });
+
+    u64 checksum = 0;
+    auto const consume = [](std::span<u8 const> data, u64 /*id*/, void* userdata) {
+        *static_cast<u64*>(userdata) += data[0];
+    };
+
+    for (usize i = 0; i < work.count; ++i)
+    {
+        if (!ring.has_free_slot())
+            ring.wait_for_free_slot();
+
+        WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+        auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+        [[maybe_unused]] ReadbackRing::Handle const handle = ring.enqueue(
+            cmd_encoder,
+            src,
+            0,
+            work.size,
+            consume,
+            &checksum);
+        assert(handle.is_valid());
+
+        WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+        auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+        wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &cmds);
+        ring.submit();
+
+        // Pick up finished readbacks without blocking
+        poll_device(device, false);
+    }
+
+    SubmissionIndex const submission = get_submission_index(wgpuDeviceGetQueue(device));
+    wait_for_condition(device, submission, [&]() { return ring.pending_count() == 0; });
+    return checksum;
+}
+
+} // namespace
+
+void run_readback_benchmark(GpuContext const& gpu)
+{
+    fmt::println(
+        "\t{:<8} {:<10} {:>12} {:>14} {:>10}",
+        "size",
+        "mode",
+        "wall (ms)",
+        "readbacks/s",
+        "MB/s");
+
+    for (Workload const& work : workloads)
+    {
+        WGPUBufferDescriptor const desc{
+            .usage = WGPUBufferUsage_CopySrc | WGPUBufferUsage_Storage,
+            .size = work.size,
+        };
+        WGPUBuffer const src = wgpuDeviceCreateBuffer(gpu.device, &desc);
+        assert(src);
+        auto const drop_src = defer([=]() { wgpuBufferRelease(src); });
+
+        for (bool const use_ring : {false, true})
+        {
+            Stopwatch const timer{};
+            [[maybe_unused]] u64 const checksum = use_ring ? run_ring(gpu.device, src, work)
+                                                           : run_serial(gpu.device, src, work);
+            f64 const secs = timer.wall_ms() / 1000.0;
+
+            fmt::println(
+                "\t{:<8} {:<10} {:>12.2f} {:>14.1f} {:>10.1f}",
+                work.name,
+                use_ring ? "ring" : "serial",
+                secs * 1000.0,
+                work.count / secs,
+                work.count * work.size / (secs * 1024.0 * 1024.0));
+        }
+    }
+}
+
+} // namespace wgpu::sandbox
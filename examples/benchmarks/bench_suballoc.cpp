@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_buffer_pool.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize mesh_count = 20'000;
+constexpr WGPUBufferUsage mesh_usage =
+    WGPUBufferUsage_Vertex | WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst;
+
+// Vertex and index buffer sizes of a mesh with a random number of vertices
+void get_mesh_sizes(std::minstd_rand& rng, u64& vertex_size, u64& index_size)
+{
+    u64 const vertex_count = 24 + rng() % 2000;
+    vertex_size = vertex_count * sizeof(f32[5]);
+    index_size = vertex_count * 3 / 2 * sizeof(u16);
+}
+
+f64 run_dedicated(WGPUDevice const device)
+{
+    std::vector<WGPUBuffer> buffers{};
+    buffers.reserve(mesh_count * 2);
+
+    std::minstd_rand rng{1};
+    Stopwatch const timer{};
+
+    for (usize i = 0; i < mesh_count; ++i)
+    {
+        u64 sizes[2];
+        get_mesh_sizes(rng, sizes[0], sizes[1]);
+
+        for (u64 const size : sizes)
+        {
+            WGPUBufferDescriptor const desc{
+                .usage = mesh_usage,
+                .size = (size + 3) & ~u64{3},
+            };
+            buffers.push_back(wgpuDeviceCreateBuffer(device, &desc));
+        }
+    }
+
+    f64 const result = timer.wall_ms();
+
+    for (WGPUBuffer const buf : buffers)
+        wgpuBufferRelease(buf);
+
+    return result;
+}
+
+f64 run_pooled(BufferPool& pool)
+{
+    std::vector<BufferPool::Allocation> allocs{};
+    allocs.reserve(mesh_count * 2);
+
+    std::minstd_rand rng{1};
+    Stopwatch const timer{};
+
+    for (usize i = 0; i < mesh_count; ++i)
+    {
+        u64 sizes[2];
+        get_mesh_sizes(rng, sizes[0], sizes[1]);
+
+        for (u64 const size : sizes)
+        {
+            allocs.push_back(pool.allocate(size));
+            assert(allocs.back().is_valid());
+        }
+    }
+
+    f64 const result = timer.wall_ms();
+
+    // Free a random half of the meshes and reallocate to see how fragmented the pool gets
+    std::shuffle(allocs.begin(), allocs.end(), rng);
+    for (usize i = 0; i < allocs.size() / 2; ++i)
+        pool.free(allocs[i]);
+
+    for (usize i = 0; i < allocs.size() / 2; ++i)
+    {
+        u64 sizes[2];
+        get_mesh_sizes(rng, sizes[0], sizes[1]);
+        allocs[i] = pool.allocate(sizes[i & 1]);
+    }
+
+    return result;
+}
+
+// Checks that the allocator's ranges tile its capacity in order without gaps or overlaps and that
+// its counters agree with them
+bool has_valid_ranges(RangeAllocator const& alloc)
+{
+    std::vector<bool> is_unused(alloc.nodes.size());
+    for (u32 const node : alloc.unused_nodes)
+        is_unused[node] = true;
+
+    // Find the first range
+    u32 node = RangeAllocator::no_node;
+    usize live_count = 0;
+    for (u32 i = 0; i < alloc.nodes.size(); ++i)
+    {
+        if (is_unused[i])
+            continue;
+
+        ++live_count;
+        if (alloc.nodes[i].prev_range == RangeAllocator::no_node)
+        {
+            if (node != RangeAllocator::no_node)
+                return false;
+
+            node = i;
+        }
+    }
+
+    u64 offset = 0;
+    u64 used = 0;
+    usize range_count = 0;
+    u32 alloc_count = 0;
+    u32 free_count = 0;
+
+    for (u32 prev = RangeAllocator::no_node; node != RangeAllocator::no_node;)
+    {
+        RangeAllocator::Node const& range = alloc.nodes[node];
+        if (is_unused[node] || range.prev_range != prev || range.offset != offset
+            || range.size == 0 || range.size > alloc.capacity - offset
+            || ++range_count > live_count)
+        {
+            return false;
+        }
+
+        offset += range.size;
+        if (range.is_free)
+        {
+            ++free_count;
+        }
+        else
+        {
+            used += range.size;
+            ++alloc_count;
+        }
+
+        prev = node;
+        node = range.next_range;
+    }
+
+    return offset == alloc.capacity && range_count == live_count && used == alloc.used
+           && alloc_count == alloc.allocation_count && free_count == alloc.free_range_count;
+}
+
+// Reallocating a freed range must not reach past the end of the allocator
+bool has_valid_reuse()
+{
+    RangeAllocator alloc = RangeAllocator::make(1024, 4);
+    alloc.free(alloc.allocate(64));
+
+    RangeAllocator::Allocation const all = alloc.allocate(1024);
+    return all.is_valid() && all.offset == 0 && all.size == 1024 && has_valid_ranges(alloc);
+}
+
+void report_stats(char const* const label, RangeAllocator::Stats const& stats)
+{
+    fmt::println(
+        "\t{:<24} {:>10.2f} {:>10.2f} {:>10} {:>12} {:>9.1f}%",
+        label,
+        stats.capacity / (1024.0 * 1024.0),
+        stats.used / (1024.0 * 1024.0),
+        stats.allocation_count,
+        stats.free_range_count,
+        100.0 * stats.get_fragmentation());
+}
+
+} // namespace
+
+void run_suballoc_benchmark(GpuContext const& gpu)
+{
+    f64 const dedicated_ms = run_dedicated(gpu.device);
+
+    BufferPool pool = BufferPool::make(gpu.device, mesh_usage);
+    auto const drop_pool = defer([&]() { BufferPool::release(pool); });
+    f64 const pooled_ms = run_pooled(pool);
+
+    fmt::println("\t{:<24} {:>12}", "strategy", "alloc (ms)");
+    fmt::println("\t{:<24} {:>12.2f}", "buffer per range", dedicated_ms);
+    fmt::println("\t{:<24} {:>12.2f} ({} pages)", "buffer pool", pooled_ms, pool.pages.size());
+
+    fmt::println(
+        "\n\t{:<24} {:>10} {:>10} {:>10} {:>12} {:>10}",
+        "pool after churn",
+        "cap (MB)",
+        "used (MB)",
+        "allocs",
+        "free ranges",
+        "frag");
+    report_stats("all pages", pool.get_stats());
+
+    bool is_valid = has_valid_reuse();
+    for (BufferPool::Page const& page : pool.pages)
+        is_valid = is_valid && has_valid_ranges(page.allocator);
+
+    fmt::println("\n\tranges after churn: {}", is_valid ? "valid" : "INVALID");
+}
+
+} // namespace wgpu::sandbox
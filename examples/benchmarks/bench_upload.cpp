@@ -0,0 +1,172 @@
+#include <cassert>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_upload.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr usize object_count = 10'000;
+constexpr usize frame_count = 60;
+constexpr u64 object_size = sizeof(f32[16]);
+
+enum class Strategy : u8
+{
+    QueueWrite,
+    RingSeparate,
+    RingPacked,
+};
+
+char const* to_string(Strategy const value)
+{
+    static constexpr char const* names[]{
+        "queue write per object",
+        "upload ring, buffer per object",
+        "upload ring, packed buffer",
+    };
+    return names[int(value)];
+}
+
+struct Targets
+{
+    std::vector<WGPUBuffer> separate;
+    WGPUBuffer packed;
+
+    static Targets make(WGPUDevice const device)
+    {
+        Targets result{};
+        result.separate.resize(object_count);
+
+        for (WGPUBuffer& buf : result.separate)
+            buf = make_buffer(device, object_size);
+
+        result.packed = make_buffer(device, object_size * object_count);
+        return result;
+    }
+
+    static void release(Targets& targets)
+    {
+        for (WGPUBuffer const buf : targets.separate)
+            wgpuBufferRelease(buf);
+
+        wgpuBufferRelease(targets.packed);
+        targets = {};
+    }
+
+  private:
+    static WGPUBuffer make_buffer(WGPUDevice const device, u64 const size)
+    {
+        WGPUBufferDescriptor const desc{
+            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+            .size = size,
+        };
+        return wgpuDeviceCreateBuffer(device, &desc);
+    }
+};
+
+void upload_frame(
+    WGPUDevice const device,
+    Strategy const strategy,
+    Targets const& targets,
+    UploadRing& uploads,
+    f32 const (&data)[16])
+{
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+    switch (strategy)
+    {
+        case Strategy::QueueWrite:
+        {
+            for (WGPUBuffer const buf : targets.separate)
+                wgpuQueueWriteBuffer(queue, buf, 0, data, object_size);
+            break;
+        }
+        case Strategy::RingSeparate:
+        {
+            for (WGPUBuffer const buf : targets.separate)
+                uploads.write(buf, 0, data, object_size);
+            break;
+        }
+        case Strategy::RingPacked:
+        {
+            for (usize i = 0; i < object_count; ++i)
+                uploads.write(targets.packed, i * object_size, data, object_size);
+            break;
+        }
+    }
+
+    uploads.finish(cmd_encoder);
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+    wgpuQueueSubmit(queue, 1, &cmds);
+    uploads.submit();
+}
+
+} // namespace
+
+void run_upload_benchmark(GpuContext const& gpu)
+{
+    Targets targets = Targets::make(gpu.device);
+    auto const drop_targets = defer([&]() { Targets::release(targets); });
+
+    f32 data[16]{};
+
+    fmt::println(
+        "\t{:<32} {:>10} {:>12} {:>10} {:>8}",
+        "strategy",
+        "ms/frame",
+        "MB staged",
+        "copies",
+        "stalls");
+
+    for (Strategy const strategy :
+         {Strategy::QueueWrite, Strategy::RingSeparate, Strategy::RingPacked})
+    {
+        UploadRing uploads = UploadRing::make(gpu.device);
+        auto const drop_uploads = defer([&]() { UploadRing::release(uploads); });
+
+        f64 frame_ms = 0.0;
+
+        for (usize i = 0; i < frame_count; ++i)
+        {
+            data[0] = f32(i);
+
+            Stopwatch const timer{};
+            upload_frame(gpu.device, strategy, targets, uploads, data);
+            frame_ms += timer.wall_ms();
+
+            // Let the GPU make progress without blocking, as a frame loop would
+            poll_device(gpu.device, false);
+        }
+
+        poll_device(gpu.device, true);
+
+        UploadRing::Stats const& stats = uploads.stats;
+        fmt::println(
+            "\t{:<32} {:>10.3f} {:>12.2f} {:>10} {:>8}",
+            to_string(strategy),
+            frame_ms / frame_count,
+            stats.bytes_staged / (1024.0 * 1024.0),
+            stats.copies_recorded,
+            stats.stall_count);
+    }
+}
+
+} // namespace wgpu::sandbox
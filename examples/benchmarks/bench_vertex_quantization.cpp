@@ -0,0 +1,412 @@
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+#include <dr/math.hpp>
+#include <dr/memory.hpp>
+
+#include <vertex_quantization.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr u32 sphere_stacks = 512;
+constexpr u32 sphere_slices = 1024;
+constexpr u32 draws_per_frame = 8;
+constexpr usize warmup_frame_count = 5;
+constexpr usize frame_count = 30;
+// Small target so that vertex processing dominates
+constexpr u32 target_size = 256;
+constexpr WGPUTextureFormat color_format = WGPUTextureFormat_RGBA8Unorm;
+constexpr WGPUTextureFormat depth_format = WGPUTextureFormat_Depth32Float;
+
+// Decodes quantized positions with override constants rather than per-draw uniforms
+constexpr char const* shader_src = R"(
+override scale_x: f32 = 1.0;
+override scale_y: f32 = 1.0;
+override scale_z: f32 = 1.0;
+override offset_x: f32 = 0.0;
+override offset_y: f32 = 0.0;
+override offset_z: f32 = 0.0;
+
+struct VertexOut {
+    @builtin(position) position: vec4f,
+    @location(0) color: vec3f,
+};
+
+fn make_vertex_out(
+    position: vec3f,
+    normal: vec3f,
+    tex_coords: vec2f,
+    instance: u32,
+) -> VertexOut {
+    let shift = 0.01 * f32(instance);
+    return VertexOut(
+        vec4f(0.5 * position.xy + vec2f(shift, 0.0), 0.5 + 0.25 * position.z, 1.0),
+        vec3f(0.5 * normal.xy + 0.5, tex_coords.x),
+    );
+}
+
+fn decode_octahedral(value: vec2f) -> vec3f {
+    var n = vec3f(value, 1.0 - abs(value.x) - abs(value.y));
+    let t = max(-n.z, 0.0);
+    n = vec3f(n.xy + select(vec2f(t), vec2f(-t), n.xy >= vec2f(0.0)), n.z);
+    return normalize(n);
+}
+
+@vertex
+fn vs_float(
+    @location(0) position: vec3f,
+    @location(1) normal: vec3f,
+    @location(2) tex_coords: vec2f,
+    @builtin(instance_index) instance: u32,
+) -> VertexOut {
+    return make_vertex_out(position, normal, tex_coords, instance);
+}
+
+@vertex
+fn vs_quantized(
+    @location(0) position: vec4f,
+    @location(1) normal: vec2f,
+    @location(2) tex_coords: vec2f,
+    @builtin(instance_index) instance: u32,
+) -> VertexOut {
+    let scale = vec3f(scale_x, scale_y, scale_z);
+    let offset = vec3f(offset_x, offset_y, offset_z);
+    let p = offset + scale * position.xyz;
+    return make_vertex_out(p, decode_octahedral(normal), tex_coords, instance);
+}
+
+@fragment
+fn fs_main(@location(0) color: vec3f) -> @location(0) vec4f {
+    return vec4f(color, 1.0);
+}
+)";
+
+struct Vertex
+{
+    f32 position[3];
+    f32 normal[3];
+    f32 tex_coords[2];
+};
+
+constexpr VertexAttributes vertex_attributes{
+    .position = offsetof(Vertex, position),
+    .normal = offsetof(Vertex, normal),
+    .tex_coords = offsetof(Vertex, tex_coords),
+};
+
+MeshBuffers make_sphere(u32 const stacks, u32 const slices)
+{
+    MeshBuffers result{};
+    result.vertex_stride = sizeof(Vertex);
+
+    for (u32 i = 0; i <= stacks; ++i)
+    {
+        f32 const phi = pi<f32> * f32(i) / stacks;
+        for (u32 j = 0; j <= slices; ++j)
+        {
+            f32 const theta = 2.0f * pi<f32> * f32(j) / slices;
+            f32 const x = std::sin(phi) * std::cos(theta);
+            f32 const y = std::sin(phi) * std::sin(theta);
+            f32 const z = std::cos(phi);
+            Vertex const v{{x, y, z}, {x, y, z}, {f32(j) / slices, f32(i) / stacks}};
+
+            auto const src = reinterpret_cast<u8 const*>(&v);
+            result.vertices.insert(result.vertices.end(), src, src + sizeof(Vertex));
+        }
+    }
+
+    for (u32 i = 0; i < stacks; ++i)
+    {
+        for (u32 j = 0; j < slices; ++j)
+        {
+            u32 const v0 = i * (slices + 1) + j;
+            u32 const v1 = v0 + 1;
+            u32 const v2 = v0 + slices + 1;
+            u32 const v3 = v2 + 1;
+            result.indices.insert(result.indices.end(), {v0, v2, v3, v0, v3, v1});
+        }
+    }
+
+    return result;
+}
+
+WGPUBuffer make_buffer(
+    WGPUDevice const device,
+    void const* const data,
+    usize const size,
+    WGPUBufferUsage const usage)
+{
+    WGPUBufferDescriptor const desc{
+        .usage = usage | WGPUBufferUsage_CopyDst,
+        .size = size,
+    };
+    WGPUBuffer const result = wgpuDeviceCreateBuffer(device, &desc);
+    wgpuQueueWriteBuffer(wgpuDeviceGetQueue(device), result, 0, data, size);
+    return result;
+}
+
+WGPURenderPipeline make_pipeline(
+    WGPUDevice const device,
+    VertexQuantization const* const quant)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUVertexAttribute const float_attrs[]{
+        {
+            .format = WGPUVertexFormat_Float32x3,
+            .offset = vertex_attributes.position,
+            .shaderLocation = 0,
+        },
+        {
+            .format = WGPUVertexFormat_Float32x3,
+            .offset = vertex_attributes.normal,
+            .shaderLocation = 1,
+        },
+        {
+            .format = WGPUVertexFormat_Float32x2,
+            .offset = vertex_attributes.tex_coords,
+            .shaderLocation = 2,
+        },
+    };
+    WGPUVertexAttribute const quantized_attrs[]{
+        {
+            .format = WGPUVertexFormat_Snorm16x4,
+            .offset = 0,
+            .shaderLocation = 0,
+        },
+        {
+            .format = WGPUVertexFormat_Snorm16x2,
+            .offset = quant ? quant->normal_offset : 0,
+            .shaderLocation = 1,
+        },
+        {
+            .format = WGPUVertexFormat_Unorm16x2,
+            .offset = quant ? quant->tex_coords_offset : 0,
+            .shaderLocation = 2,
+        },
+    };
+    WGPUVertexBufferLayout const vert_buf_layout{
+        .stepMode = WGPUVertexStepMode_Vertex,
+        .arrayStride = quant ? quant->stride : sizeof(Vertex),
+        .attributeCount = 3,
+        .attributes = quant ? quantized_attrs : float_attrs,
+    };
+
+    WGPUConstantEntry const constants[]{
+        {.key{"scale_x", WGPU_STRLEN}, .value = quant ? quant->position_scale[0] : 1.0},
+        {.key{"scale_y", WGPU_STRLEN}, .value = quant ? quant->position_scale[1] : 1.0},
+        {.key{"scale_z", WGPU_STRLEN}, .value = quant ? quant->position_scale[2] : 1.0},
+        {.key{"offset_x", WGPU_STRLEN}, .value = quant ? quant->position_offset[0] : 0.0},
+        {.key{"offset_y", WGPU_STRLEN}, .value = quant ? quant->position_offset[1] : 0.0},
+        {.key{"offset_z", WGPU_STRLEN}, .value = quant ? quant->position_offset[2] : 0.0},
+    };
+
+    WGPUDepthStencilState const depth_state{
+        .format = depth_format,
+        .depthWriteEnabled = WGPUOptionalBool_True,
+        .depthCompare = WGPUCompareFunction_LessEqual,
+    };
+    WGPUColorTargetState const color_targ{
+        .format = color_format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState const frag_state{
+        .module = shader,
+        .entryPoint{"fs_main", WGPU_STRLEN},
+        .targetCount = 1,
+        .targets = &color_targ,
+    };
+    WGPURenderPipelineDescriptor const pipe_desc{
+        .vertex{
+            .module = shader,
+            .entryPoint{quant ? "vs_quantized" : "vs_float", WGPU_STRLEN},
+            .constantCount = size(constants),
+            .constants = constants,
+            .bufferCount = 1,
+            .buffers = &vert_buf_layout,
+        },
+        .primitive{
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .frontFace = WGPUFrontFace_CCW,
+            .cullMode = WGPUCullMode_None,
+        },
+        .depthStencil = &depth_state,
+        .multisample{
+            .count = 1,
+            .mask = ~0u,
+        },
+        .fragment = &frag_state,
+    };
+    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+}
+
+void render_frame(
+    WGPUDevice const device,
+    WGPURenderPipeline const pipeline,
+    WGPUBuffer const vertices,
+    WGPUBuffer const indices,
+    u32 const index_count,
+    OffscreenTarget const& target)
+{
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+    {
+        WGPURenderPassColorAttachment const color_att{
+            .view = target.color_view,
+            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+            .loadOp = WGPULoadOp_Clear,
+            .storeOp = WGPUStoreOp_Store,
+            .clearValue{0.15, 0.15, 0.15, 1.0},
+        };
+        WGPURenderPassDepthStencilAttachment const depth_att{
+            .view = target.depth_view,
+            .depthLoadOp = WGPULoadOp_Clear,
+            .depthStoreOp = WGPUStoreOp_Discard,
+            .depthClearValue = 1.0f,
+        };
+        WGPURenderPassDescriptor const desc{
+            .colorAttachmentCount = 1,
+            .colorAttachments = &color_att,
+            .depthStencilAttachment = &depth_att,
+        };
+        WGPURenderPassEncoder const pass = wgpuCommandEncoderBeginRenderPass(cmd_encoder, &desc);
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        wgpuRenderPassEncoderSetVertexBuffer(pass, 0, vertices, 0, wgpuBufferGetSize(vertices));
+        wgpuRenderPassEncoderSetIndexBuffer(
+            pass,
+            indices,
+            WGPUIndexFormat_Uint32,
+            0,
+            wgpuBufferGetSize(indices));
+        wgpuRenderPassEncoderDrawIndexed(pass, index_count, draws_per_frame, 0, 0, 0);
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+    }
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+    wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &cmds);
+}
+
+// Returns the average wall time per frame including GPU work
+f64 measure_frames(
+    GpuContext const& gpu,
+    MeshBuffers const& mesh,
+    VertexQuantization const* const quant,
+    OffscreenTarget const& target)
+{
+    WGPURenderPipeline const pipeline = make_pipeline(gpu.device, quant);
+    assert(pipeline);
+    auto const drop_pipeline = defer([=]() { wgpuRenderPipelineRelease(pipeline); });
+
+    WGPUBuffer const vertices = make_buffer(
+        gpu.device,
+        mesh.vertices.data(),
+        mesh.vertices.size(),
+        WGPUBufferUsage_Vertex);
+    auto const drop_vertices = defer([=]() { wgpuBufferRelease(vertices); });
+
+    WGPUBuffer const indices = make_buffer(
+        gpu.device,
+        mesh.indices.data(),
+        mesh.indices.size() * sizeof(u32),
+        WGPUBufferUsage_Index);
+    auto const drop_indices = defer([=]() { wgpuBufferRelease(indices); });
+
+    u32 const index_count = u32(mesh.indices.size());
+    f64 total_ms = 0.0;
+
+    for (usize i = 0; i < warmup_frame_count + frame_count; ++i)
+    {
+        Stopwatch const timer{};
+        render_frame(gpu.device, pipeline, vertices, indices, index_count, target);
+        poll_device(gpu.device, true);
+
+        if (i >= warmup_frame_count)
+            total_ms += timer.wall_ms();
+    }
+
+    return total_ms / frame_count;
+}
+
+} // namespace
+
+void run_vertex_quantization_benchmark(GpuContext const& gpu)
+{
+    MeshBuffers const mesh = make_sphere(sphere_stacks, sphere_slices);
+
+    MeshBuffers quantized{};
+    Stopwatch const quant_timer{};
+    VertexQuantization const quant = quantize_vertices(mesh, vertex_attributes, quantized);
+    f64 const quant_ms = quant_timer.wall_ms();
+
+    fmt::println(
+        "\tsphere {}x{} ({} vertices, {} triangles), quantized in {:.2f} ms",
+        sphere_stacks,
+        sphere_slices,
+        mesh.get_vertex_count(),
+        mesh.get_triangle_count(),
+        quant_ms);
+    fmt::println(
+        "\tmax error: position {:.2e}, normal {:.3f} deg, tex coords {:.2e} ({})",
+        quant.max_position_error / quant.extent,
+        quant.max_normal_error,
+        quant.max_tex_coords_error,
+        quant.is_within({}) ? "within tolerance" : "exceeds tolerance");
+
+    OffscreenTarget target = OffscreenTarget::make(
+        gpu.device,
+        target_size,
+        target_size,
+        color_format,
+        depth_format);
+    auto const drop_target = defer([&]() { OffscreenTarget::release(target); });
+
+    fmt::println("\t{} draws per frame", draws_per_frame);
+    fmt::println(
+        "\t{:<12} {:>8} {:>14} {:>14} {:>16}",
+        "format",
+        "stride",
+        "vertex MB",
+        "frame (ms)",
+        "Mverts/s");
+
+    auto const print_row = [&](char const* name, MeshBuffers const& m, f64 const frame_ms) {
+        f64 const vert_count = f64(m.get_vertex_count()) * draws_per_frame;
+        fmt::println(
+            "\t{:<12} {:>8} {:>14.2f} {:>14.3f} {:>16.1f}",
+            name,
+            m.vertex_stride,
+            f64(m.vertices.size()) / (1024.0 * 1024.0),
+            frame_ms,
+            vert_count / (frame_ms * 1.0e3));
+    };
+    print_row("float", mesh, measure_frames(gpu, mesh, nullptr, target));
+    print_row("quantized", quantized, measure_frames(gpu, quantized, &quant, target));
+}
+
+} // namespace wgpu::sandbox
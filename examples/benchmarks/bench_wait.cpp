@@ -0,0 +1,260 @@
+#include <cassert>
+#include <thread>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+#include <dr/memory.hpp>
+
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr char const* shader_src = R"(
+override iterations: u32 = 1u;
+
+@group(0) @binding(0) var<storage, read_write> vals: array<f32>;
+
+@compute @workgroup_size(64, 1, 1)
+fn compute_main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+    let i = global_id.x;
+
+    if(i >= arrayLength(&vals)) {
+        return;
+    }
+
+    var x = vals[i];
+    for (var k = 0u; k < iterations; k++) {
+        x = x * 0.999 + 0.001 * f32(k);
+    }
+    vals[i] = x;
+}
+)";
+
+constexpr u32 element_count = 1 << 18;
+constexpr u32 workgroup_size = 64;
+constexpr f64 iteration_count = 4096;
+constexpr int trial_count = 5;
+
+enum class Strategy : u8
+{
+    Spin,
+    PollBlocking,
+    PollBackoff,
+    Submission,
+    SubmissionTimeout,
+};
+
+char const* to_string(Strategy const value)
+{
+    static constexpr char const* names[]{
+        "spin (process events + yield)",
+        "device poll (blocking)",
+        "device poll + backoff",
+        "submission poll",
+        "submission poll (timeout)",
+    };
+    return names[int(value)];
+}
+
+WGPUComputePipeline make_pipeline(WGPUDevice const device)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUConstantEntry const constants[]{
+        {
+            .key{"iterations", WGPU_STRLEN},
+            .value = iteration_count,
+        },
+    };
+    WGPUComputePipelineDescriptor const pipe_desc{
+        .compute{
+            .module = shader,
+            .entryPoint{"compute_main", WGPU_STRLEN},
+            .constantCount = 1,
+            .constants = constants,
+        },
+    };
+    return wgpuDeviceCreateComputePipeline(device, &pipe_desc);
+}
+
+WGPUBindGroup make_bind_group(
+    WGPUDevice const device,
+    WGPUComputePipeline const pipeline,
+    WGPUBuffer const buffer)
+{
+    WGPUBindGroupLayout const layout = wgpuComputePipelineGetBindGroupLayout(pipeline, 0);
+    auto const drop_layout = defer([=]() { wgpuBindGroupLayoutRelease(layout); });
+
+    WGPUBindGroupEntry const entries[]{
+        {
+            .binding = 0,
+            .buffer = buffer,
+            .size = wgpuBufferGetSize(buffer),
+        },
+    };
+    WGPUBindGroupDescriptor const desc{
+        .layout = layout,
+        .entryCount = 1,
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroup(device, &desc);
+}
+
+void submit_dispatch(
+    WGPUDevice const device,
+    WGPUComputePipeline const pipeline,
+    WGPUBindGroup const bind_group)
+{
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+    WGPUComputePassEncoder const pass = wgpuCommandEncoderBeginComputePass(cmd_encoder, nullptr);
+    wgpuComputePassEncoderSetPipeline(pass, pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, nullptr);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, element_count / workgroup_size, 1, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+    wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &cmds);
+}
+
+void wait_for_work_done(GpuContext const& gpu, Strategy const strategy)
+{
+    WaitGroup group{};
+    group.add();
+
+    WGPUQueueWorkDoneCallbackInfo cb_info{};
+    cb_info.userdata1 = &group;
+    cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+    cb_info.callback = //
+        [](WGPUQueueWorkDoneStatus /*status*/, void* userdata1, void* /*userdata2*/) {
+            static_cast<WaitGroup*>(userdata1)->done();
+        };
+    wgpuQueueOnSubmittedWorkDone(wgpuDeviceGetQueue(gpu.device), cb_info);
+
+    switch (strategy)
+    {
+        case Strategy::Spin:
+        {
+            // First implementation of wait_for_condition
+            while (!group.is_done())
+            {
+                wgpuInstanceProcessEvents(gpu.instance);
+                std::this_thread::yield();
+            }
+            break;
+        }
+        case Strategy::PollBlocking:
+        {
+            // Blocks until the whole queue is idle rather than just the awaited work
+            while (!group.is_done())
+                poll_device(gpu.device, true);
+            break;
+        }
+        case Strategy::PollBackoff:
+        {
+            // Previous implementation of wait_for_condition. Never blocks but can oversleep by up
+            // to the longest backoff.
+            Backoff backoff{};
+            while (!group.is_done())
+            {
+                poll_device(gpu.device, false);
+                if (!group.is_done())
+                    backoff.pause();
+            }
+            break;
+        }
+        case Strategy::Submission:
+        {
+            // Blocks until the latest submission is done without waiting on later ones
+            group.wait(gpu.device);
+            break;
+        }
+        case Strategy::SubmissionTimeout:
+        {
+            constexpr u64 timeout_ns = 60'000'000'000;
+            [[maybe_unused]] WGPUWaitStatus const status = group.wait(gpu.device, timeout_ns);
+            assert(status == WGPUWaitStatus_Success);
+            break;
+        }
+    }
+}
+
+} // namespace
+
+void run_wait_benchmark(GpuContext const& gpu)
+{
+    WGPUComputePipeline const pipeline = make_pipeline(gpu.device);
+    assert(pipeline);
+    auto const drop_pipeline = defer([=]() { wgpuComputePipelineRelease(pipeline); });
+
+    WGPUBufferDescriptor const buf_desc{
+        .usage = WGPUBufferUsage_Storage,
+        .size = element_count * sizeof(f32),
+    };
+    WGPUBuffer const buffer = wgpuDeviceCreateBuffer(gpu.device, &buf_desc);
+    assert(buffer);
+    auto const drop_buffer = defer([=]() { wgpuBufferRelease(buffer); });
+
+    WGPUBindGroup const bind_group = make_bind_group(gpu.device, pipeline, buffer);
+    assert(bind_group);
+    auto const drop_bind_group = defer([=]() { wgpuBindGroupRelease(bind_group); });
+
+    // Warm up
+    submit_dispatch(gpu.device, pipeline, bind_group);
+    wait_for_work_done(gpu, Strategy::Submission);
+
+    fmt::println("\t{:<32} {:>12} {:>12} {:>8}", "strategy", "wall (ms)", "cpu (ms)", "cpu %");
+
+    for (Strategy const strategy :
+         {Strategy::Spin,
+          Strategy::PollBlocking,
+          Strategy::PollBackoff,
+          Strategy::Submission,
+          Strategy::SubmissionTimeout})
+    {
+        f64 wall_ms = 0.0;
+        f64 cpu_ms = 0.0;
+
+        for (int i = 0; i < trial_count; ++i)
+        {
+            submit_dispatch(gpu.device, pipeline, bind_group);
+
+            Stopwatch const timer{};
+            wait_for_work_done(gpu, strategy);
+            wall_ms += timer.wall_ms();
+            cpu_ms += timer.cpu_ms();
+        }
+
+        wall_ms /= trial_count;
+        cpu_ms /= trial_count;
+        fmt::println(
+            "\t{:<32} {:>12.2f} {:>12.2f} {:>7.1f}%",
+            to_string(strategy),
+            wall_ms,
+            cpu_ms,
+            100.0 * cpu_ms / wall_ms);
+    }
+}
+
+} // namespace wgpu::sandbox
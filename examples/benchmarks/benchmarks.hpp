@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+
+#include <dr/basic_types.hpp>
+
+#include "../dr_shim.hpp"
+#include "../example_base.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Measures wall and process CPU time over a scope
+struct Stopwatch
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point wall_start{Clock::now()};
+    std::clock_t cpu_start{std::clock()};
+
+    f64 wall_ms() const
+    {
+        return std::chrono::duration<f64, std::milli>(Clock::now() - wall_start).count();
+    }
+
+    f64 cpu_ms() const { return 1000.0 * f64(std::clock() - cpu_start) / CLOCKS_PER_SEC; }
+};
+
+void run_wait_benchmark(GpuContext const& gpu);
+
+void run_readback_benchmark(GpuContext const& gpu);
+
+void run_upload_benchmark(GpuContext const& gpu);
+
+void run_suballoc_benchmark(GpuContext const& gpu);
+
+void run_draw_benchmark(GpuContext const& gpu);
+
+void run_bind_group_benchmark(GpuContext const& gpu);
+
+void run_present_benchmark(GpuContext const& gpu);
+
+void run_bundles_benchmark(GpuContext const& gpu);
+
+void run_bundle_cache_benchmark(GpuContext const& gpu);
+
+void run_culling_benchmark(GpuContext const& gpu);
+
+void run_mesh_optimizer_benchmark(GpuContext const& gpu);
+
+void run_vertex_quantization_benchmark(GpuContext const& gpu);
+
+void run_mesh_file_benchmark(GpuContext const& gpu);
+
+void run_import_benchmark(GpuContext const& gpu);
+
+void run_mipmaps_benchmark(GpuContext const& gpu);
+
+void run_asset_pack_benchmark(GpuContext const& gpu);
+
+} // namespace wgpu::sandbox
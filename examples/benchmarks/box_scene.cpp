@@ -0,0 +1,313 @@
+#include "box_scene.hpp"
+
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+#include <dr/memory.hpp>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+// Based on unlit_texture.wgsl in textured-mesh without per-instance attributes
+constexpr char const* shader_src = R"(
+@group(0) @binding(0) var color_texture: texture_2d<f32>;
+@group(0) @binding(1) var color_sampler: sampler;
+
+struct Uniforms {
+    local_to_clip : mat4x4<f32>,
+};
+
+@group(0) @binding(2) var<uniform> uniforms : Uniforms;
+
+struct VertexOut {
+    @builtin(position) position: vec4f,
+    @location(0) tex_coords: vec2f,
+};
+
+@vertex
+fn vs_main(@location(0) position: vec3f, @location(1) tex_coords: vec2f) -> VertexOut {
+    return VertexOut(uniforms.local_to_clip * vec4f(position, 1.0), tex_coords);
+}
+
+@fragment
+fn fs_main(@location(0) tex_coords: vec2f) -> @location(0) vec4f {
+    return textureSample(color_texture, color_sampler, tex_coords);
+}
+)";
+
+} // namespace
+
+BoxScene BoxScene::make(WGPUDevice const device)
+{
+    // Format: x, y, z, u, v
+    static constexpr f32 vertices[][5]{
+        {0.0, 0.0, 0.0, 0.0, 0.0},
+        {1.0, 0.0, 0.0, 1.0, 0.0},
+        {0.0, 1.0, 0.0, 0.0, 1.0},
+        {1.0, 1.0, 0.0, 1.0, 1.0},
+        {0.0, 0.0, 1.0, 1.0, 1.0},
+        {1.0, 0.0, 1.0, 0.0, 1.0},
+        {0.0, 1.0, 1.0, 1.0, 0.0},
+        {1.0, 1.0, 1.0, 0.0, 0.0},
+    };
+    static constexpr u16 faces[][3]{
+        {0, 2, 1},
+        {1, 2, 3},
+        {4, 5, 6},
+        {5, 7, 6},
+        {0, 1, 4},
+        {1, 5, 4},
+        {2, 6, 3},
+        {3, 6, 7},
+        {0, 4, 2},
+        {2, 4, 6},
+        {1, 3, 5},
+        {3, 7, 5},
+    };
+
+    BoxScene result{};
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+    auto const make_buffer = [&](void const* data, usize size, WGPUBufferUsage usage) {
+        WGPUBufferDescriptor const desc{
+            .usage = usage | WGPUBufferUsage_CopyDst,
+            .size = size,
+        };
+        WGPUBuffer const buffer = wgpuDeviceCreateBuffer(device, &desc);
+        wgpuQueueWriteBuffer(queue, buffer, 0, data, size);
+        return buffer;
+    };
+    result.vertices = make_buffer(vertices, sizeof(vertices), WGPUBufferUsage_Vertex);
+    result.indices = make_buffer(faces, sizeof(faces), WGPUBufferUsage_Index);
+    result.index_count = sizeof(faces) / sizeof(u16);
+
+    // 2x2 checker texture
+    static constexpr u8 texels[]{
+        255, 255, 255, 255, 64, 64, 64, 255, //
+        64, 64, 64, 255, 255, 255, 255, 255, //
+    };
+    WGPUExtent3D const size{2, 2, 1};
+    WGPUTextureDescriptor const tex_desc{
+        .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+        .dimension = WGPUTextureDimension_2D,
+        .size = size,
+        .format = WGPUTextureFormat_RGBA8Unorm,
+        .mipLevelCount = 1,
+        .sampleCount = 1,
+    };
+    result.texture = wgpuDeviceCreateTexture(device, &tex_desc);
+
+    WGPUTexelCopyTextureInfo const copy_info{.texture = result.texture};
+    WGPUTexelCopyBufferLayout const copy_layout{.bytesPerRow = 8, .rowsPerImage = 2};
+    wgpuQueueWriteTexture(queue, &copy_info, texels, sizeof(texels), &copy_layout, &size);
+
+    result.texture_view = wgpuTextureCreateView(result.texture, nullptr);
+
+    WGPUSamplerDescriptor const sampler_desc{
+        .magFilter = WGPUFilterMode_Nearest,
+        .minFilter = WGPUFilterMode_Nearest,
+        .maxAnisotropy = 1,
+    };
+    result.sampler = wgpuDeviceCreateSampler(device, &sampler_desc);
+
+    return result;
+}
+
+void BoxScene::release(BoxScene& scene)
+{
+    wgpuSamplerRelease(scene.sampler);
+    wgpuTextureViewRelease(scene.texture_view);
+    wgpuTextureRelease(scene.texture);
+    wgpuBufferRelease(scene.indices);
+    wgpuBufferRelease(scene.vertices);
+    scene = {};
+}
+
+WGPUBindGroupLayout make_box_bind_group_layout(
+    WGPUDevice const device,
+    bool const has_dynamic_offset)
+{
+    WGPUBindGroupLayoutEntry const entries[]{
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Fragment,
+            .texture{
+                .sampleType = WGPUTextureSampleType_Float,
+                .viewDimension = WGPUTextureViewDimension_2D,
+            },
+        },
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Fragment,
+            .sampler{.type = WGPUSamplerBindingType_Filtering},
+        },
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer{
+                .type = WGPUBufferBindingType_Uniform,
+                .hasDynamicOffset = has_dynamic_offset,
+                .minBindingSize = sizeof(BoxUniforms),
+            },
+        },
+    };
+    WGPUBindGroupLayoutDescriptor const desc{
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroupLayout(device, &desc);
+}
+
+WGPUBindGroup make_box_bind_group(
+    WGPUDevice const device,
+    WGPUBindGroupLayout const layout,
+    BoxScene const& scene,
+    WGPUBuffer const uniforms)
+{
+    WGPUBindGroupEntry const entries[]{
+        {
+            .binding = 0,
+            .textureView = scene.texture_view,
+        },
+        {
+            .binding = 1,
+            .sampler = scene.sampler,
+        },
+        {
+            .binding = 2,
+            .buffer = uniforms,
+            .size = sizeof(BoxUniforms),
+        },
+    };
+    WGPUBindGroupDescriptor const desc{
+        .layout = layout,
+        .entryCount = size(entries),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroup(device, &desc);
+}
+
+WGPURenderPipeline make_box_pipeline(
+    WGPUDevice const device,
+    WGPUBindGroupLayout const bind_layout)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUPipelineLayoutDescriptor const layout_desc{
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = &bind_layout,
+    };
+    WGPUPipelineLayout const layout = wgpuDeviceCreatePipelineLayout(device, &layout_desc);
+    auto const drop_layout = defer([=]() { wgpuPipelineLayoutRelease(layout); });
+
+    WGPUVertexAttribute const vert_attrs[]{
+        {
+            .format = WGPUVertexFormat_Float32x3,
+            .offset = 0,
+            .shaderLocation = 0,
+        },
+        {
+            .format = WGPUVertexFormat_Float32x2,
+            .offset = sizeof(f32[3]),
+            .shaderLocation = 1,
+        },
+    };
+    WGPUVertexBufferLayout const vert_buf_layout{
+        .stepMode = WGPUVertexStepMode_Vertex,
+        .arrayStride = sizeof(f32[5]),
+        .attributeCount = size(vert_attrs),
+        .attributes = vert_attrs,
+    };
+
+    WGPUDepthStencilState const depth_state{
+        .format = box_depth_format,
+        .depthWriteEnabled = WGPUOptionalBool_True,
+        .depthCompare = WGPUCompareFunction_LessEqual,
+    };
+    WGPUColorTargetState const color_targ{
+        .format = box_color_format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState const frag_state{
+        .module = shader,
+        .entryPoint{"fs_main", WGPU_STRLEN},
+        .targetCount = 1,
+        .targets = &color_targ,
+    };
+    WGPURenderPipelineDescriptor const pipe_desc{
+        .layout = layout,
+        .vertex{
+            .module = shader,
+            .entryPoint{"vs_main", WGPU_STRLEN},
+            .bufferCount = 1,
+            .buffers = &vert_buf_layout,
+        },
+        .primitive{
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .frontFace = WGPUFrontFace_CCW,
+            .cullMode = WGPUCullMode_None,
+        },
+        .depthStencil = &depth_state,
+        .multisample{
+            .count = 1,
+            .mask = ~0u,
+        },
+        .fragment = &frag_state,
+    };
+    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+}
+
+void get_box_transform(
+    u32 const index,
+    u32 const grid_size,
+    usize const frame,
+    BoxUniforms& result)
+{
+    f32 const scale = 2.0f / f32(grid_size);
+    f32 const shift = 0.001f * f32(frame % 100);
+
+    result = {};
+    result.local_to_clip[0] = scale;
+    result.local_to_clip[5] = scale;
+    result.local_to_clip[10] = 0.5f * scale;
+    result.local_to_clip[12] = -1.0f + scale * f32(index % grid_size) + shift;
+    result.local_to_clip[13] = -1.0f + scale * f32(index / grid_size);
+    result.local_to_clip[14] = 0.25f;
+    result.local_to_clip[15] = 1.0f;
+}
+
+WGPURenderPassEncoder begin_box_pass(
+    WGPUCommandEncoder const encoder,
+    OffscreenTarget const& target)
+{
+    WGPURenderPassColorAttachment const color_att{
+        .view = target.color_view,
+        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+        .loadOp = WGPULoadOp_Clear,
+        .storeOp = WGPUStoreOp_Store,
+        .clearValue{0.15, 0.15, 0.15, 1.0},
+    };
+    WGPURenderPassDepthStencilAttachment const depth_att{
+        .view = target.depth_view,
+        .depthLoadOp = WGPULoadOp_Clear,
+        .depthStoreOp = WGPUStoreOp_Discard,
+        .depthClearValue = 1.0f,
+    };
+    WGPURenderPassDescriptor const desc{
+        .colorAttachmentCount = 1,
+        .colorAttachments = &color_att,
+        .depthStencilAttachment = &depth_att,
+    };
+    return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+
+#include <wgpu_offscreen.hpp>
+
+#include "../dr_shim.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Textured unit box drawn many times over with a different transform per draw. Shared by draw
+// submission benchmarks.
+
+constexpr WGPUTextureFormat box_color_format = WGPUTextureFormat_RGBA8Unorm;
+constexpr WGPUTextureFormat box_depth_format = WGPUTextureFormat_Depth32Float;
+
+struct BoxUniforms
+{
+    f32 local_to_clip[16];
+};
+
+struct BoxScene
+{
+    WGPUBuffer vertices;
+    WGPUBuffer indices;
+    u32 index_count;
+    WGPUTexture texture;
+    WGPUTextureView texture_view;
+    WGPUSampler sampler;
+
+    static BoxScene make(WGPUDevice device);
+
+    static void release(BoxScene& scene);
+};
+
+WGPUBindGroupLayout make_box_bind_group_layout(WGPUDevice device, bool has_dynamic_offset);
+
+WGPUBindGroup make_box_bind_group(
+    WGPUDevice device,
+    WGPUBindGroupLayout layout,
+    BoxScene const& scene,
+    WGPUBuffer uniforms);
+
+WGPURenderPipeline make_box_pipeline(WGPUDevice device, WGPUBindGroupLayout bind_layout);
+
+// Lays boxes out on a square grid in clip space, shifting them a little each frame
+void get_box_transform(u32 index, u32 grid_size, usize frame, BoxUniforms& result);
+
+WGPURenderPassEncoder begin_box_pass(WGPUCommandEncoder encoder, OffscreenTarget const& target);
+
+} // namespace wgpu::sandbox
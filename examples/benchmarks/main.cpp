@@ -0,0 +1,111 @@
+#include <cstring>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/container_utils.hpp>
+#include <dr/defer.hpp>
+
+#include <wgpu_utils.hpp>
+
+#include "benchmarks.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+struct Benchmark
+{
+    char const* name;
+    char const* desc;
+    void (*run)(GpuContext const& gpu);
+};
+
+constexpr Benchmark benchmarks[]{
+    {"wait", "CPU time spent waiting on a long compute dispatch", run_wait_benchmark},
+    {"readback", "Serial vs. pipelined buffer readback throughput", run_readback_benchmark},
+    {"upload", "CPU cost of uploading 10k small objects per frame", run_upload_benchmark},
+    {"suballoc", "Buffer per mesh vs. sub-allocation from a pool", run_suballoc_benchmark},
+    {"draw", "CPU encode time for 10k textured boxes", run_draw_benchmark},
+    {"bindgroup", "Bind group creation vs. cache lookup on rebind", run_bind_group_benchmark},
+    {"present", "Frame pacing and latency under each present mode", run_present_benchmark},
+    {"bundles", "Draw recording into render bundles across threads", run_bundles_benchmark},
+    {"bundlecache", "Re-encoding static draws vs. bundle replay", run_bundle_cache_benchmark},
+    {"culling", "CPU culling and draws vs. GPU culling and indirect draw", run_culling_benchmark},
+    {"meshopt", "Vertex cache, overdraw and fetch optimization", run_mesh_optimizer_benchmark},
+    {"quantize", "Float vs quantized vertex formats", run_vertex_quantization_benchmark},
+    {"meshload", "Binary mesh file load and upload", run_mesh_file_benchmark},
+    {"import", "OBJ and glTF import across thread counts", run_import_benchmark},
+    {"mipmaps", "GPU mip generation and sampling with and without mips", run_mipmaps_benchmark},
+    {"assetpack", "Loading 10k small assets from loose files vs. a pack", run_asset_pack_benchmark},
+};
+
+void print_usage()
+{
+    fmt::println("Usage: benchmarks [--fallback] [name...]");
+    fmt::println("Available benchmarks:");
+    for (Benchmark const& bench : benchmarks)
+        fmt::println("\t{}: {}", bench.name, bench.desc);
+}
+
+bool is_selected(Benchmark const& bench, int const argc, char** const argv)
+{
+    bool any_named = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] == '-')
+            continue;
+
+        if (std::strcmp(argv[i], bench.name) == 0)
+            return true;
+
+        any_named = true;
+    }
+
+    // Run everything if no benchmarks were named
+    return !any_named;
+}
+
+bool has_flag(char const* const flag, int const argc, char** const argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], flag) == 0)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+} // namespace wgpu::sandbox
+
+int main(int argc, char** argv)
+{
+    using namespace wgpu::sandbox;
+
+    if (has_flag("--help", argc, argv))
+    {
+        print_usage();
+        return 0;
+    }
+
+    WGPURequestAdapterOptions const adapter_opts{
+        .forceFallbackAdapter = has_flag("--fallback", argc, argv),
+    };
+    GpuContext gpu = GpuContext::make(nullptr, &adapter_opts);
+    auto const _ = defer([&]() { GpuContext::release(gpu); });
+    report_adapter_properties(gpu.adapter);
+
+    for (Benchmark const& bench : benchmarks)
+    {
+        if (!is_selected(bench, argc, argv))
+            continue;
+
+        fmt::println("\n[{}] {}", bench.name, bench.desc);
+        bench.run(gpu);
+    }
+
+    return 0;
+}
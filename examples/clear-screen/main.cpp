@@ -21,72 +21,12 @@ namespace wgpu::sandbox
 namespace
 {
 
-struct RenderPass
-{
-    WGPURenderPassEncoder encoder;
-    WGPUTextureView surface_view;
-
-    static RenderPass begin(WGPUCommandEncoder const cmd_encoder, WGPUSurface const surface)
-    {
-        RenderPass result{};
-
-        result.surface_view = make_view(surface);
-        assert(result.surface_view);
-
-        result.encoder = begin(cmd_encoder, result.surface_view);
-        assert(result.encoder);
-
-        return result;
-    }
-
-    static void end(RenderPass& pass)
-    {
-        wgpuRenderPassEncoderEnd(pass.encoder);
-        wgpuRenderPassEncoderRelease(pass.encoder);
-        wgpuTextureViewRelease(pass.surface_view);
-        pass = {};
-    }
-
-  private:
-    static WGPUTextureView make_view(WGPUSurface const surface)
-    {
-        WGPUSurfaceTexture srf_tex;
-        wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
-        assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
-
-        WGPUTextureViewDescriptor const desc{
-            .mipLevelCount = 1,
-            .arrayLayerCount = 1,
-        };
-        return wgpuTextureCreateView(srf_tex.texture, &desc);
-    }
-
-    static WGPURenderPassEncoder begin(
-        WGPUCommandEncoder const encoder,
-        WGPUTextureView const surface_view)
-    {
-        WGPURenderPassColorAttachment color_atts[]{
-            {
-                .view = surface_view,
-                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue{1.0, 0.0, 0.5, 1.0},
-            },
-        };
-        WGPURenderPassDescriptor const desc{
-            .colorAttachmentCount = 1,
-            .colorAttachments = color_atts,
-        };
-        return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-    }
-};
-
 struct AppState
 {
     GLFWwindow* window;
     GpuContext gpu;
-    usize frame_count;
+    FramePacer pacer;
+    u64 frames_reported;
 };
 
 AppState state{};
@@ -137,10 +77,14 @@ void init_app()
         state.gpu.config_surface(width, height);
     });
 #endif
+
+    // Limit the number of frames the CPU can get ahead of the GPU
+    state.pacer = FramePacer::make(state.gpu.device, 2);
 }
 
 void deinit_app()
 {
+    FramePacer::release(state.pacer);
     GpuContext::release(state.gpu);
     glfwDestroyWindow(state.window);
     glfwTerminate();
@@ -158,7 +102,7 @@ int main(int /*argc*/, char** /*argv*/)
     auto const _ = defer([]() { deinit_app(); });
 
     // Main loop body
-    constexpr auto loop_cb = [](void* /*userdata*/) {
+    constexpr auto loop_cb = [](void* /*userdata*/, u32 /*frame_slot*/) {
         glfwPollEvents();
 
         // Create a command encoder from the device
@@ -170,7 +114,8 @@ int main(int /*argc*/, char** /*argv*/)
 
         // Render pass
         {
-            RenderPass pass = RenderPass::begin(cmd_encoder, state.gpu.surface);
+            RenderPass pass =
+                RenderPass::begin(cmd_encoder, state.gpu.surface, nullptr, {1.0, 0.0, 0.5, 1.0});
             auto const end_pass = defer([&]() { RenderPass::end(pass); });
 
             // NOTE(dr): Render pass clears the screen by default
@@ -185,32 +130,21 @@ int main(int /*argc*/, char** /*argv*/)
         WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
         wgpuQueueSubmit(queue, 1, &cmds);
 
-        // Register callback that fires when queued work is done
-        WGPUQueueWorkDoneCallbackInfo cb_info = {};
-        cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
-        cb_info.callback =
-#ifdef __EMSCRIPTEN__
-            // NOTE(dr): Callback from webgpu.h in Emdawnwebgpu has a different signature
-            [](WGPUQueueWorkDoneStatus const status,
-               WGPUStringView /*msg*/,
-               void* /*userdata1*/,
-               void* /*userdata2*/) {
-#else
-            [](WGPUQueueWorkDoneStatus const status, void* /*userdata1*/, void* /*userdata2*/) {
-#endif
-                if (state.frame_count % 100 == 0)
-                {
-                    fmt::print(
-                        "Finished frame {} with status: {}\n",
-                        state.frame_count,
-                        to_string(status));
-                }
-                ++state.frame_count;
-            };
-        wgpuQueueOnSubmittedWorkDone(queue, cb_info);
+        // Report progress once the GPU has finished every 100th frame
+        if (state.pacer.frames_completed >= state.frames_reported + 100)
+        {
+            state.frames_reported = state.pacer.frames_completed;
+            fmt::print("Finished frame {}\n", state.frames_reported);
+        }
     };
 
-    MainLoop{state.gpu.surface, state.window, loop_cb}.begin();
+    MainLoop const loop{
+        .surface = state.gpu.surface,
+        .window = state.window,
+        .callback = loop_cb,
+        .pacer = &state.pacer,
+    };
+    loop.begin();
 
     return 0;
 }
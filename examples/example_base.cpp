@@ -1,6 +1,8 @@
 #include "example_base.hpp"
 
 #include <cassert>
+#include <cfloat>
+#include <cstddef>
 
 #include <fmt/core.h>
 
@@ -9,6 +11,7 @@
 #endif
 
 #include <wgpu_imgui.hpp>
+#include <wgpu_ktx2.hpp>
 
 namespace wgpu::sandbox
 {
@@ -53,6 +56,76 @@ T const* or_default(T const* obj)
     return obj ? obj : get_default<T>();
 }
 
+WGPUDevice request_device_with_defaults(
+    WGPUInstance const instance,
+    WGPUAdapter const adapter,
+    WGPUDeviceDescriptor const* const device_desc)
+{
+    if (device_desc)
+        return request_device(instance, adapter, device_desc);
+
+    // Enable timestamp queries by default if they're supported so passes can be profiled. Also
+    // enable any texture compression formats so compressed textures can be uploaded directly.
+    WGPUFeatureName features[4]{};
+    std::size_t feature_count = get_texture_compression_features(adapter, features);
+
+    WGPUFeatureName const timestamp_query = WGPUFeatureName_TimestampQuery;
+    if (wgpuAdapterHasFeature(adapter, timestamp_query))
+        features[feature_count++] = timestamp_query;
+
+    WGPUDeviceDescriptor desc = *get_default<WGPUDeviceDescriptor>();
+    desc.requiredFeatureCount = feature_count;
+    desc.requiredFeatures = features;
+
+    return request_device(instance, adapter, &desc);
+}
+
+WGPUTextureView make_surface_view(WGPUSurface const surface)
+{
+    WGPUSurfaceTexture srf_tex;
+    wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
+    assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
+
+    WGPUTextureViewDescriptor const desc{
+        .mipLevelCount = 1,
+        .arrayLayerCount = 1,
+    };
+    return wgpuTextureCreateView(srf_tex.texture, &desc);
+}
+
+WGPURenderPassEncoder begin_render_pass(
+    WGPUCommandEncoder const encoder,
+    WGPUTextureView const color_view,
+    WGPUTextureView const depth_view,
+    WGPUColor const& clear_color,
+    WGPUPassTimestampWrites const* const timestamp_writes)
+{
+    WGPURenderPassColorAttachment color_atts[]{
+        {
+            .view = color_view,
+            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+            .loadOp = WGPULoadOp_Clear,
+            .storeOp = WGPUStoreOp_Store,
+            .clearValue = clear_color,
+        },
+    };
+    WGPURenderPassDepthStencilAttachment depth_atts[]{
+        {
+            .view = depth_view,
+            .depthLoadOp = WGPULoadOp_Clear,
+            .depthStoreOp = WGPUStoreOp_Store,
+            .depthClearValue = 1.0f,
+        },
+    };
+    WGPURenderPassDescriptor const desc{
+        .colorAttachmentCount = 1,
+        .colorAttachments = color_atts,
+        .depthStencilAttachment = depth_view ? depth_atts : nullptr,
+        .timestampWrites = timestamp_writes,
+    };
+    return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+}
+
 } // namespace
 
 GpuContext GpuContext::make(
@@ -68,7 +141,7 @@ GpuContext GpuContext::make(
     result.adapter = request_adapter(result.instance, or_default(adapter_opts));
     assert(result.adapter);
 
-    result.device = request_device(result.instance, result.adapter, or_default(device_desc));
+    result.device = request_device_with_defaults(result.instance, result.adapter, device_desc);
     assert(result.device);
 
     return result;
@@ -93,9 +166,24 @@ GpuContext GpuContext::make(
     result.adapter = request_adapter(result.instance, &opts);
     assert(result.adapter);
 
-    result.device = request_device(result.instance, result.adapter, or_default(device_desc));
+    result.device = request_device_with_defaults(result.instance, result.adapter, device_desc);
     assert(result.device);
 
+    // Pick the surface format and present mode from what the surface supports
+    {
+        WGPUSurfaceCapabilities caps{};
+        wgpuSurfaceGetCapabilities(result.surface, result.adapter, &caps);
+
+        WGPUTextureFormat const preferred_formats[]{
+            default_surface_format,
+            WGPUTextureFormat_RGBA8Unorm,
+        };
+        result.surface_format = select_surface_format(caps, preferred_formats, 2);
+        result.present_mode = select_present_mode(caps, default_present_policy);
+
+        wgpuSurfaceCapabilitiesFreeMembers(caps);
+    }
+
     result.config_surface(surface_src.window);
 
     return result;
@@ -121,11 +209,14 @@ void GpuContext::config_surface(int const width, int const height)
         config.device = device;
         config.width = width;
         config.height = height;
-        config.format = default_surface_format;
+        config.format = surface_format;
         config.usage = WGPUTextureUsage_RenderAttachment;
-        config.presentMode = default_surface_present_mode;
+        config.presentMode = present_mode;
     }
     wgpuSurfaceConfigure(surface, &config);
+
+    surface_width = width;
+    surface_height = height;
 }
 
 void GpuContext::config_surface(GLFWwindow* const window)
@@ -135,6 +226,33 @@ void GpuContext::config_surface(GLFWwindow* const window)
     config_surface(width, height);
 }
 
+bool GpuContext::set_present_mode(WGPUPresentMode const mode)
+{
+    WGPUSurfaceCapabilities caps{};
+    wgpuSurfaceGetCapabilities(surface, adapter, &caps);
+    bool const ok = is_supported(caps, mode);
+    wgpuSurfaceCapabilitiesFreeMembers(caps);
+
+    if (!ok)
+        return false;
+
+    // NOTE(dr): Only the surface needs to be reconfigured. The device and any resources created
+    // from it are unaffected.
+    present_mode = mode;
+    config_surface(surface_width, surface_height);
+    return true;
+}
+
+void GpuContext::set_present_policy(PresentPolicy const policy)
+{
+    WGPUSurfaceCapabilities caps{};
+    wgpuSurfaceGetCapabilities(surface, adapter, &caps);
+    present_mode = select_present_mode(caps, policy);
+    wgpuSurfaceCapabilitiesFreeMembers(caps);
+
+    config_surface(surface_width, surface_height);
+}
+
 void GpuContext::report()
 {
     report_adapter_features(adapter);
@@ -147,17 +265,89 @@ void GpuContext::report()
         report_surface_capabilities(surface, adapter);
 }
 
+RenderPass RenderPass::begin(
+    WGPUCommandEncoder const cmd_encoder,
+    WGPUSurface const surface,
+    WGPUTextureView const depth,
+    WGPUColor const& clear_color,
+    WGPUPassTimestampWrites const* const timestamp_writes)
+{
+    RenderPass result{};
+
+    result.surface_view = make_surface_view(surface);
+    assert(result.surface_view);
+
+    result.encoder =
+        begin_render_pass(cmd_encoder, result.surface_view, depth, clear_color, timestamp_writes);
+    assert(result.encoder);
+
+    return result;
+}
+
+RenderPass RenderPass::begin(
+    WGPUCommandEncoder const cmd_encoder,
+    OffscreenTarget const& target,
+    WGPUColor const& clear_color,
+    WGPUPassTimestampWrites const* const timestamp_writes)
+{
+    RenderPass result{};
+
+    result.encoder = begin_render_pass(
+        cmd_encoder,
+        target.color_view,
+        target.depth_view,
+        clear_color,
+        timestamp_writes);
+    assert(result.encoder);
+
+    return result;
+}
+
+void RenderPass::end(RenderPass& pass)
+{
+    wgpuRenderPassEncoderEnd(pass.encoder);
+    wgpuRenderPassEncoderRelease(pass.encoder);
+
+    if (pass.surface_view)
+        wgpuTextureViewRelease(pass.surface_view);
+
+    pass = {};
+}
+
 void MainLoop::begin() const
 {
 #ifdef __EMSCRIPTEN__
-    emscripten_set_main_loop_arg(callback, userdata, 0, true);
+    // NOTE(dr): Simulating an infinite loop means this call never returns so the loop outlives
+    // the pointer passed as userdata
+    auto constexpr step_cb = [](void* userdata) { static_cast<MainLoop*>(userdata)->step(); };
+    emscripten_set_main_loop_arg(step_cb, const_cast<MainLoop*>(this), 0, true);
 #else
     while (!glfwWindowShouldClose(window))
-    {
-        callback(userdata);
-        wgpuSurfacePresent(surface);
-    }
+        step();
+#endif
+}
+
+void MainLoop::step() const
+{
+    if (timer)
+        timer->begin_frame();
+
+    std::uint32_t const frame_slot = pacer ? pacer->begin_frame() : 0;
+    callback(userdata, frame_slot);
+
+    if (pacer)
+        pacer->end_frame();
+
+    if (timer)
+        timer->mark(FrameTimer::Phase_Present);
+
+#ifndef __EMSCRIPTEN__
+    // NOTE(dr): The browser presents once control returns to its event loop
+    wgpuSurfacePresent(surface);
 #endif
+
+    if (timer)
+        timer->end_frame();
 }
 
 void Gui::init(GLFWwindow* window, GpuContext const& ctx)
@@ -182,7 +372,7 @@ void Gui::init(GLFWwindow* window, GpuContext const& ctx)
     {
         config.Device = ctx.device;
         config.NumFramesInFlight = 3;
-        config.RenderTargetFormat = default_surface_format;
+        config.RenderTargetFormat = ctx.surface_format;
         config.DepthStencilFormat = WGPUTextureFormat_Undefined;
     }
     ImGui_ImplWGPU_Init(&config);
@@ -209,4 +399,38 @@ void Gui::dispatch_draw(WGPURenderPassEncoder const encoder)
     ImGui_ImplWGPU_RenderDrawData(ImGui::GetDrawData(), encoder);
 }
 
+void Gui::draw_profiler(GpuProfiler const& profiler)
+{
+    ImGui::SetNextWindowPos({10.0f, 200.0f}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    if (!profiler.has_timestamps)
+        ImGui::TextWrapped("Timestamp queries aren't supported. Showing CPU time only.");
+
+    for (GpuProfiler::Timing const& timing : profiler.timings)
+    {
+        auto const& samples = profiler.has_timestamps ? timing.gpu_ms : timing.cpu_ms;
+
+        ImGui::Text(
+            "%s: %.3f ms GPU, %.3f ms CPU",
+            timing.name.c_str(),
+            timing.gpu_ms.get_average(),
+            timing.cpu_ms.get_average());
+
+        ImGui::PushID(timing.name.c_str());
+        ImGui::PlotLines(
+            "##history",
+            samples.values,
+            int(samples.count),
+            int(samples.count < GpuProfiler::history_size ? 0 : samples.head),
+            nullptr,
+            0.0f,
+            FLT_MAX,
+            {240.0f, 40.0f});
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
+
 } // namespace wgpu::sandbox
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <frame_timer.hpp>
+#include <wgpu_frame_pacer.hpp>
+#include <wgpu_offscreen.hpp>
+#include <wgpu_profiler.hpp>
 #include <wgpu_utils.hpp>
 
 #include "dr_shim.hpp"
@@ -8,7 +12,8 @@ namespace wgpu::sandbox
 {
 
 inline constexpr WGPUTextureFormat default_surface_format = WGPUTextureFormat_BGRA8Unorm;
-inline constexpr WGPUPresentMode default_surface_present_mode = WGPUPresentMode_Fifo;
+inline constexpr PresentPolicy default_present_policy = PresentPolicy::Balanced;
+inline constexpr WGPUColor default_clear_color{0.15, 0.15, 0.15, 1.0};
 
 struct GpuContext
 {
@@ -16,6 +21,10 @@ struct GpuContext
     WGPUSurface surface;
     WGPUAdapter adapter;
     WGPUDevice device;
+    WGPUTextureFormat surface_format;
+    WGPUPresentMode present_mode;
+    int surface_width;
+    int surface_height;
 
     static GpuContext make(
         WGPUInstanceDescriptor const* instance_desc = nullptr,
@@ -33,18 +42,59 @@ struct GpuContext
     void config_surface(int width, int height);
     void config_surface(GLFWwindow* window);
 
+    // Reconfigures the surface with the given present mode. Returns false if it isn't supported.
+    bool set_present_mode(WGPUPresentMode mode);
+
+    // Reconfigures the surface with the best present mode for the given policy
+    void set_present_policy(PresentPolicy policy);
+
     void report();
 };
 
+// Clears and draws into a single color target with an optional depth target. The color target is
+// either the surface's current texture or an offscreen target so that the same drawing code runs
+// with or without a display.
+struct RenderPass
+{
+    WGPURenderPassEncoder encoder;
+    WGPUTextureView surface_view; // Null when drawing into an offscreen target
+
+    static RenderPass begin(
+        WGPUCommandEncoder cmd_encoder,
+        WGPUSurface surface,
+        WGPUTextureView depth = nullptr,
+        WGPUColor const& clear_color = default_clear_color,
+        WGPUPassTimestampWrites const* timestamp_writes = nullptr);
+
+    static RenderPass begin(
+        WGPUCommandEncoder cmd_encoder,
+        OffscreenTarget const& target,
+        WGPUColor const& clear_color = default_clear_color,
+        WGPUPassTimestampWrites const* timestamp_writes = nullptr);
+
+    static void end(RenderPass& pass);
+};
+
+// Calls the given callback once per frame and presents the surface. If a pacer is given, each
+// frame waits until there are fewer than its maximum number of frames in flight. If a timer is
+// given, each frame is timed from the start of the callback through present. The callback can
+// split its time further by marking the encode and submit phases on the timer. The callback is
+// passed the pacer's slot for the frame (always 0 without a pacer) which should be used to select
+// any per-frame resources.
 struct MainLoop
 {
-    using Callback = void(void* userdata);
+    using Callback = void(void* userdata, std::uint32_t frame_slot);
     WGPUSurface surface{};
     GLFWwindow* window{};
     Callback* callback{};
     void* userdata{};
+    FrameTimer* timer{};
+    FramePacer* pacer{};
 
     void begin() const;
+
+  private:
+    void step() const;
 };
 
 struct Gui
@@ -56,6 +106,9 @@ struct Gui
     static void end_frame();
     
     static void dispatch_draw(WGPURenderPassEncoder const encoder);
+
+    // Shows rolling pass timings from the given profiler in their own window
+    static void draw_profiler(GpuProfiler const& profiler);
 };
 
 } // namespace wgpu::sandbox
@@ -0,0 +1,292 @@
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <fmt/core.h>
+
+#include <webgpu/webgpu.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+#include <dr/memory.hpp>
+
+#include <wgpu_offscreen.hpp>
+#include <wgpu_utils.hpp>
+
+#include "../example_base.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr char const* shader_src = R"(
+struct VertexOut {
+    @builtin(position) position: vec4f,
+    @location(0) color: vec3f,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) index: u32) -> VertexOut {
+    var positions = array<vec2f, 3>(vec2f(-0.5, -0.5), vec2f(0.5, -0.5), vec2f(0.0, 0.5));
+    var colors = array<vec3f, 3>(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 1.0, 0.0), vec3f(0.0, 0.0, 1.0));
+    return VertexOut(vec4f(positions[index], 0.0, 1.0), colors[index]);
+}
+
+@fragment
+fn fs_main(@location(0) color: vec3f) -> @location(0) vec4f {
+    return vec4f(color, 1.0);
+}
+)";
+
+constexpr WGPUTextureFormat color_format = WGPUTextureFormat_RGBA8Unorm;
+constexpr WGPUTextureFormat depth_format = WGPUTextureFormat_Depth32Float;
+
+struct Options
+{
+    u32 width{1280};
+    u32 height{720};
+    usize frame_count{500};
+    usize slot_count{3};
+    bool force_fallback{};
+};
+
+struct AppState
+{
+    GpuContext gpu;
+    OffscreenTarget target;
+    FrameReadback readback;
+    WGPURenderPipeline pipeline;
+    struct
+    {
+        usize frames;
+        usize failed;
+        u64 checksum;
+    } drained;
+};
+
+AppState state{};
+
+Options parse_options(int const argc, char** const argv)
+{
+    Options result{};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* const arg = argv[i];
+        char const* const val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(arg, "--fallback") == 0)
+            result.force_fallback = true;
+        else if (std::strcmp(arg, "--frames") == 0 && val)
+            result.frame_count = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--slots") == 0 && val)
+            result.slot_count = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--width") == 0 && val)
+            result.width = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--height") == 0 && val)
+            result.height = std::strtoul(argv[++i], nullptr, 10);
+        else
+            fmt::println("Ignoring unknown argument: {}", arg);
+    }
+
+    return result;
+}
+
+WGPURenderPipeline make_render_pipeline(
+    WGPUDevice const device,
+    WGPUStringView const shader_src,
+    WGPUTextureFormat const color_format,
+    WGPUTextureFormat const depth_format)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain = {.sType = WGPUSType_ShaderSourceWGSL},
+        .code = shader_src,
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
+
+    WGPUDepthStencilState const depth_state{
+        .format = depth_format,
+        .depthWriteEnabled = WGPUOptionalBool_True,
+        .depthCompare = WGPUCompareFunction_LessEqual,
+    };
+
+    WGPUColorTargetState const color_targ{
+        .format = color_format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState const frag_state{
+        .module = shader,
+        .entryPoint = {"fs_main", WGPU_STRLEN},
+        .targetCount = 1,
+        .targets = &color_targ,
+    };
+    WGPURenderPipelineDescriptor const pipe_desc{
+        .vertex{
+            .module = shader,
+            .entryPoint{"vs_main", WGPU_STRLEN},
+        },
+        .primitive{
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .frontFace = WGPUFrontFace_CCW,
+            .cullMode = WGPUCullMode_None,
+        },
+        .depthStencil = &depth_state,
+        .multisample{
+            .count = 1,
+            .mask = ~0u,
+            .alphaToCoverageEnabled = 0u,
+        },
+        .fragment = &frag_state,
+    };
+
+    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+}
+
+void init_app(Options const& options)
+{
+    // Create WebGPU context without a surface and report details
+    WGPURequestAdapterOptions const adapter_opts{
+        .forceFallbackAdapter = options.force_fallback,
+    };
+    state.gpu = GpuContext::make(nullptr, &adapter_opts);
+    state.gpu.report();
+
+    // Create render targets
+    state.target = OffscreenTarget::make(
+        state.gpu.device,
+        options.width,
+        options.height,
+        color_format,
+        depth_format);
+
+    state.readback = FrameReadback::make(
+        state.gpu.device,
+        options.width,
+        options.height,
+        color_format,
+        options.slot_count);
+
+    // Create render pipeline
+    state.pipeline = make_render_pipeline(
+        state.gpu.device,
+        {shader_src, WGPU_STRLEN},
+        color_format,
+        depth_format);
+}
+
+void deinit_app()
+{
+    wgpuRenderPipelineRelease(state.pipeline);
+    FrameReadback::release(state.readback);
+    OffscreenTarget::release(state.target);
+    GpuContext::release(state.gpu);
+    state = {};
+}
+
+void consume_frame(FrameReadback::Frame const& frame, void* /*userdata*/)
+{
+    if (frame.data.empty())
+    {
+        fmt::println("Failed to read back frame {}", frame.index);
+        ++state.drained.failed;
+        return;
+    }
+
+    // Touch every row so the readback can't be optimized away
+    for (u32 i = 0; i < frame.height; ++i)
+        state.drained.checksum += frame.data[i * frame.bytes_per_row];
+
+    ++state.drained.frames;
+}
+
+void render_frame(usize const frame_index)
+{
+    // Create a command encoder from the device
+    WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(
+        state.gpu.device,
+        nullptr);
+    assert(cmd_encoder);
+    auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
+
+    // Render pass
+    {
+        f64 const t = (frame_index % 256) / 255.0;
+        RenderPass pass = RenderPass::begin(cmd_encoder, state.target, {t, 0.15, 0.15, 1.0});
+        auto const end_pass = defer([&]() { RenderPass::end(pass); });
+
+        wgpuRenderPassEncoderSetPipeline(pass.encoder, state.pipeline);
+        wgpuRenderPassEncoderDraw(pass.encoder, 3, 1, 0, 0);
+    }
+
+    // Copy rendered frame to the next readback slot, draining older frames if the ring is full
+    if (!state.readback.has_free_slot())
+        state.readback.wait_and_drain(consume_frame, nullptr);
+    [[maybe_unused]] bool const ok = state.readback.enqueue(cmd_encoder, state.target.color);
+    assert(ok);
+
+    // Create encoded commands
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
+    assert(cmds);
+    auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
+
+    // Submit encoded commands and request mapping of the copied frame
+    WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
+    wgpuQueueSubmit(queue, 1, &cmds);
+    state.readback.submit();
+
+    // Drain any frames that are already done without blocking
+    poll_device(state.gpu.device, false);
+    state.readback.drain(consume_frame, nullptr);
+}
+
+} // namespace
+} // namespace wgpu::sandbox
+
+int main(int argc, char** argv)
+{
+    using namespace wgpu::sandbox;
+
+    Options const options = parse_options(argc, argv);
+
+    init_app(options);
+    auto const _ = defer([]() { deinit_app(); });
+
+    using Clock = std::chrono::steady_clock;
+    auto const t0 = Clock::now();
+
+    for (usize i = 0; i < options.frame_count; ++i)
+        render_frame(i);
+
+    state.readback.flush(consume_frame, nullptr);
+
+    auto const t1 = Clock::now();
+    f64 const secs = std::chrono::duration<f64>(t1 - t0).count();
+    f64 const frame_mb = f64(state.readback.bytes_per_row) * options.height / (1024.0 * 1024.0);
+
+    fmt::println(
+        "Rendered {} frames ({}x{}, {} readback slots) in {:.3f} s",
+        state.drained.frames,
+        options.width,
+        options.height,
+        options.slot_count,
+        secs);
+    fmt::println(
+        "\t{:.1f} frames/s, {:.1f} MB/s read back (checksum: {})",
+        state.drained.frames / secs,
+        state.drained.frames * frame_mb / secs,
+        state.drained.checksum);
+
+    if (state.drained.failed > 0)
+    {
+        fmt::println("{} frames failed to read back", state.drained.failed);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
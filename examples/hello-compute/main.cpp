@@ -1,6 +1,6 @@
 #include <cassert>
-
-#include <type_traits>
+#include <cstdlib>
+#include <span>
 
 #include <fmt/core.h>
 
@@ -9,10 +9,10 @@
 #include <dr/basic_types.hpp>
 #include <dr/defer.hpp>
 #include <dr/memory.hpp>
-#include <dr/span.hpp>
 
-#include <emsc_utils.hpp>
-#include <wgpu_utils.hpp>
+#include <wgpu_bind_group_cache.hpp>
+#include <wgpu_pipeline_cache.hpp>
+#include <wgpu_readback.hpp>
 
 #include "shader_src.hpp"
 
@@ -46,12 +46,12 @@ struct UnaryKernel
         bind_group_layout = {};
     }
 
-    static UnaryKernel make(WGPUDevice const device, char const* const shader_src)
+    static UnaryKernel make(PipelineCache& pipelines, char const* const shader_src)
     {
         UnaryKernel result{};
 
         assert(pipeline_layout);
-        result.pipeline = make_pipeline(device, pipeline_layout, {shader_src, WGPU_STRLEN});
+        result.pipeline = make_pipeline(pipelines, pipeline_layout, {shader_src, WGPU_STRLEN});
 
         return result;
     }
@@ -66,12 +66,12 @@ struct UnaryKernel
         kernel = {};
     }
 
-    void update_bind_group(WGPUDevice const device, WGPUBuffer const buffer)
+    void update_bind_group(BindGroupCache& bind_groups, WGPUBuffer const buffer)
     {
         if (bind_group)
             wgpuBindGroupRelease(bind_group);
 
-        bind_group = make_bind_group(device, bind_group_layout, buffer);
+        bind_group = make_bind_group(bind_groups, bind_group_layout, buffer);
         assert(bind_group);
     }
 
@@ -111,18 +111,11 @@ struct UnaryKernel
     }
 
     static WGPUComputePipeline make_pipeline(
-        WGPUDevice const device,
+        PipelineCache& cache,
         WGPUPipelineLayout const layout,
         WGPUStringView const shader_src)
     {
-        WGPUShaderSourceWGSL shader_desc_src{
-            .chain{.sType = WGPUSType_ShaderSourceWGSL},
-            .code = shader_src,
-        };
-        WGPUShaderModuleDescriptor const shader_desc{
-            .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
-        };
-        WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+        WGPUShaderModule const shader = cache.get_shader_module(shader_src);
         auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
 
         WGPUComputePipelineDescriptor const pipe_desc{
@@ -132,11 +125,11 @@ struct UnaryKernel
                 .entryPoint{"compute_main", WGPU_STRLEN},
             },
         };
-        return wgpuDeviceCreateComputePipeline(device, &pipe_desc);
+        return cache.get_compute_pipeline(pipe_desc);
     }
 
     static WGPUBindGroup make_bind_group(
-        WGPUDevice const device,
+        BindGroupCache& cache,
         WGPUBindGroupLayout const layout,
         WGPUBuffer const buffer)
     {
@@ -152,7 +145,7 @@ struct UnaryKernel
             .entryCount = 1,
             .entries = entries,
         };
-        return wgpuDeviceCreateBindGroup(device, &desc);
+        return cache.get(desc);
     }
 };
 
@@ -173,68 +166,14 @@ struct ComputePass
     }
 };
 
-template <typename Action>
-void read_buffer(
-    [[maybe_unused]] WGPUInstance const instance,
-    WGPUBuffer const buffer,
-    Action&& action)
-{
-    static_assert(std::is_invocable_v<Action, Span<u8 const>>);
-
-    struct MapResult
-    {
-        WGPUBuffer buffer;
-        bool is_ready;
-    } result{buffer, false};
-
-    WGPUBufferMapCallbackInfo cb_info{};
-    cb_info.userdata1 = &result;
-    cb_info.userdata2 = &action;
-    cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
-    cb_info.callback = //
-        [](WGPUMapAsyncStatus status, WGPUStringView /*msg*/, void* userdata1, void* userdata2) {
-            auto& result = *static_cast<MapResult*>(userdata1);
-            auto& action = *static_cast<Action*>(userdata2);
-
-            // If map was successful, need to unmap the buffer when we're done here
-            assert(status == WGPUMapAsyncStatus_Success);
-            auto const unmap = defer([&]() { wgpuBufferUnmap(result.buffer); });
-
-            // Perform some action on the buffer contents
-            usize const size = wgpuBufferGetSize(result.buffer);
-            u8 const* bytes = as<u8>(wgpuBufferGetConstMappedRange(result.buffer, 0, size));
-            action(Span(bytes, size));
-
-#ifdef __EMSCRIPTEN__
-            raise_event("resultReady");
-#else
-            result.is_ready = true;
-#endif
-        };
-
-    [[maybe_unused]]
-    WGPUFuture const fut = wgpuBufferMapAsync(
-        result.buffer,
-        WGPUMapMode_Read,
-        0,
-        wgpuBufferGetSize(result.buffer),
-        cb_info);
-
-    // Wait until async work is done
-#ifdef __EMSCRIPTEN__
-    wait_for_event("resultReady");
-#else
-    // NOTE(dr): Waiting on futures is not yet implemented in wgpu-native
-    // wait_for_future(instance, fut);
-    wait_for_condition(instance, [&]() { return result.is_ready; });
-#endif
-}
-
 struct AppState
 {
     GpuContext gpu;
+    PipelineCache pipelines;
+    BindGroupCache bind_groups;
     UnaryKernel kernel;
-    WGPUBuffer buffers[2];
+    WGPUBuffer buffer;
+    ReadbackRing readback;
 };
 
 AppState state{};
@@ -253,26 +192,31 @@ void init_app()
     state.gpu = GpuContext::make();
     state.gpu.report();
 
+    state.pipelines = PipelineCache::make(state.gpu.device);
+    state.bind_groups = BindGroupCache::make(state.gpu.device);
+
     UnaryKernel::init(state.gpu.device);
-    state.kernel = UnaryKernel::make(state.gpu.device, shader_src);
+    state.kernel = UnaryKernel::make(state.pipelines, shader_src);
+    state.pipelines.report();
 
     constexpr usize buffer_size = 100 * sizeof(f32);
-    state.buffers[0] = make_buffer(
+    state.buffer = make_buffer(
         state.gpu.device,
         buffer_size,
         WGPUBufferUsage_CopySrc | WGPUBufferUsage_Storage);
-    state.buffers[1] = make_buffer(
-        state.gpu.device,
-        buffer_size,
-        WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead);
+
+    // Staging buffers used to read results back
+    state.readback = ReadbackRing::make(state.gpu.device, 2, buffer_size);
 }
 
 void deinit_app()
 {
-    wgpuBufferRelease(state.buffers[0]);
-    wgpuBufferRelease(state.buffers[1]);
+    ReadbackRing::release(state.readback);
     UnaryKernel::release(state.kernel);
+    state.bind_groups.release_resource(state.buffer);
     UnaryKernel::deinit();
+    BindGroupCache::release(state.bind_groups);
+    PipelineCache::release(state.pipelines);
     GpuContext::release(state.gpu);
     state = {};
 }
@@ -287,7 +231,8 @@ int main(int /*argc*/, char** /*argv*/)
     init_app();
     auto const _ = defer([]() { deinit_app(); });
 
-    state.kernel.update_bind_group(state.gpu.device, state.buffers[0]);
+    state.kernel.update_bind_group(state.bind_groups, state.buffer);
+    ReadbackRing::Handle result{};
 
     // Dispatch command(s)
     {
@@ -310,14 +255,13 @@ int main(int /*argc*/, char** /*argv*/)
             // ...
         }
 
-        // Copy result to second buffer for read back
-        wgpuCommandEncoderCopyBufferToBuffer(
+        // Copy result to a staging buffer for read back
+        result = state.readback.enqueue(
             cmd_encoder,
-            state.buffers[0],
-            0,
-            state.buffers[1],
+            state.buffer,
             0,
-            wgpuBufferGetSize(state.buffers[0]));
+            wgpuBufferGetSize(state.buffer));
+        assert(result.is_valid());
 
         // Create encoded commands
         WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
@@ -327,16 +271,28 @@ int main(int /*argc*/, char** /*argv*/)
         // Submit the encoded command
         WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
         wgpuQueueSubmit(queue, 1, &cmds);
+        state.readback.submit();
     }
 
-    // Read second buffer back and print out values
-    read_buffer(state.gpu.instance, state.buffers[1], [](Span<u8 const> data) {
-        auto vals = as<f32>(data);
-        fmt::print("buffer: [{}", data[0]);
-        for (f32 const val : vals)
-            fmt::print(", {}", val);
+    // Wait for the result and print out values
+    state.readback.wait(result);
+    {
+        std::span<u8 const> const data = state.readback.get_data(result);
+        if (data.empty())
+        {
+            fmt::println("Failed to read back result");
+            return EXIT_FAILURE;
+        }
+
+        f32 const* const vals = as<f32>(data.data());
+        usize const count = data.size() / sizeof(f32);
+
+        fmt::print("buffer: [{}", vals[0]);
+        for (usize i = 1; i < count; ++i)
+            fmt::print(", {}", vals[i]);
         fmt::print("]\n");
-    });
+    }
+    state.readback.recycle(result);
 
     return 0;
 }
@@ -22,76 +22,13 @@ namespace wgpu::sandbox
 namespace
 {
 
-struct RenderPass
-{
-    WGPURenderPassEncoder encoder;
-    WGPUTextureView surface_view;
-
-    static RenderPass begin(
-        WGPUCommandEncoder const cmd_encoder,
-        WGPUSurface const surface,
-        WGPUColor const& clear_color)
-    {
-        RenderPass result{};
-
-        result.surface_view = make_view(surface);
-        assert(result.surface_view);
-
-        result.encoder = begin(cmd_encoder, result.surface_view, clear_color);
-        assert(result.encoder);
-
-        return result;
-    }
-
-    static void end(RenderPass& pass)
-    {
-        wgpuRenderPassEncoderEnd(pass.encoder);
-        wgpuRenderPassEncoderRelease(pass.encoder);
-        wgpuTextureViewRelease(pass.surface_view);
-        pass = {};
-    }
-
-  private:
-    static WGPUTextureView make_view(WGPUSurface const surface)
-    {
-        WGPUSurfaceTexture srf_tex;
-        wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
-        assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
-
-        WGPUTextureViewDescriptor const desc{
-            .mipLevelCount = 1,
-            .arrayLayerCount = 1,
-        };
-        return wgpuTextureCreateView(srf_tex.texture, &desc);
-    }
-
-    static WGPURenderPassEncoder begin(
-        WGPUCommandEncoder const encoder,
-        WGPUTextureView const surface_view,
-        WGPUColor const& clear_color)
-    {
-        WGPURenderPassColorAttachment color_atts[]{
-            {
-                .view = surface_view,
-                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue = clear_color,
-            },
-        };
-        WGPURenderPassDescriptor const desc{
-            .colorAttachmentCount = 1,
-            .colorAttachments = color_atts,
-        };
-        return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-    }
-};
-
 struct AppState
 {
     GLFWwindow* window;
     GpuContext gpu;
+    GpuProfiler profiler;
     float clear_color[3]{0.8f, 0.2f, 0.4f};
+    PresentPolicy present_policy{default_present_policy};
 };
 
 AppState state{};
@@ -144,10 +81,12 @@ void init_app()
 #endif
 
     Gui::init(state.window, state.gpu);
+    state.profiler = GpuProfiler::make(state.gpu.device);
 }
 
 void deinit_app()
 {
+    GpuProfiler::release(state.profiler);
     Gui::deinit();
     GpuContext::release(state.gpu);
     glfwDestroyWindow(state.window);
@@ -169,6 +108,21 @@ void draw_ui()
         if (ImGui::BeginTabItem("Settings"))
         {
             ImGui::ColorEdit3("Clear color", state.clear_color);
+
+            // Switching present modes only reconfigures the surface
+            static constexpr char const* policy_names[]{
+                "Low latency",
+                "Balanced",
+                "Low power",
+            };
+            int policy = int(state.present_policy);
+            if (ImGui::Combo("Present policy", &policy, policy_names, 3))
+            {
+                state.present_policy = PresentPolicy(policy);
+                state.gpu.set_present_policy(state.present_policy);
+            }
+            ImGui::Text("Present mode: %s", to_string(state.gpu.present_mode));
+
             ImGui::EndTabItem();
         }
 
@@ -183,6 +137,7 @@ void draw_ui()
 
     ImGui::End();
 
+    Gui::draw_profiler(state.profiler);
     Gui::end_frame();
 }
 
@@ -197,13 +152,14 @@ int main(int /*argc*/, char** /*argv*/)
     auto const _ = defer([]() { deinit_app(); });
 
     // Main loop
-    constexpr auto loop_cb = [](void* /*userdata*/) {
+    constexpr auto loop_cb = [](void* /*userdata*/, u32 /*frame_slot*/) {
         glfwPollEvents();
 
         // NOTE(dr): Use ImGuiIO::WantCapture* flags to determine if input events should be
         // forwarded to the main application. In general, when one of these flags is true, the
         // corresponding event should be consumed by ImGui.
 
+        state.profiler.begin_frame();
         draw_ui();
 
         // Create a command encoder from the device
@@ -222,13 +178,21 @@ int main(int /*argc*/, char** /*argv*/)
             RenderPass pass = RenderPass::begin(
                 cmd_encoder,
                 state.gpu.surface,
-                to_wgpu_color(state.clear_color));
-            auto const end_pass = defer([&]() { RenderPass::end(pass); });
+                nullptr,
+                to_wgpu_color(state.clear_color),
+                state.profiler.begin_pass("main"));
+            auto const end_pass = defer([&]() {
+                RenderPass::end(pass);
+                state.profiler.end_pass();
+            });
 
             // Issue UI draw command
             Gui::dispatch_draw(pass.encoder);
         }
 
+        // Resolve pass timestamps
+        state.profiler.end_frame(cmd_encoder);
+
         // Create encoded commands
         WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(cmd_encoder, nullptr);
         assert(cmds);
@@ -237,6 +201,7 @@ int main(int /*argc*/, char** /*argv*/)
         // Submit encoded commands
         WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
         wgpuQueueSubmit(queue, 1, &cmds);
+        state.profiler.submit();
     };
 
     MainLoop{state.gpu.surface, state.window, loop_cb}.begin();
@@ -15,6 +15,7 @@
 #include <dr/app/file_utils.hpp>
 
 #include <emsc_utils.hpp>
+#include <wgpu_pipeline_cache.hpp>
 #include <wgpu_utils.hpp>
 
 #include "../example_base.hpp"
@@ -24,89 +25,22 @@ namespace wgpu::sandbox
 namespace
 {
 
-struct RenderPass
-{
-    WGPURenderPassEncoder encoder;
-    WGPUTextureView surface_view;
-
-    static RenderPass begin(WGPUCommandEncoder const cmd_encoder, WGPUSurface const surface)
-    {
-        RenderPass result{};
-
-        result.surface_view = make_view(surface);
-        assert(result.surface_view);
-
-        result.encoder = begin(cmd_encoder, result.surface_view);
-        assert(result.encoder);
-
-        return result;
-    }
-
-    static void end(RenderPass& pass)
-    {
-        wgpuRenderPassEncoderEnd(pass.encoder);
-        wgpuRenderPassEncoderRelease(pass.encoder);
-        wgpuTextureViewRelease(pass.surface_view);
-        pass = {};
-    }
-
-  private:
-    static WGPUTextureView make_view(WGPUSurface const surface)
-    {
-        WGPUSurfaceTexture srf_tex;
-        wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
-        assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
-
-        WGPUTextureViewDescriptor const desc{
-            .mipLevelCount = 1,
-            .arrayLayerCount = 1,
-        };
-        return wgpuTextureCreateView(srf_tex.texture, &desc);
-    }
-
-    static WGPURenderPassEncoder begin(
-        WGPUCommandEncoder const encoder,
-        WGPUTextureView const surface_view)
-    {
-        WGPURenderPassColorAttachment color_atts[]{
-            {
-                .view = surface_view,
-                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue{0.15, 0.15, 0.15, 1.0},
-            },
-        };
-        WGPURenderPassDescriptor const desc{
-            .colorAttachmentCount = 1,
-            .colorAttachments = color_atts,
-        };
-        return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-    }
-};
-
 struct AppState
 {
     GLFWwindow* window;
     GpuContext gpu;
+    PipelineCache pipelines;
     WGPURenderPipeline pipeline;
 };
 
 AppState state{};
 
 WGPURenderPipeline make_render_pipeline(
-    WGPUDevice const device,
+    PipelineCache& cache,
     WGPUStringView const shader_src,
     WGPUTextureFormat const color_format)
 {
-    WGPUShaderSourceWGSL shader_desc_src{
-        .chain = {.sType = WGPUSType_ShaderSourceWGSL},
-        .code = shader_src,
-    };
-    WGPUShaderModuleDescriptor const shader_desc{
-        .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
-    };
-    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    WGPUShaderModule const shader = cache.get_shader_module(shader_src);
     auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
 
     WGPUColorTargetState const color_targ{
@@ -141,7 +75,7 @@ WGPURenderPipeline make_render_pipeline(
         .fragment = &frag_state,
     };
 
-    return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+    return cache.get_render_pipeline(pipe_desc);
 }
 
 void init_app()
@@ -196,15 +130,18 @@ void init_app()
     assert(ok);
 
     // Create render pipeline
+    state.pipelines = PipelineCache::make(state.gpu.device);
     state.pipeline = make_render_pipeline(
-        state.gpu.device,
+        state.pipelines,
         {buffer.c_str(), WGPU_STRLEN},
-        default_surface_format);
+        state.gpu.surface_format);
+    state.pipelines.report();
 }
 
 void deinit_app()
 {
     wgpuRenderPipelineRelease(state.pipeline);
+    PipelineCache::release(state.pipelines);
     GpuContext::release(state.gpu);
     glfwDestroyWindow(state.window);
     glfwTerminate();
@@ -222,7 +159,7 @@ int main(int /*argc*/, char** /*argv*/)
     auto const _ = defer([]() { deinit_app(); });
 
     // Main loop body
-    constexpr auto loop_cb = [](void* /*userdata*/) {
+    constexpr auto loop_cb = [](void* /*userdata*/, u32 /*frame_slot*/) {
         glfwPollEvents();
 
         // Create a command encoder from the device
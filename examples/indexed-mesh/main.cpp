@@ -26,67 +26,6 @@ namespace wgpu::sandbox
 namespace
 {
 
-struct RenderPass
-{
-    WGPURenderPassEncoder encoder;
-    WGPUTextureView surface_view;
-
-    static RenderPass begin(WGPUCommandEncoder const cmd_encoder, WGPUSurface const surface)
-    {
-        RenderPass result{};
-
-        result.surface_view = make_view(surface);
-        assert(result.surface_view);
-
-        result.encoder = begin(cmd_encoder, result.surface_view);
-        assert(result.encoder);
-
-        return result;
-    }
-
-    static void end(RenderPass& pass)
-    {
-        wgpuRenderPassEncoderEnd(pass.encoder);
-        wgpuRenderPassEncoderRelease(pass.encoder);
-        wgpuTextureViewRelease(pass.surface_view);
-        pass = {};
-    }
-
-  private:
-    static WGPUTextureView make_view(WGPUSurface const surface)
-    {
-        WGPUSurfaceTexture srf_tex;
-        wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
-        assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
-
-        WGPUTextureViewDescriptor const desc{
-            .mipLevelCount = 1,
-            .arrayLayerCount = 1,
-        };
-        return wgpuTextureCreateView(srf_tex.texture, &desc);
-    }
-
-    static WGPURenderPassEncoder begin(
-        WGPUCommandEncoder const encoder,
-        WGPUTextureView const surface_view)
-    {
-        WGPURenderPassColorAttachment color_atts[]{
-            {
-                .view = surface_view,
-                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue{0.15, 0.15, 0.15, 1.0},
-            },
-        };
-        WGPURenderPassDescriptor const desc{
-            .colorAttachmentCount = 1,
-            .colorAttachments = color_atts,
-        };
-        return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-    }
-};
-
 struct RenderMesh
 {
     static constexpr WGPUIndexFormat index_format{WGPUIndexFormat_Uint16};
@@ -318,7 +257,7 @@ void init_app()
     state.pipeline = make_render_pipeline(
         state.gpu.device,
         {shader_src, WGPU_STRLEN},
-        default_surface_format);
+        state.gpu.surface_format);
 
     // Create geometry
     state.geometry = RenderMesh::make_quad(state.gpu.device);
@@ -345,7 +284,7 @@ int main(int /*argc*/, char** /*argv*/)
     auto const _ = defer([]() { deinit_app(); });
 
     // Main loop body
-    constexpr auto loop_cb = [](void* /*userdata*/) {
+    constexpr auto loop_cb = [](void* /*userdata*/, u32 /*frame_slot*/) {
         glfwPollEvents();
 
         // Create a command encoder from the device
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <fmt/core.h>
+
+#include <dr/basic_types.hpp>
+#include <dr/defer.hpp>
+
+#include <mesh_file.hpp>
+#include <mesh_optimizer.hpp>
+#include <scene_importer.hpp>
+#include <task_pool.hpp>
+#include <vertex_quantization.hpp>
+
+#include "../dr_shim.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+struct Options
+{
+    char const* src_path;
+    char const* dst_path;
+    bool with_normals;
+    bool quantize;
+    bool optimize{true};
+};
+
+Options parse_options(int const argc, char** const argv)
+{
+    Options result{};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* const arg = argv[i];
+
+        if (std::strcmp(arg, "--normals") == 0)
+            result.with_normals = true;
+        else if (std::strcmp(arg, "--quantize") == 0)
+            result.quantize = true;
+        else if (std::strcmp(arg, "--no-optimize") == 0)
+            result.optimize = false;
+        else if (!result.src_path)
+            result.src_path = arg;
+        else if (!result.dst_path)
+            result.dst_path = arg;
+        else
+            fmt::println("Ignoring unknown argument: {}", arg);
+    }
+
+    return result;
+}
+
+} // namespace
+} // namespace wgpu::sandbox
+
+int main(int argc, char** argv)
+{
+    using namespace wgpu::sandbox;
+
+    Options const options = parse_options(argc, argv);
+    if (!options.src_path || !options.dst_path)
+    {
+        fmt::println(
+            "Usage: mesh-converter <input.(obj|gltf|glb)> <output.mesh> [--normals] [--quantize] "
+            "[--no-optimize]");
+        return EXIT_FAILURE;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto const t0 = Clock::now();
+    auto const get_elapsed_ms = [&]() {
+        return std::chrono::duration<f64, std::milli>(Clock::now() - t0).count();
+    };
+
+    // Instances are merged into a single mesh which is optimized as a whole
+    MeshBuffers mesh{};
+    VertexAttributes attributes{};
+    {
+        TaskPool pool = TaskPool::make(std::max(std::thread::hardware_concurrency(), 1u));
+        auto const drop_pool = defer([&]() { TaskPool::release(pool); });
+
+        ImportOptions const import_options{
+            .with_normals = options.with_normals,
+            .optimize = false,
+            .load_images = false,
+        };
+        ImportedScene scene{};
+        if (!import_scene(options.src_path, pool, import_options, scene))
+        {
+            fmt::println("Failed to import {}", options.src_path);
+            return EXIT_FAILURE;
+        }
+        scene.report();
+
+        mesh = bake_instances(scene);
+        attributes = scene.attributes;
+    }
+
+    fmt::println(
+        "Read {} vertices, {} triangles ({:.1f} ms)",
+        mesh.get_vertex_count(),
+        mesh.get_triangle_count(),
+        get_elapsed_ms());
+
+    if (options.optimize)
+    {
+        optimize_mesh(mesh, attributes.position);
+        VertexCacheStats const stats = get_vertex_cache_stats(mesh);
+        fmt::println(
+            "Optimized to {} vertices, ACMR {:.3f} ({:.1f} ms)",
+            mesh.get_vertex_count(),
+            stats.get_acmr(),
+            get_elapsed_ms());
+    }
+
+    MeshBuffers quantized{};
+    VertexQuantization quant{};
+    bool is_quantized = false;
+    if (options.quantize)
+    {
+        quant = quantize_vertices(mesh, attributes, quantized);
+        quant.report();
+
+        is_quantized = quant.is_within({});
+        if (!is_quantized)
+            fmt::println("Quantization error exceeds tolerance, writing float vertices");
+    }
+
+    bool const is_written = is_quantized
+                                ? write_mesh_file(options.dst_path, quantized, attributes, &quant)
+                                : write_mesh_file(options.dst_path, mesh, attributes);
+    if (!is_written)
+    {
+        fmt::println("Failed to write {}", options.dst_path);
+        return EXIT_FAILURE;
+    }
+
+    fmt::println("Wrote {} ({:.1f} ms)", options.dst_path, get_elapsed_ms());
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,7 @@
 #include "assets.hpp"
 
 #include <cassert>
+#include <vector>
 
 #include <dr/app/file_utils.hpp>
 
@@ -20,6 +21,18 @@ ImageAsset load_image_asset(char const* const path)
     return {{data, free_data}, width, height, stride};
 }
 
+ImageAsset load_image_asset(std::span<u8 const> const data)
+{
+    constexpr i32 stride = 4;
+    i32 width, height, src_stride;
+    auto const pixels =
+        stbi_load_from_memory(data.data(), i32(data.size()), &width, &height, &src_stride, stride);
+    assert(pixels);
+
+    constexpr auto free_data = [](u8* data) { stbi_image_free(data); };
+    return {{pixels, free_data}, width, height, stride};
+}
+
 ShaderAsset load_shader_asset(char const* const path)
 {
     ShaderAsset result{};
@@ -28,4 +41,51 @@ ShaderAsset load_shader_asset(char const* const path)
     return result;
 }
 
+ShaderAsset load_shader_asset(std::span<u8 const> const data)
+{
+    ShaderAsset result{};
+    result.src.assign(reinterpret_cast<char const*>(data.data()), data.size());
+    return result;
+}
+
+ImageAsset load_image_asset(AssetPack const& pack, char const* const path)
+{
+    AssetPackEntry const* const entry = pack.find(path);
+    if (!entry)
+        return load_image_asset(path);
+
+    std::vector<u8> buffer{};
+    return load_image_asset(pack.read(*entry, buffer));
+}
+
+ShaderAsset load_shader_asset(AssetPack const& pack, char const* const path)
+{
+    AssetPackEntry const* const entry = pack.find(path);
+    if (!entry)
+        return load_shader_asset(path);
+
+    std::vector<u8> buffer{};
+    return load_shader_asset(pack.read(*entry, buffer));
+}
+
+std::future<ImageAsset> load_image_asset(
+    AssetLoader& loader,
+    AssetPack const& pack,
+    char const* const path)
+{
+    return loader.submit([&pack, path = String{path}]() {
+        return load_image_asset(pack, path.c_str());
+    });
+}
+
+std::future<ShaderAsset> load_shader_asset(
+    AssetLoader& loader,
+    AssetPack const& pack,
+    char const* const path)
+{
+    return loader.submit([&pack, path = String{path}]() {
+        return load_shader_asset(pack, path.c_str());
+    });
+}
+
 } // namespace wgpu::sandbox
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <future>
 #include <memory>
+#include <span>
 
 #include <dr/basic_types.hpp>
 #include <dr/string.hpp>
 
+#include <asset_loader.hpp>
+#include <asset_pack.hpp>
+
 #include "../dr_shim.hpp"
 
 namespace wgpu::sandbox
@@ -27,6 +32,30 @@ struct ShaderAsset
 
 ImageAsset load_image_asset(char const* path);
 
+ImageAsset load_image_asset(std::span<u8 const> data);
+
 ShaderAsset load_shader_asset(char const* path);
 
+ShaderAsset load_shader_asset(std::span<u8 const> data);
+
+// Loads the image from the pack if it has an asset with the given name, otherwise from a file
+ImageAsset load_image_asset(AssetPack const& pack, char const* path);
+
+// Loads the shader source from the pack if it has an asset with the given name, otherwise from a
+// file
+ShaderAsset load_shader_asset(AssetPack const& pack, char const* path);
+
+// Loads the image on one of the loader's threads. The pack must outlive the returned future.
+std::future<ImageAsset> load_image_asset(
+    AssetLoader& loader,
+    AssetPack const& pack,
+    char const* path);
+
+// Loads the shader source on one of the loader's threads. The pack must outlive the returned
+// future.
+std::future<ShaderAsset> load_shader_asset(
+    AssetLoader& loader,
+    AssetPack const& pack,
+    char const* path);
+
 } // namespace wgpu::sandbox
\ No newline at end of file
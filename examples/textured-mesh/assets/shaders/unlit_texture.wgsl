@@ -6,38 +6,62 @@ var color_sampler: sampler;
 
 struct Uniforms {
     local_to_clip : mat4x4<f32>,
+    // Maps stored (possibly quantized) positions to local space
+    position_scale : vec4f,
+    position_offset : vec4f,
 };
 
 @group(0) @binding(2)
 var<uniform> uniforms : Uniforms;
 
 struct VertexIn {
-    @location(0) position: vec3f,
+    @location(0) position: vec4f,
     @location(1) tex_coords: vec2f,
 };
 
+// Per-instance attributes
+struct InstanceIn {
+    @location(2) local_to_world_0: vec4f,
+    @location(3) local_to_world_1: vec4f,
+    @location(4) local_to_world_2: vec4f,
+    @location(5) local_to_world_3: vec4f,
+    @location(6) tint: vec4f,
+};
+
 struct VertexOut {
     @builtin(position) position: vec4f,
     @location(0) tex_coords: vec2f,
     @location(1) db_color: vec3f,
+    @location(2) tint: vec4f,
 };
 
 @vertex
-fn vs_main(in : VertexIn) -> VertexOut {
+fn vs_main(in : VertexIn, inst : InstanceIn) -> VertexOut {
+    let local_to_world = mat4x4f(
+        inst.local_to_world_0,
+        inst.local_to_world_1,
+        inst.local_to_world_2,
+        inst.local_to_world_3,
+    );
+
+    let position = uniforms.position_offset.xyz + uniforms.position_scale.xyz * in.position.xyz;
+
     var out : VertexOut;
-    out.position = uniforms.local_to_clip * vec4f(in.position, 1.0);
+    out.position = uniforms.local_to_clip * local_to_world * vec4f(position, 1.0);
     out.tex_coords = in.tex_coords;
-    out.db_color = in.position.xyz;
+    out.db_color = position;
+    out.tint = inst.tint;
     return out;
 }
 
 struct FragmentIn {
     @location(0) tex_coords: vec2f,
     @location(1) db_color: vec3f,
+    @location(2) tint: vec4f,
 };
 
 @fragment
 fn fs_main(in : FragmentIn) -> @location(0) vec4f {
     // return vec4<f32>(in.db_color, 1.0); // DEBUG(dr)
-    return textureSample(color_texture, color_sampler, in.tex_coords);
+    return in.tint * textureSample(color_texture, color_sampler, in.tex_coords);
 }
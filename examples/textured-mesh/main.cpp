@@ -1,4 +1,12 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <fmt/core.h>
 
@@ -19,7 +27,24 @@
 
 #include <dr/app/gfx_utils.hpp>
 
+#include <asset_loader.hpp>
+#include <asset_pack.hpp>
 #include <emsc_utils.hpp>
+#include <mesh_file.hpp>
+#include <mesh_optimizer.hpp>
+#include <scene_importer.hpp>
+#include <task_pool.hpp>
+#include <texture_cache.hpp>
+#include <vertex_quantization.hpp>
+#include <wgpu_bind_group_cache.hpp>
+#include <wgpu_bundle_cache.hpp>
+#include <wgpu_buffer_pool.hpp>
+#include <wgpu_instance_buffer.hpp>
+#include <wgpu_ktx2.hpp>
+#include <wgpu_mipmaps.hpp>
+#include <wgpu_pipeline_cache.hpp>
+#include <wgpu_uniform_ring.hpp>
+#include <wgpu_upload.hpp>
 #include <wgpu_utils.hpp>
 
 #include "assets.hpp"
@@ -31,79 +56,21 @@ namespace wgpu::sandbox
 namespace
 {
 
-struct RenderPass
-{
-    WGPURenderPassEncoder encoder;
-    WGPUTextureView surface_view;
-
-    static RenderPass begin(
-        WGPUCommandEncoder const cmd_encoder,
-        WGPUSurface const surface,
-        WGPUTextureView const depth)
-    {
-        RenderPass result{};
-
-        result.surface_view = make_view(surface);
-        assert(result.surface_view);
-
-        result.encoder = begin(cmd_encoder, result.surface_view, depth);
-        assert(result.encoder);
-
-        return result;
-    }
+constexpr char const* asset_pack_path = "textured-mesh-assets.pack";
+constexpr char const* shader_path = "assets/shaders/unlit_texture.wgsl";
+constexpr char const* default_image_path = "assets/images/cube-faces.png";
 
-    static void end(RenderPass& pass)
-    {
-        wgpuRenderPassEncoderEnd(pass.encoder);
-        wgpuRenderPassEncoderRelease(pass.encoder);
-        wgpuTextureViewRelease(pass.surface_view);
-        pass = {};
-    }
-
-  private:
-    static WGPUTextureView make_view(WGPUSurface const surface)
-    {
-        WGPUSurfaceTexture srf_tex;
-        wgpuSurfaceGetCurrentTexture(surface, &srf_tex);
-        assert(srf_tex.status == WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal);
-
-        WGPUTextureViewDescriptor const desc{
-            .mipLevelCount = 1,
-            .arrayLayerCount = 1,
-        };
-        return wgpuTextureCreateView(srf_tex.texture, &desc);
-    }
+#ifdef __EMSCRIPTEN__
+// NOTE(dr): Web builds have no persistent file system to cache to
+constexpr char const* default_cache_dir = nullptr;
+#else
+constexpr char const* default_cache_dir = "asset-cache";
+#endif
 
-    static WGPURenderPassEncoder begin(
-        WGPUCommandEncoder const encoder,
-        WGPUTextureView const surface_view,
-        WGPUTextureView const depth_view)
-    {
-        WGPURenderPassColorAttachment color_atts[]{
-            {
-                .view = surface_view,
-                .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue{0.15, 0.15, 0.15, 1.0},
-            },
-        };
-        WGPURenderPassDepthStencilAttachment depth_atts[]{
-            {
-                .view = depth_view,
-                .depthLoadOp = WGPULoadOp_Clear,
-                .depthStoreOp = WGPUStoreOp_Store,
-                .depthClearValue = 1.0f,
-            },
-        };
-        WGPURenderPassDescriptor const desc{
-            .colorAttachmentCount = 1,
-            .colorAttachments = color_atts,
-            .depthStencilAttachment = depth_atts,
-        };
-        return wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-    }
-};
+bool is_ktx2_path(char const* const path)
+{
+    return path && std::string_view{path}.ends_with(".ktx2");
+}
 
 struct DepthTarget
 {
@@ -164,52 +131,148 @@ struct DepthTarget
 
 struct RenderMesh
 {
-    static constexpr WGPUIndexFormat index_format{WGPUIndexFormat_Uint16};
-    WGPUBuffer vertices;
-    WGPUBuffer indices;
+    enum VertexFormat : u8
+    {
+        VertexFormat_Float = 0, // Float32x3 position, Float32x2 tex coords
+        VertexFormat_Quantized, // Snorm16x4 position, Unorm16x2 tex coords
+        VertexFormat_Count,
+    };
+
+    static constexpr WGPUBufferUsage buffer_usage{
+        WGPUBufferUsage_Vertex | WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst};
+    static constexpr VertexAttributes float_attributes{
+        .position = 0,
+        .tex_coords = sizeof(f32[3]),
+    };
+    BufferPool::Allocation vertices;
+    BufferPool::Allocation indices;
     isize index_count;
+    WGPUIndexFormat index_format;
+    VertexFormat vertex_format;
+
+    // Maps stored positions to local space
+    f32 position_scale[3]{1.0f, 1.0f, 1.0f};
+    f32 position_offset[3];
 
     static RenderMesh make(
-        WGPUDevice const device,
+        BufferPool& buffers,
+        UploadRing& uploads,
         Span<u8 const> const& vertex_data,
-        Span<u8 const> const& index_data)
+        Span<u8 const> const& index_data,
+        WGPUIndexFormat const index_format)
     {
+        assert((buffers.usage & buffer_usage) == buffer_usage);
         RenderMesh result{};
 
-        // Create buffers
-        result.vertices = make_buffer(
-            device,
-            vertex_data.size(),
-            WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst);
-        assert(result.vertices);
-
-        result.indices = make_buffer(
-            device,
-            index_data.size(),
-            WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst);
-        assert(result.indices);
-
-        auto const unmap = defer([&]() {
-            wgpuBufferUnmap(result.vertices);
-            wgpuBufferUnmap(result.indices);
-        });
+        // Allocate buffer ranges
+        result.vertices = buffers.allocate(vertex_data.size());
+        assert(result.vertices.is_valid());
+
+        result.indices = buffers.allocate(index_data.size());
+        assert(result.indices.is_valid());
 
-        // Copy data to buffers
-        auto const copy_data = [](WGPUBuffer const dst, Span<u8 const> const& src) {
-            void* dst_ptr = wgpuBufferGetMappedRange(dst, 0, src.size());
-            assert(dst_ptr);
-            std::memcpy(dst_ptr, src.data(), src.size());
+        // Stage data for upload. Copies are recorded with the next batch of uploads.
+        auto const upload = [&](BufferRange const& dst, Span<u8 const> const& src) {
+            uploads.write(dst.buffer, dst.offset, src.data(), src.size());
         };
-        copy_data(result.vertices, vertex_data);
-        copy_data(result.indices, index_data);
+        upload(result.vertices.range, vertex_data);
+        upload(result.indices.range, index_data);
 
-        constexpr i8 index_stride = sizeof(u16);
+        isize const index_stride = (index_format == WGPUIndexFormat_Uint16) ? 2 : 4;
         result.index_count = index_data.size() / index_stride;
+        result.index_format = index_format;
+
+        return result;
+    }
+
+    // Makes a mesh with the smallest index format that fits. If allowed, vertices are quantized
+    // as long as the error is within tolerance.
+    static RenderMesh make(
+        BufferPool& buffers,
+        UploadRing& uploads,
+        MeshBuffers const& mesh,
+        bool const allow_quantized)
+    {
+        WGPUIndexFormat const format = select_index_format(mesh.get_vertex_count());
+        std::vector<u8> const index_data = pack_indices(mesh.indices, format);
+
+        MeshBuffers quantized{};
+        VertexQuantization quant{};
+        if (allow_quantized)
+        {
+            quant = quantize_vertices(mesh, float_attributes, quantized);
+            quant.report();
+        }
+
+        bool const is_quantized = allow_quantized && quant.is_within({});
+        MeshBuffers const& src = is_quantized ? quantized : mesh;
+
+        RenderMesh result = make(
+            buffers,
+            uploads,
+            {src.vertices.data(), isize(src.vertices.size())},
+            {index_data.data(), isize(index_data.size())},
+            format);
+
+        if (is_quantized)
+        {
+            result.vertex_format = VertexFormat_Quantized;
+            std::copy_n(quant.position_scale, 3, result.position_scale);
+            std::copy_n(quant.position_offset, 3, result.position_offset);
+        }
+
+        return result;
+    }
+
+    // Makes a mesh from a binary mesh file. Vertex data is streamed from the mapped file straight
+    // into staging memory. Returns an invalid mesh if the file's vertex layout isn't supported.
+    static RenderMesh make(BufferPool& buffers, UploadRing& uploads, MeshFile const& file)
+    {
+        assert((buffers.usage & buffer_usage) == buffer_usage);
+        MeshFileHeader const& header = *file.header;
+
+        // Only position and tex coords are used
+        bool const is_quantized = header.is_quantized != 0;
+        VertexAttributes const& attrs = header.attributes;
+        u32 const expect_stride = is_quantized ? sizeof(i16[4]) + sizeof(u16[2]) : sizeof(f32[5]);
+        u32 const expect_tex_coords = is_quantized ? sizeof(i16[4]) : sizeof(f32[3]);
+        if (header.vertex_stride != expect_stride || attrs.position != 0
+            || attrs.tex_coords != expect_tex_coords || attrs.normal != VertexAttributes::none)
+        {
+            return {};
+        }
+
+        RenderMesh result{};
+        result.vertices = buffers.allocate(header.vertex_size);
+        assert(result.vertices.is_valid());
+
+        result.indices = buffers.allocate(header.index_size);
+        assert(result.indices.is_valid());
+
+        // Copies are submitted as they're staged to keep staging memory bounded for large files
+        auto const upload = [&](BufferRange const& dst, u64 const offset, u64 const size) {
+            upload_file_range(file.file, offset, size, uploads, dst.buffer, dst.offset, true);
+        };
+        upload(result.vertices.range, header.vertex_offset, header.vertex_size);
+        upload(result.indices.range, header.index_offset, header.index_size);
+
+        result.index_count = header.index_count;
+        result.index_format = WGPUIndexFormat(header.index_format);
+
+        if (is_quantized)
+        {
+            result.vertex_format = VertexFormat_Quantized;
+            std::copy_n(header.position_scale, 3, result.position_scale);
+            std::copy_n(header.position_offset, 3, result.position_offset);
+        }
 
         return result;
     }
 
-    static RenderMesh make_box(WGPUDevice const device)
+    static RenderMesh make_box(
+        BufferPool& buffers,
+        UploadRing& uploads,
+        bool const allow_quantized)
     {
         // clang-format off
         // Format: x, y, z, u, v
@@ -247,7 +310,7 @@ struct RenderMesh
         };
         // clang-format on
 
-        static constexpr u16 faces[][3]{
+        static constexpr u32 faces[][3]{
             {1, 0, 2},
             {2, 3, 1},
             {4, 5, 7},
@@ -264,52 +327,88 @@ struct RenderMesh
             {23, 22, 20},
         };
 
-        return make(device, as<u8>(as_span(vertices)), as<u8>(as_span(faces)));
+        MeshBuffers mesh{};
+        mesh.vertex_stride = sizeof(vertices[0]);
+        Span<u8 const> const vertex_data = as<u8>(as_span(vertices));
+        mesh.vertices.assign(vertex_data.data(), vertex_data.data() + vertex_data.size());
+        mesh.indices.assign(&faces[0][0], &faces[0][0] + size(faces) * 3);
+        optimize_mesh(mesh);
+
+        return make(buffers, uploads, mesh, allow_quantized);
     }
 
-    static void release(RenderMesh& mesh)
+    static void release(RenderMesh& mesh, BufferPool& buffers)
     {
-        wgpuBufferRelease(mesh.vertices);
-        wgpuBufferRelease(mesh.indices);
+        buffers.free(mesh.vertices);
+        buffers.free(mesh.indices);
         mesh = {};
     }
 
     void bind_resources(WGPURenderPassEncoder const encoder)
     {
-        wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, vertices, 0, wgpuBufferGetSize(vertices));
+        BufferRange const& verts = vertices.range;
+        wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, verts.buffer, verts.offset, verts.size);
+
+        BufferRange const& inds = indices.range;
         wgpuRenderPassEncoderSetIndexBuffer(
             encoder,
-            indices,
+            inds.buffer,
+            index_format,
+            inds.offset,
+            inds.size);
+    }
+
+    void bind_resources(WGPURenderBundleEncoder const encoder)
+    {
+        BufferRange const& verts = vertices.range;
+        wgpuRenderBundleEncoderSetVertexBuffer(encoder, 0, verts.buffer, verts.offset, verts.size);
+
+        BufferRange const& inds = indices.range;
+        wgpuRenderBundleEncoderSetIndexBuffer(
+            encoder,
+            inds.buffer,
             index_format,
-            0,
-            wgpuBufferGetSize(indices));
+            inds.offset,
+            inds.size);
     }
 
-    void dispatch_draw(WGPURenderPassEncoder const encoder) const
+    void dispatch_draw(WGPURenderPassEncoder const encoder, u32 const instance_count = 1) const
     {
-        wgpuRenderPassEncoderDrawIndexed(encoder, index_count, 1, 0, 0, 0);
+        wgpuRenderPassEncoderDrawIndexed(encoder, index_count, instance_count, 0, 0, 0);
     }
 
-  private:
-    static WGPUBuffer make_buffer(
-        WGPUDevice const device,
-        size_t const size,
-        WGPUBufferUsage const usage)
+    void dispatch_draw(WGPURenderBundleEncoder const encoder, u32 const instance_count = 1) const
     {
-        WGPUBufferDescriptor const desc{
-            .usage = usage,
-            .size = size,
-            .mappedAtCreation = true,
-        };
-        return wgpuDeviceCreateBuffer(device, &desc);
+        wgpuRenderBundleEncoderDrawIndexed(encoder, index_count, instance_count, 0, 0, 0);
+    }
+
+    void add_to_hash(Hasher& hasher) const
+    {
+        hasher.add(vertices.range.buffer);
+        hasher.add(vertices.range.offset);
+        hasher.add(indices.range.buffer);
+        hasher.add(indices.range.offset);
+        hasher.add(index_count);
+        hasher.add(index_format);
+        hasher.add(vertex_format);
     }
 };
 
+// Color map image being loaded in the background. Only one of the two results is requested
+// depending on whether decoded images are cached.
+struct PendingImage
+{
+    AssetPack const* pack;
+    char const* path;
+    std::future<CachedTexture> cached;
+    std::future<ImageAsset> decoded;
+};
+
 struct RenderMaterial
 {
     static inline WGPUBindGroupLayout bind_group_layout{};
     static inline WGPUPipelineLayout pipeline_layout{};
-    static inline WGPURenderPipeline pipeline{};
+    static inline WGPURenderPipeline pipelines[RenderMesh::VertexFormat_Count]{};
     struct
     {
         WGPUTexture texture;
@@ -317,56 +416,129 @@ struct RenderMaterial
         WGPUSampler sampler;
     } static inline color_map;
 
-    WGPUBuffer uniform_buffer;
-    WGPUBindGroup bind_group;
-    struct
+    // Per-draw uniforms, bound at a dynamic offset
+    struct Uniforms
     {
         f32 local_to_clip[16];
-    } uniforms{};
+        f32 position_scale[4];
+        f32 position_offset[4];
+    };
 
-    static void init(WGPUDevice const device, WGPUTextureFormat const surface_format)
+    // Per-instance vertex attributes
+    struct Instance
+    {
+        f32 local_to_world[16];
+        f32 tint[4];
+    };
+
+    WGPUBindGroup bind_group;
+
+    static void init(
+        WGPUDevice const device,
+        PipelineCache& cache,
+        WGPUTextureFormat const surface_format,
+        ShaderAsset const& shader,
+        PendingImage& image,
+        char const* const ktx2_path)
     {
         bind_group_layout = make_bind_group_layout(device);
         pipeline_layout = make_pipeline_layout(device, bind_group_layout);
 
-        // Init pipeline
+        // Init pipeline for each vertex format
+        for (u8 i = 0; i < RenderMesh::VertexFormat_Count; ++i)
         {
-            ShaderAsset const& asset = load_shader_asset("assets/shaders/unlit_texture.wgsl");
-            pipeline = make_pipeline(
-                device,
+            pipelines[i] = make_pipeline(
+                cache,
                 pipeline_layout,
-                {asset.src.c_str(), WGPU_STRLEN},
+                {shader.src.c_str(), WGPU_STRLEN},
+                RenderMesh::VertexFormat(i),
                 surface_format,
                 DepthTarget::format);
-            assert(pipeline);
+            assert(pipelines[i]);
+        }
+
+        // Init color map from a KTX2 file if given. These carry their own mip chain.
+        WGPUTextureFormat view_format = WGPUTextureFormat_RGBA8Unorm;
+        if (ktx2_path)
+        {
+            Ktx2TextureInfo info{};
+            color_map.texture = make_texture_from_ktx2(
+                device,
+                ktx2_path,
+                TextureCompressionSupport::make(device),
+                &info);
+
+            if (color_map.texture)
+            {
+                info.report(ktx2_path);
+
+                // Sample sRGB data without conversion, same as PNG images
+                view_format = get_linear_view_format(info.format);
+            }
+            else
+            {
+                fmt::println("Failed to load texture from {}, using default", ktx2_path);
+            }
         }
 
-        // Init color map
+        if (!color_map.texture && image.cached.valid())
         {
-            ImageAsset const& asset = load_image_asset("assets/images/cube-faces.png");
+            // Blocks if the image is still being loaded. Cached images carry their own mip chain.
+            CachedTexture cached = image.cached.get();
+            auto const drop_cached = defer([&]() { CachedTexture::release(cached); });
+
+            if (cached.is_valid())
+            {
+                cached.report(image.path);
+                color_map.texture = make_texture_from_cache(device, cached);
+            }
+            else
+            {
+                fmt::println("Failed to load image from {}, using default", image.path);
+            }
+        }
+
+        if (!color_map.texture)
+        {
+            // Blocks if the image is still being decoded
+            ImageAsset const asset =
+                image.decoded.valid() ? image.decoded.get()
+                                      : load_image_asset(*image.pack, default_image_path);
             color_map.texture = make_color_texture(
                 device,
                 asset.data.get(),
                 asset.width,
                 asset.height,
-                asset.stride,
-                color_map.view,
-                color_map.sampler);
+                asset.stride);
             assert(color_map.texture);
-            assert(color_map.view);
-            assert(color_map.sampler);
+
+            // Fill the rest of the mip chain on the GPU. Image data is sRGB encoded.
+            MipmapGenerator mipmaps = MipmapGenerator::make(device);
+            mipmaps.generate(device, &color_map.texture, 1, true);
+            MipmapGenerator::release(mipmaps);
         }
+
+        u32 const level_count = wgpuTextureGetMipLevelCount(color_map.texture);
+        color_map.view = make_color_view(color_map.texture, view_format, level_count);
+        color_map.sampler = make_color_sampler(device, level_count);
+        assert(color_map.view);
+        assert(color_map.sampler);
     }
 
-    static void deinit()
+    // Color map resources are released through the bind group cache so that any cached bind groups
+    // that refer to them are dropped too
+    static void deinit(BindGroupCache& bind_groups)
     {
-        wgpuTextureViewRelease(color_map.view);
-        wgpuSamplerRelease(color_map.sampler);
+        bind_groups.release_resource(color_map.view);
+        bind_groups.release_resource(color_map.sampler);
         wgpuTextureRelease(color_map.texture);
         color_map = {};
 
-        wgpuRenderPipelineRelease(pipeline);
-        pipeline = {};
+        for (WGPURenderPipeline& pipeline : pipelines)
+        {
+            wgpuRenderPipelineRelease(pipeline);
+            pipeline = {};
+        }
 
         wgpuPipelineLayoutRelease(pipeline_layout);
         pipeline_layout = {};
@@ -375,31 +547,26 @@ struct RenderMaterial
         bind_group_layout = {};
     }
 
-    static RenderMaterial make(WGPUDevice const device)
+    static RenderMaterial make(BindGroupCache& bind_groups, WGPUBuffer const uniform_buffer)
     {
         RenderMaterial result{};
-
-        result.uniform_buffer = make_uniform_buffer(device, sizeof(uniforms));
-        assert(result.uniform_buffer);
-
-        result.update_bind_group(device);
+        result.update_bind_group(bind_groups, uniform_buffer);
         return result;
     }
 
     static void release(RenderMaterial& material)
     {
-        wgpuBufferRelease(material.uniform_buffer);
         wgpuBindGroupRelease(material.bind_group);
         material = {};
     }
 
-    void update_bind_group(WGPUDevice const device)
+    void update_bind_group(BindGroupCache& bind_groups, WGPUBuffer const uniform_buffer)
     {
         if (bind_group)
             wgpuBindGroupRelease(bind_group);
 
         bind_group = make_bind_group(
-            device,
+            bind_groups,
             bind_group_layout,
             color_map.view,
             color_map.sampler,
@@ -407,19 +574,37 @@ struct RenderMaterial
         assert(bind_group);
     }
 
-    void update_uniform_buffer(WGPUQueue const queue)
+    void apply_pipeline(
+        WGPURenderPassEncoder const encoder,
+        RenderMesh::VertexFormat const vertex_format)
     {
-        wgpuQueueWriteBuffer(queue, uniform_buffer, 0, &uniforms, sizeof(uniforms));
+        wgpuRenderPassEncoderSetPipeline(encoder, pipelines[vertex_format]);
     }
 
-    void apply_pipeline(WGPURenderPassEncoder const encoder)
+    void apply_pipeline(
+        WGPURenderBundleEncoder const encoder,
+        RenderMesh::VertexFormat const vertex_format)
     {
-        wgpuRenderPassEncoderSetPipeline(encoder, pipeline);
+        wgpuRenderBundleEncoderSetPipeline(encoder, pipelines[vertex_format]);
     }
 
-    void bind_resources(WGPURenderPassEncoder const encoder)
+    // Binds resources with uniforms at the given offset in the uniform buffer
+    void bind_resources(WGPURenderPassEncoder const encoder, u32 const uniform_offset)
+    {
+        wgpuRenderPassEncoderSetBindGroup(encoder, 0, bind_group, 1, &uniform_offset);
+    }
+
+    void bind_resources(WGPURenderBundleEncoder const encoder, u32 const uniform_offset)
     {
-        wgpuRenderPassEncoderSetBindGroup(encoder, 0, bind_group, 0, nullptr);
+        wgpuRenderBundleEncoderSetBindGroup(encoder, 0, bind_group, 1, &uniform_offset);
+    }
+
+    void add_to_hash(Hasher& hasher) const
+    {
+        for (WGPURenderPipeline const pipeline : pipelines)
+            hasher.add(pipeline);
+
+        hasher.add(bind_group);
     }
 
   private:
@@ -450,8 +635,8 @@ struct RenderMaterial
                 .visibility = WGPUShaderStage_Vertex,
                 .buffer{
                     .type = WGPUBufferBindingType_Uniform,
-                    .hasDynamicOffset = false,
-                    .minBindingSize = 0,
+                    .hasDynamicOffset = true,
+                    .minBindingSize = sizeof(Uniforms),
                 },
             },
         };
@@ -474,39 +659,55 @@ struct RenderMaterial
     }
 
     static WGPURenderPipeline make_pipeline(
-        WGPUDevice const device,
+        PipelineCache& cache,
         WGPUPipelineLayout const layout,
         WGPUStringView const shader_src,
+        RenderMesh::VertexFormat const vertex_format,
         WGPUTextureFormat const surface_format,
         WGPUTextureFormat const depth_format)
     {
-        WGPUShaderSourceWGSL shader_desc_src{
-            .chain = {.sType = WGPUSType_ShaderSourceWGSL},
-            .code = shader_src,
-        };
-        WGPUShaderModuleDescriptor const shader_desc{
-            .nextInChain = as<WGPUChainedStruct>(&shader_desc_src),
-        };
-        WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+        WGPUShaderModule const shader = cache.get_shader_module(shader_src);
         auto const drop_shader = defer([=]() { wgpuShaderModuleRelease(shader); });
 
+        // Positions are read as vec4f in the shader so either format works
+        bool const is_quantized = vertex_format == RenderMesh::VertexFormat_Quantized;
+        u64 const tex_coords_offset = is_quantized ? sizeof(i16[4]) : sizeof(float[3]);
         WGPUVertexAttribute const vert_attrs[]{
             {
-                .format = WGPUVertexFormat_Float32x3,
+                .format = is_quantized ? WGPUVertexFormat_Snorm16x4 : WGPUVertexFormat_Float32x3,
                 .offset = 0,
                 .shaderLocation = 0,
             },
             {
-                .format = WGPUVertexFormat_Float32x2,
-                .offset = sizeof(float[3]),
+                .format = is_quantized ? WGPUVertexFormat_Unorm16x2 : WGPUVertexFormat_Float32x2,
+                .offset = tex_coords_offset,
                 .shaderLocation = 1,
             },
         };
-        WGPUVertexBufferLayout const vert_buf_layout{
-            .stepMode = WGPUVertexStepMode_Vertex,
-            .arrayStride = sizeof(float[5]),
-            .attributeCount = size(vert_attrs),
-            .attributes = vert_attrs,
+        // Instance transform is passed as 4 columns followed by tint
+        WGPUVertexAttribute inst_attrs[5];
+        for (u32 i = 0; i < size(inst_attrs); ++i)
+        {
+            inst_attrs[i] = {
+                .format = WGPUVertexFormat_Float32x4,
+                .offset = i * sizeof(float[4]),
+                .shaderLocation = 2 + i,
+            };
+        }
+
+        WGPUVertexBufferLayout const vert_buf_layouts[]{
+            {
+                .stepMode = WGPUVertexStepMode_Vertex,
+                .arrayStride = is_quantized ? sizeof(i16[4]) + sizeof(u16[2]) : sizeof(float[5]),
+                .attributeCount = size(vert_attrs),
+                .attributes = vert_attrs,
+            },
+            {
+                .stepMode = WGPUVertexStepMode_Instance,
+                .arrayStride = sizeof(Instance),
+                .attributeCount = size(inst_attrs),
+                .attributes = inst_attrs,
+            },
         };
 
         WGPUDepthStencilState const depth_state{
@@ -531,8 +732,8 @@ struct RenderMaterial
             .vertex{
                 .module = shader,
                 .entryPoint = {"vs_main", WGPU_STRLEN},
-                .bufferCount = 1,
-                .buffers = &vert_buf_layout,
+                .bufferCount = size(vert_buf_layouts),
+                .buffers = vert_buf_layouts,
             },
             .primitive{
                 .topology = WGPUPrimitiveTopology_TriangleList,
@@ -548,7 +749,7 @@ struct RenderMaterial
             .fragment = &frag_state,
         };
 
-        return wgpuDeviceCreateRenderPipeline(device, &pipe_desc);
+        return cache.get_render_pipeline(pipe_desc);
     }
 
     static WGPUTexture make_color_texture(
@@ -556,9 +757,7 @@ struct RenderMaterial
         void* const data,
         uint32_t const width,
         uint32_t const height,
-        uint32_t const stride,
-        WGPUTextureView& view,
-        WGPUSampler& sampler)
+        uint32_t const stride)
     {
         WGPUTextureFormat const format = WGPUTextureFormat_RGBA8Unorm;
         WGPUExtent3D const size = {width, height, 1};
@@ -566,11 +765,11 @@ struct RenderMaterial
         uint32_t const data_size = row_size * height;
 
         WGPUTextureDescriptor const texture_desc{
-            .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+            .usage = mipmap_texture_usage | WGPUTextureUsage_CopyDst,
             .dimension = WGPUTextureDimension_2D,
             .size = size,
             .format = format,
-            .mipLevelCount = 1,
+            .mipLevelCount = get_mip_level_count(width, height),
             .sampleCount = 1,
         };
         WGPUTexture const texture = wgpuDeviceCreateTexture(device, &texture_desc);
@@ -586,37 +785,37 @@ struct RenderMaterial
         WGPUQueue const queue = wgpuDeviceGetQueue(device);
         wgpuQueueWriteTexture(queue, &copy_info, data, data_size, &copy_layout, &size);
 
-        // Create view
-        WGPUTextureViewDescriptor const view_desc{
+        return texture;
+    }
+
+    static WGPUTextureView make_color_view(
+        WGPUTexture const texture,
+        WGPUTextureFormat const format,
+        uint32_t const level_count)
+    {
+        WGPUTextureViewDescriptor const desc{
             .format = format,
             .dimension = WGPUTextureViewDimension_2D,
-            .mipLevelCount = 1,
+            .mipLevelCount = level_count,
             .arrayLayerCount = 1,
         };
-        view = wgpuTextureCreateView(texture, &view_desc);
-
-        // Create sampler
-        WGPUSamplerDescriptor const sampler_desc{
-            .magFilter = WGPUFilterMode_Nearest,
-            .minFilter = WGPUFilterMode_Nearest,
-            .maxAnisotropy = 1,
-        };
-        sampler = wgpuDeviceCreateSampler(device, &sampler_desc);
-
-        return texture;
+        return wgpuTextureCreateView(texture, &desc);
     }
 
-    static WGPUBuffer make_uniform_buffer(WGPUDevice const device, size_t const size)
+    static WGPUSampler make_color_sampler(WGPUDevice const device, uint32_t const level_count)
     {
-        WGPUBufferDescriptor const buf_desc{
-            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
-            .size = size,
+        WGPUSamplerDescriptor const desc{
+            .magFilter = WGPUFilterMode_Nearest,
+            .minFilter = WGPUFilterMode_Linear,
+            .mipmapFilter = WGPUMipmapFilterMode_Linear,
+            .lodMaxClamp = f32(level_count),
+            .maxAnisotropy = 1,
         };
-        return wgpuDeviceCreateBuffer(device, &buf_desc);
+        return wgpuDeviceCreateSampler(device, &desc);
     }
 
     static WGPUBindGroup make_bind_group(
-        WGPUDevice const device,
+        BindGroupCache& cache,
         WGPUBindGroupLayout const layout,
         WGPUTextureView const color_view,
         WGPUSampler const color_sampler,
@@ -634,7 +833,7 @@ struct RenderMaterial
             {
                 .binding = 2,
                 .buffer = uniforms,
-                .size = wgpuBufferGetSize(uniforms),
+                .size = sizeof(Uniforms),
             },
         };
 
@@ -643,7 +842,7 @@ struct RenderMaterial
             .entryCount = size(entries),
             .entries = entries,
         };
-        return wgpuDeviceCreateBindGroup(device, &bg_desc);
+        return cache.get(bg_desc);
     }
 };
 
@@ -651,9 +850,26 @@ struct AppState
 {
     GLFWwindow* window;
     GpuContext gpu;
+    FrameTimer frame_timer;
+    FramePacer pacer;
+    PipelineCache pipelines;
+    BindGroupCache bind_groups;
+    UploadRing uploads;
+    BufferPool mesh_buffers;
+    UniformRing uniforms;
+    RenderBundleCache bundles;
+    bool use_bundles{true};
+    bool use_quantized{true};
+    bool use_async_assets{true};
+    char const* mesh_path;
+    char const* texture_path;
+    char const* cache_dir{default_cache_dir};
+    AssetPack pack;
+    std::chrono::steady_clock::time_point start_time;
     DepthTarget depth;
     RenderMaterial material;
     RenderMesh geometry;
+    InstanceBuffer instances;
     struct
     {
         f32 fov_y{deg_to_rad(60.0f)};
@@ -665,8 +881,86 @@ struct AppState
 
 AppState state{};
 
+constexpr usize max_draw_count = 256;
+
+// Assets that are read and decoded in the background while the device is being created
+struct PendingAssets
+{
+    std::future<ShaderAsset> shader;
+    PendingImage image; // Not requested for KTX2 textures
+    std::future<MeshBuffers> mesh; // Only requested for imported meshes
+};
+
+// Imports a scene and merges it into a single optimized mesh. Returns an empty mesh on failure.
+MeshBuffers import_mesh(char const* const path, TaskPool& pool)
+{
+    ImportedScene scene{};
+    ImportOptions const options{.with_normals = false, .optimize = false};
+    if (!import_scene(path, pool, options, scene))
+        return {};
+
+    scene.report();
+    MeshBuffers result = bake_instances(scene);
+    optimize_mesh(result);
+
+    return result;
+}
+
+PendingAssets load_assets(AssetLoader& loader, TaskPool& pool)
+{
+    PendingAssets result{};
+    result.shader = load_shader_asset(loader, state.pack, shader_path);
+    result.image.pack = &state.pack;
+
+    if (!is_ktx2_path(state.texture_path))
+    {
+        char const* const path = state.texture_path ? state.texture_path : default_image_path;
+        result.image.path = path;
+
+        if (state.cache_dir)
+        {
+            result.image.cached = loader.submit([path, dir = state.cache_dir]() {
+                // Packed images are hashed in place without being copied out of the pack
+                AssetPackEntry const* const entry = state.pack.find(path);
+                if (!entry)
+                    return load_cached_texture(path, dir);
+
+                std::vector<u8> buffer{};
+                return load_cached_texture(state.pack.read(*entry, buffer), dir);
+            });
+        }
+        else
+        {
+            result.image.decoded = load_image_asset(loader, state.pack, path);
+        }
+    }
+
+    // Binary mesh files are streamed straight to the GPU so only imports are done up front
+    if (state.mesh_path && !std::string_view{state.mesh_path}.ends_with(".mesh"))
+    {
+        result.mesh = loader.submit([path = state.mesh_path, &pool]() {
+            return import_mesh(path, pool);
+        });
+    }
+
+    return result;
+}
+
 void init_app()
 {
+    // Open the asset pack if there is one. Assets that aren't packed are read from loose files.
+    state.pack = AssetPack::make(asset_pack_path);
+    if (state.pack.is_valid())
+        fmt::println("Opened {} ({} assets)", asset_pack_path, state.pack.header->entry_count);
+
+    // Start loading assets before creating the device so that the two overlap. Loading jobs and
+    // any parallel work within them share one pool. Without async loading, assets are loaded right
+    // here instead.
+    TaskPool pool = TaskPool::make(std::max(std::thread::hardware_concurrency(), 1u));
+    auto const drop_pool = defer([&]() { TaskPool::release(pool); });
+    AssetLoader loader = AssetLoader::make(state.use_async_assets ? &pool : nullptr);
+    PendingAssets assets = load_assets(loader, pool);
+
     // Initialize GLFW
     bool const glfw_ok = glfwInit();
     assert(glfw_ok);
@@ -692,6 +986,30 @@ void init_app()
     state.gpu = GpuContext::make({state.window, "#textured-mesh"});
     state.gpu.report();
 
+    // Create staging ring for buffer uploads
+    state.uploads = UploadRing::make(state.gpu.device);
+
+    // Create pool that mesh buffers are allocated from
+    state.mesh_buffers = BufferPool::make(state.gpu.device, RenderMesh::buffer_usage);
+
+    // Limit the number of frames the CPU can get ahead of the GPU
+    state.pacer = FramePacer::make(state.gpu.device, 2);
+
+    // Create ring for per-draw uniforms with a region for each frame in flight
+    state.uniforms = UniformRing::make(
+        state.gpu.device,
+        max_draw_count,
+        sizeof(RenderMaterial::Uniforms),
+        state.pacer.frames_in_flight);
+
+    // Create cache for recorded draws with a bundle for each uniform region
+    state.bundles = RenderBundleCache::make(
+        state.gpu.device,
+        &state.gpu.surface_format,
+        1,
+        DepthTarget::format,
+        state.uniforms.frame_count);
+
     // Create additional render targets
     int fb_size[2];
     glfwGetFramebufferSize(state.window, fb_size, fb_size + 1);
@@ -721,19 +1039,106 @@ void init_app()
 #endif
 
     // Init materials and create instance
-    RenderMaterial::init(state.gpu.device, default_surface_format);
-    state.material = RenderMaterial::make(state.gpu.device);
+    state.pipelines = PipelineCache::make(state.gpu.device);
+    RenderMaterial::init(
+        state.gpu.device,
+        state.pipelines,
+        state.gpu.surface_format,
+        assets.shader.get(),
+        assets.image,
+        is_ktx2_path(state.texture_path) ? state.texture_path : nullptr);
+    state.pipelines.report();
+    state.bind_groups = BindGroupCache::make(state.gpu.device);
+    state.material = RenderMaterial::make(state.bind_groups, state.uniforms.buffer);
 
     // Create mesh
-    state.geometry = RenderMesh::make_box(state.gpu.device);
+    if (state.mesh_path)
+    {
+        if (assets.mesh.valid())
+        {
+            MeshBuffers const mesh = assets.mesh.get();
+            if (!mesh.indices.empty())
+            {
+                state.geometry = RenderMesh::make(
+                    state.mesh_buffers,
+                    state.uploads,
+                    mesh,
+                    state.use_quantized);
+            }
+        }
+        else
+        {
+            MeshFile file = MeshFile::make(state.mesh_path);
+            auto const drop_file = defer([&]() { MeshFile::release(file); });
+
+            if (file.is_valid())
+                state.geometry = RenderMesh::make(state.mesh_buffers, state.uploads, file);
+        }
+
+        if (!state.geometry.vertices.is_valid())
+            fmt::println("Failed to load mesh from {}, using default", state.mesh_path);
+    }
+
+    if (!state.geometry.vertices.is_valid())
+    {
+        state.geometry =
+            RenderMesh::make_box(state.mesh_buffers, state.uploads, state.use_quantized);
+    }
+}
+
+// Fills a cube with a grid of smaller copies of the mesh. A single instance covers the whole cube.
+// At least one instance is always created.
+void set_instances(u32 count)
+{
+    count = std::max(count, 1u);
+
+    u32 side = 1;
+    while (side * side * side < count)
+        ++side;
+
+    f32 const cell = 1.0f / side;
+    f32 const scale = (side > 1) ? 0.8f * cell : 1.0f;
+    f32 const margin = 0.5f * (cell - scale);
+
+    state.instances = InstanceBuffer::make(sizeof(RenderMaterial::Instance));
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 const index[]{i % side, (i / side) % side, i / (side * side)};
+
+        RenderMaterial::Instance inst{};
+        as_mat<4, 4>(inst.local_to_world) = Mat4<f32>::Identity();
+        for (int j = 0; j < 3; ++j)
+        {
+            inst.local_to_world[j * 5] = scale;
+            inst.local_to_world[12 + j] = f32(index[j]) * cell + margin;
+            inst.tint[j] = (side > 1) ? 0.5f + 0.5f * f32(index[j]) / f32(side - 1) : 1.0f;
+        }
+        inst.tint[3] = 1.0f;
+
+        state.instances.push(inst);
+    }
+
+    state.instances.upload(state.gpu.device, wgpuDeviceGetQueue(state.gpu.device));
 }
 
 void deinit_app()
 {
-    RenderMesh::release(state.geometry);
+    FramePacer::release(state.pacer);
+    InstanceBuffer::release(state.instances);
+    RenderMesh::release(state.geometry, state.mesh_buffers);
     RenderMaterial::release(state.material);
+    RenderMaterial::deinit(state.bind_groups);
     DepthTarget::release(state.depth);
+    RenderBundleCache::release(state.bundles);
+    state.bind_groups.invalidate(state.uniforms.buffer);
+    UniformRing::release(state.uniforms);
+    BindGroupCache::release(state.bind_groups);
+    BufferPool::release(state.mesh_buffers);
+    UploadRing::release(state.uploads);
+    PipelineCache::release(state.pipelines);
     GpuContext::release(state.gpu);
+    AssetPack::release(state.pack);
     glfwDestroyWindow(state.window);
     glfwTerminate();
     state = {};
@@ -778,19 +1183,101 @@ Mat4<f32> make_view_to_clip()
         state.view.clip_far);
 }
 
+// Records all draws for the frame. Only depends on the draw list and the uniform offset so the
+// recorded commands can be reused until either changes.
+template <typename Encoder>
+void record_draws(Encoder const encoder, u32 const uniform_offset)
+{
+    auto& geom = state.geometry;
+    auto& mat = state.material;
+    mat.apply_pipeline(encoder, geom.vertex_format);
+    mat.bind_resources(encoder, uniform_offset);
+    geom.bind_resources(encoder);
+
+    // Draw all instances in one call. The pipeline expects a buffer in the instance slot so
+    // nothing is drawn without one.
+    auto& insts = state.instances;
+    if (insts.count == 0)
+        return;
+
+    insts.bind(encoder, 1);
+    geom.dispatch_draw(encoder, insts.count);
+}
+
+u64 get_draw_list_key(u32 const uniform_offset)
+{
+    Hasher hasher{};
+    state.material.add_to_hash(hasher);
+    state.geometry.add_to_hash(hasher);
+    hasher.add(state.instances.buffer);
+    hasher.add(state.instances.count);
+    hasher.add(uniform_offset);
+    return hasher.value;
+}
+
 } // namespace
 } // namespace wgpu::sandbox
 
-int main(int /*argc*/, char** /*argv*/)
+int main(int argc, char** argv)
 {
     using namespace wgpu::sandbox;
+    state.start_time = std::chrono::steady_clock::now();
+
+    // Parse options
+    u32 instance_count = 1;
+    {
+        char const* trace_path = nullptr;
+        u64 trace_first = 60;
+        u64 trace_count = 120;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            char const* const arg = argv[i];
+            char const* const val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+            if (std::strcmp(arg, "--trace") == 0 && val)
+                trace_path = argv[++i];
+            else if (std::strcmp(arg, "--trace-first") == 0 && val)
+                trace_first = std::strtoull(argv[++i], nullptr, 10);
+            else if (std::strcmp(arg, "--trace-count") == 0 && val)
+                trace_count = std::strtoull(argv[++i], nullptr, 10);
+            else if (std::strcmp(arg, "--instances") == 0 && val)
+                instance_count = std::strtoul(argv[++i], nullptr, 10);
+            else if (std::strcmp(arg, "--no-bundles") == 0)
+                state.use_bundles = false;
+            else if (std::strcmp(arg, "--no-quantize") == 0)
+                state.use_quantized = false;
+            else if (std::strcmp(arg, "--mesh") == 0 && val)
+                state.mesh_path = argv[++i];
+            else if (std::strcmp(arg, "--texture") == 0 && val)
+                state.texture_path = argv[++i];
+            else if (std::strcmp(arg, "--sync-assets") == 0)
+                state.use_async_assets = false;
+            else if (std::strcmp(arg, "--cache-dir") == 0 && val)
+                state.cache_dir = argv[++i];
+            else if (std::strcmp(arg, "--no-cache") == 0)
+                state.cache_dir = nullptr;
+            else
+                fmt::println("Ignoring unknown argument: {}", arg);
+        }
+
+        // Optionally capture a range of frames as a Chrome trace
+        if (trace_path)
+            state.frame_timer.set_trace(trace_path, trace_first, trace_count);
+    }
 
     init_app();
     auto const _ = defer([]() { deinit_app(); });
+    set_instances(instance_count);
 
     // Main loop body
-    constexpr auto loop_cb = [](void* /*userdata*/) {
+    constexpr auto loop_cb = [](void* /*userdata*/, u32 const frame_slot) {
         glfwPollEvents();
+        state.frame_timer.mark(FrameTimer::Phase_Encode);
+
+        // Per-frame uniforms and bundles are indexed by the pacer's slot which is no longer in use
+        // by the GPU
+        state.uniforms.set_frame(frame_slot);
 
         // Create a command encoder from the device
         WGPUCommandEncoder const cmd_encoder = wgpuDeviceCreateCommandEncoder(
@@ -799,29 +1286,42 @@ int main(int /*argc*/, char** /*argv*/)
         assert(cmd_encoder);
         auto const drop_cmd_encoder = defer([=]() { wgpuCommandEncoderRelease(cmd_encoder); });
 
-        WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
+        // Record copies of any staged uploads
+        state.uploads.finish(cmd_encoder);
 
         // Render pass
         {
             RenderPass pass = RenderPass::begin(cmd_encoder, state.gpu.surface, state.depth.view);
             auto const end_pass = defer([&]() { RenderPass::end(pass); });
 
-            auto& mat = state.material;
-            mat.apply_pipeline(pass.encoder);
-
             Mat4<f32> const local_to_world = make_local_to_world();
             Mat4<f32> const world_to_view = make_world_to_view();
             Mat4<f32> const view_to_clip = make_view_to_clip();
 
-            as_mat<4, 4>(mat.uniforms.local_to_clip) = //
-                view_to_clip * world_to_view * local_to_world;
+            RenderMaterial::Uniforms uniforms{};
+            as_mat<4, 4>(uniforms.local_to_clip) = view_to_clip * world_to_view * local_to_world;
+
+            // Stored positions are mapped to local space in the vertex shader
+            std::copy_n(state.geometry.position_scale, 3, uniforms.position_scale);
+            std::copy_n(state.geometry.position_offset, 3, uniforms.position_offset);
 
-            mat.update_uniform_buffer(queue);
-            mat.bind_resources(pass.encoder);
+            u32 const uniform_offset = state.uniforms.push(uniforms);
 
-            auto& geom = state.geometry;
-            geom.bind_resources(pass.encoder);
-            geom.dispatch_draw(pass.encoder);
+            if (state.use_bundles)
+            {
+                // Replay recorded draws unless the draw list has changed
+                WGPURenderBundle const bundle = state.bundles.get(
+                    frame_slot,
+                    get_draw_list_key(uniform_offset),
+                    [&](WGPURenderBundleEncoder const encoder) {
+                        record_draws(encoder, uniform_offset);
+                    });
+                wgpuRenderPassEncoderExecuteBundles(pass.encoder, 1, &bundle);
+            }
+            else
+            {
+                record_draws(pass.encoder, uniform_offset);
+            }
         }
 
         // Create encoded commands
@@ -829,13 +1329,38 @@ int main(int /*argc*/, char** /*argv*/)
         assert(cmds);
         auto const drop_cmds = defer([=]() { wgpuCommandBufferRelease(cmds); });
 
-        // Submit encoded commands
+        // Write uniforms and submit encoded commands
+        state.frame_timer.mark(FrameTimer::Phase_Submit);
+        WGPUQueue const queue = wgpuDeviceGetQueue(state.gpu.device);
+        state.uniforms.flush(queue);
         wgpuQueueSubmit(queue, 1, &cmds);
+        state.uploads.submit();
+
+        if (state.frame_count == 0)
+        {
+            using std::chrono::steady_clock, std::chrono::duration;
+            fmt::println(
+                "Time to first frame: {:.1f} ms ({} asset loading, {})",
+                duration<f64, std::milli>(steady_clock::now() - state.start_time).count(),
+                state.use_async_assets ? "async" : "sync",
+                state.cache_dir ? "cached images" : "uncached images");
+        }
 
         ++state.frame_count;
     };
 
-    MainLoop{state.gpu.surface, state.window, loop_cb}.begin();
+    MainLoop const loop{
+        .surface = state.gpu.surface,
+        .window = state.window,
+        .callback = loop_cb,
+        .timer = &state.frame_timer,
+        .pacer = &state.pacer,
+    };
+    loop.begin();
+    state.frame_timer.report();
+
+    if (state.use_bundles)
+        state.bundles.report();
 
     return 0;
 }
@@ -0,0 +1,13 @@
+#include "asset_loader.hpp"
+
+namespace wgpu::sandbox
+{
+
+AssetLoader AssetLoader::make(TaskPool* const pool)
+{
+    AssetLoader result{};
+    result.pool = pool;
+    return result;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "task_pool.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Runs loading jobs (file reads, image decoding, mesh processing, etc.) on the workers of a task
+// pool. Each job returns a future that becomes ready once it has run. Results are picked up by the
+// owning thread, which does any GPU uploads, so jobs only ever touch CPU data. Jobs can run
+// parallel loops on the same pool.
+struct AssetLoader
+{
+    TaskPool* pool;
+
+    // Makes a loader that runs jobs on the given pool. Without a pool, or if the pool has no
+    // workers, jobs run on the calling thread as they're submitted.
+    static AssetLoader make(TaskPool* pool);
+
+    template <typename Func>
+    std::future<std::invoke_result_t<Func>> submit(Func&& func)
+    {
+        using Result = std::invoke_result_t<Func>;
+
+        // NOTE(dr): std::function needs a copyable target so the task is shared
+        auto const task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> result = task->get_future();
+
+        if (pool)
+            pool->enqueue([task]() { (*task)(); });
+        else
+            (*task)();
+
+        return result;
+    }
+};
+
+template <typename T>
+bool is_ready(std::future<T> const& future)
+{
+    return future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+}
+
+} // namespace wgpu::sandbox
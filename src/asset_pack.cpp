@@ -0,0 +1,115 @@
+#include "asset_pack.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#include <zstd.h>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+bool is_within(std::uint64_t const offset, std::uint64_t const size, std::size_t const file_size)
+{
+    return offset <= file_size && size <= file_size - offset;
+}
+
+bool is_valid_header(AssetPackHeader const& header, std::size_t const file_size)
+{
+    std::uint64_t const index_size = std::uint64_t(header.entry_count) * sizeof(AssetPackEntry);
+
+    return header.magic == AssetPackHeader::magic_value
+           && header.version == AssetPackHeader::version_value
+           && is_within(sizeof(header), index_size, file_size)
+           && is_within(header.names_offset, header.names_size, file_size);
+}
+
+bool is_valid_entry(
+    AssetPackEntry const& entry,
+    AssetPackHeader const& header,
+    std::size_t const file_size)
+{
+    bool const is_compression_valid = (entry.compression == AssetCompression::None)
+                                          ? entry.stored_size == entry.size
+                                          : entry.compression == AssetCompression::Zstd;
+
+    return is_compression_valid && entry.offset % AssetPackHeader::payload_alignment == 0
+           && is_within(entry.offset, entry.stored_size, file_size)
+           && std::uint64_t(entry.name_offset) + entry.name_size <= header.names_size;
+}
+
+} // namespace
+
+AssetPack AssetPack::make(char const* const path)
+{
+    static_assert(sizeof(AssetPackHeader) % alignof(AssetPackEntry) == 0);
+
+    AssetPack result{};
+    result.file = MappedFile::make(path);
+
+    if (result.file.is_valid() && result.file.size >= sizeof(AssetPackHeader))
+    {
+        // Mapped memory is page aligned so the header and index can be read in place
+        auto const header = reinterpret_cast<AssetPackHeader const*>(result.file.data);
+        auto const entries = reinterpret_cast<AssetPackEntry const*>(header + 1);
+
+        if (is_valid_header(*header, result.file.size)
+            && std::all_of(entries, entries + header->entry_count, [&](AssetPackEntry const& e) {
+                   return is_valid_entry(e, *header, result.file.size);
+               }))
+        {
+            result.header = header;
+            result.entries = entries;
+            result.names = reinterpret_cast<char const*>(result.file.data + header->names_offset);
+        }
+    }
+
+    return result;
+}
+
+void AssetPack::release(AssetPack& pack)
+{
+    MappedFile::release(pack.file);
+    pack = {};
+}
+
+AssetPackEntry const* AssetPack::find(std::string_view const name) const
+{
+    std::span<AssetPackEntry const> const all = get_entries();
+
+    auto const it = std::lower_bound(
+        all.begin(),
+        all.end(),
+        name,
+        [&](AssetPackEntry const& entry, std::string_view const value) {
+            return get_name(entry) < value;
+        });
+
+    return (it != all.end() && get_name(*it) == name) ? &*it : nullptr;
+}
+
+std::span<std::uint8_t const> AssetPack::read(
+    AssetPackEntry const& entry,
+    std::vector<std::uint8_t>& buffer) const
+{
+    std::span<std::uint8_t const> const stored = file.get_range(entry.offset, entry.stored_size);
+    if (entry.compression == AssetCompression::None)
+        return stored;
+
+    // NOTE(dr): Contexts can't be shared between threads but are costly to create for each of
+    // many small assets so one is kept per thread
+    thread_local std::unique_ptr<ZSTD_DCtx, std::size_t (*)(ZSTD_DCtx*)> const zstd{
+        ZSTD_createDCtx(),
+        ZSTD_freeDCtx};
+
+    buffer.resize(entry.size);
+    std::size_t const size =
+        ZSTD_decompressDCtx(zstd.get(), buffer.data(), buffer.size(), stored.data(), stored.size());
+    if (ZSTD_isError(size) || size != entry.size)
+        return {};
+
+    return buffer;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace wgpu::sandbox
+{
+
+enum class AssetCompression : std::uint32_t
+{
+    None = 0,
+    Zstd,
+};
+
+// Header at the start of an asset pack. It's followed by the index, which holds an entry per asset
+// sorted by name, then a table of names, then payloads, each starting on a payload_alignment
+// boundary. All values are little endian.
+struct AssetPackHeader
+{
+    static constexpr std::uint32_t magic_value = 0x4b434150; // "PACK"
+    static constexpr std::uint32_t version_value = 1;
+    static constexpr std::uint64_t payload_alignment = 64;
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t entry_count;
+    std::uint32_t padding;
+    std::uint64_t names_offset;
+    std::uint64_t names_size;
+};
+
+struct AssetPackEntry
+{
+    std::uint64_t offset; // Offset of the payload from the start of the file
+    std::uint64_t stored_size; // Size of the payload in the file
+    std::uint64_t size; // Size of the asset once decompressed
+    std::uint32_t name_offset; // Offset of the name in the name table
+    std::uint32_t name_size;
+    AssetCompression compression;
+    std::uint32_t padding;
+};
+
+// Memory mapped asset pack. Uncompressed assets are read in place so opening a pack and looking
+// up any number of its assets costs a single file open.
+struct AssetPack
+{
+    MappedFile file;
+    AssetPackHeader const* header;
+    AssetPackEntry const* entries;
+    char const* names;
+
+    // Returns a pack with a null header if the file can't be opened or isn't a valid asset pack
+    static AssetPack make(char const* path);
+
+    static void release(AssetPack& pack);
+
+    bool is_valid() const { return header != nullptr; }
+
+    std::span<AssetPackEntry const> get_entries() const
+    {
+        return {entries, is_valid() ? header->entry_count : 0};
+    }
+
+    std::string_view get_name(AssetPackEntry const& entry) const
+    {
+        return {names + entry.name_offset, entry.name_size};
+    }
+
+    // Returns the entry with the given name or null if there isn't one
+    AssetPackEntry const* find(std::string_view name) const;
+
+    // Returns the contents of an entry. Uncompressed contents point into the mapped file while
+    // compressed contents are decompressed into the given buffer. Returns an empty span if the
+    // entry can't be decompressed.
+    std::span<std::uint8_t const> read(
+        AssetPackEntry const& entry,
+        std::vector<std::uint8_t>& buffer) const;
+};
+
+} // namespace wgpu::sandbox
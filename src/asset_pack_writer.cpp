@@ -0,0 +1,149 @@
+#include "asset_pack_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <numeric>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <zstd.h>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+bool write_zeros(std::FILE* const file, std::uint64_t size)
+{
+    static constexpr std::uint8_t zeros[AssetPackHeader::payload_alignment]{};
+    while (size > 0)
+    {
+        std::uint64_t const n = std::min<std::uint64_t>(size, sizeof(zeros));
+        if (std::fwrite(zeros, 1, n, file) != n)
+            return false;
+
+        size -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+bool write_asset_pack(
+    char const* const path,
+    std::span<AssetPackSource const> const sources,
+    AssetPackOptions const& options)
+{
+    // Entries are sorted by name so that they can be found with a binary search
+    std::vector<std::size_t> order(sources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t const a, std::size_t const b) {
+        return sources[a].name < sources[b].name;
+    });
+
+    std::vector<AssetPackEntry> entries(sources.size());
+    std::string names{};
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        std::string const& name = sources[order[i]].name;
+        if (i > 0 && name == sources[order[i - 1]].name)
+        {
+            fmt::println("Duplicate asset name: {}", name);
+            return false;
+        }
+
+        entries[i].name_offset = std::uint32_t(names.size());
+        entries[i].name_size = std::uint32_t(name.size());
+        names += name;
+    }
+
+    AssetPackHeader header{};
+    header.magic = AssetPackHeader::magic_value;
+    header.version = AssetPackHeader::version_value;
+    header.entry_count = std::uint32_t(entries.size());
+    header.names_offset = sizeof(header) + entries.size() * sizeof(AssetPackEntry);
+    header.names_size = names.size();
+
+    std::FILE* const file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+
+    // Reserve space for the header, index and names which are written once payloads are placed
+    std::uint64_t offset =
+        align_up(header.names_offset + header.names_size, AssetPackHeader::payload_alignment);
+    bool ok = write_zeros(file, offset);
+
+    ZSTD_CCtx* const zstd = ZSTD_createCCtx();
+    std::vector<std::uint8_t> compressed{};
+
+    for (std::size_t i = 0; ok && i < order.size(); ++i)
+    {
+        AssetPackSource const& src = sources[order[i]];
+        AssetPackEntry& entry = entries[i];
+
+        // NOTE(dr): Empty files can't be mapped so they're checked for separately
+        std::error_code err{};
+        MappedFile src_file = MappedFile::make(src.path.c_str());
+        if (!src_file.is_valid() && std::filesystem::file_size(src.path, err) != 0)
+        {
+            fmt::println("Failed to read asset {}", src.path);
+            ok = false;
+            break;
+        }
+
+        if (src_file.is_valid())
+            src_file.advise_sequential();
+
+        void const* data = src_file.data;
+        entry.size = src_file.size;
+        entry.stored_size = entry.size;
+        entry.compression = AssetCompression::None;
+
+        if (src.compress && entry.size > 0)
+        {
+            compressed.resize(ZSTD_compressBound(entry.size));
+            std::size_t const compressed_size = ZSTD_compressCCtx(
+                zstd,
+                compressed.data(),
+                compressed.size(),
+                src_file.data,
+                src_file.size,
+                options.compression_level);
+
+            // Stored as is unless compression is worth the cost of decompressing on load
+            if (!ZSTD_isError(compressed_size)
+                && compressed_size < entry.size * (1.0 - options.min_compression_savings))
+            {
+                data = compressed.data();
+                entry.stored_size = compressed_size;
+                entry.compression = AssetCompression::Zstd;
+            }
+        }
+
+        entry.offset = offset;
+        std::uint64_t const padded_size =
+            align_up(entry.stored_size, AssetPackHeader::payload_alignment);
+        ok = std::fwrite(data, 1, entry.stored_size, file) == entry.stored_size
+             && write_zeros(file, padded_size - entry.stored_size);
+        offset += padded_size;
+
+        MappedFile::release(src_file);
+    }
+
+    ZSTD_freeCCtx(zstd);
+
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0
+         && std::fwrite(&header, sizeof(header), 1, file) == 1
+         && std::fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), file)
+                == entries.size()
+         && std::fwrite(names.data(), 1, names.size(), file) == names.size();
+
+    return (std::fclose(file) == 0) && ok;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+#include "asset_pack.hpp"
+
+namespace wgpu::sandbox
+{
+
+struct AssetPackSource
+{
+    std::string name; // Name the asset is looked up by, typically its path relative to the app
+    std::string path; // File to read the asset from
+    bool compress; // Compressed if it shrinks by more than min_compression_savings
+};
+
+struct AssetPackOptions
+{
+    static constexpr int default_compression_level = 19;
+
+    int compression_level{default_compression_level}; // Favors size since packs are built offline
+    double min_compression_savings{0.1};
+};
+
+// Writes the given files to an asset pack. Returns false if a source file can't be read or the
+// pack can't be written.
+//
+// NOTE(dr): Only available to native tools since it needs zstd's compressor. Apps link the
+// decoder alone.
+bool write_asset_pack(
+    char const* path,
+    std::span<AssetPackSource const> sources,
+    AssetPackOptions const& options = {});
+
+} // namespace wgpu::sandbox
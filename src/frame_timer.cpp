@@ -0,0 +1,167 @@
+#include "frame_timer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include <fmt/core.h>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+std::int64_t to_us(FrameTimer::Clock::duration const dt)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(dt).count();
+}
+
+float to_ms(FrameTimer::Clock::duration const dt)
+{
+    return std::chrono::duration<float, std::milli>(dt).count();
+}
+
+} // namespace
+
+void FrameTimer::History::push(float const value)
+{
+    values[head] = value;
+    head = (head + 1) % history_size;
+    count = std::min(count + 1, history_size);
+}
+
+float FrameTimer::History::get_percentile(float const p) const
+{
+    if (count == 0)
+        return 0.0f;
+
+    float sorted[history_size];
+    std::copy(values, values + count, sorted);
+
+    std::uint32_t const i = std::uint32_t(p * (count - 1) + 0.5f);
+    std::nth_element(sorted, sorted + i, sorted + count);
+    return sorted[i];
+}
+
+void FrameTimer::set_trace(
+    char const* const path,
+    std::uint64_t const first_frame,
+    std::uint64_t const frame_count)
+{
+    trace.path = path;
+    trace.first_frame = first_frame;
+    trace.frame_count = frame_count;
+    trace.events.clear();
+    trace.events.reserve(frame_count * Phase_Count);
+}
+
+void FrameTimer::begin_frame()
+{
+    frame_start = phase_start = Clock::now();
+    phase = Phase_Poll;
+}
+
+void FrameTimer::mark(Phase const next)
+{
+    assert(next > phase && next < Phase_Count);
+
+    Clock::time_point const now = Clock::now();
+    end_phase(now);
+    phase = next;
+    phase_start = now;
+}
+
+void FrameTimer::end_frame()
+{
+    Clock::time_point const now = Clock::now();
+    end_phase(now);
+    total.push(to_ms(now - frame_start));
+
+    ++frame_index;
+
+    // Write the trace as soon as the last frame in range has been captured
+    if (!trace.path.empty() && frame_index == trace.first_frame + trace.frame_count)
+    {
+        bool const ok = write_trace();
+        fmt::println(
+            "{} frame trace to {}",
+            ok ? "Wrote" : "Failed to write",
+            trace.path);
+    }
+}
+
+bool FrameTimer::write_trace() const
+{
+    std::FILE* const file = std::fopen(trace.path.c_str(), "w");
+    if (!file)
+        return false;
+
+    fmt::print(file, "{{\"traceEvents\":[\n");
+
+    for (std::size_t i = 0; i < trace.events.size(); ++i)
+    {
+        TraceEvent const& event = trace.events[i];
+        fmt::print(
+            file,
+            "{{\"name\":\"{}\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":0,"
+            "\"tid\":0,\"args\":{{\"frame\":{}}}}}{}\n",
+            to_string(event.phase),
+            event.start_us,
+            event.duration_us,
+            event.frame,
+            (i + 1 < trace.events.size()) ? "," : "");
+    }
+
+    fmt::print(file, "]}}\n");
+    return std::fclose(file) == 0;
+}
+
+void FrameTimer::report() const
+{
+    fmt::println("Frame times over last {} frames (ms):", total.count);
+    fmt::println("\t{:<8} {:>8} {:>8} {:>8}", "phase", "p50", "p95", "p99");
+
+    auto const report_history = [](char const* const label, History const& history) {
+        fmt::println(
+            "\t{:<8} {:>8.3f} {:>8.3f} {:>8.3f}",
+            label,
+            history.get_percentile(0.50f),
+            history.get_percentile(0.95f),
+            history.get_percentile(0.99f));
+    };
+
+    for (std::uint8_t i = 0; i < Phase_Count; ++i)
+        report_history(to_string(Phase(i)), phases[i]);
+
+    report_history("total", total);
+}
+
+void FrameTimer::end_phase(Clock::time_point const now)
+{
+    phases[phase].push(to_ms(now - phase_start));
+
+    if (!trace.path.empty() && frame_index >= trace.first_frame
+        && frame_index < trace.first_frame + trace.frame_count)
+    {
+        trace.events.push_back({
+            .phase = phase,
+            .frame = frame_index,
+            .start_us = to_us(phase_start - origin),
+            .duration_us = to_us(now - phase_start),
+        });
+    }
+}
+
+char const* to_string(FrameTimer::Phase const value)
+{
+    static constexpr char const* names[]{
+        "poll",
+        "encode",
+        "submit",
+        "present",
+    };
+    static_assert(sizeof(names) / sizeof(*names) == FrameTimer::Phase_Count);
+    return names[value];
+}
+
+} // namespace wgpu::sandbox
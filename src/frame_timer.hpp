@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wgpu::sandbox
+{
+
+// Records CPU time spent in each phase of a frame. Keeps a rolling window of recent frames for
+// percentile stats and can capture a range of frames as a Chrome trace (chrome://tracing or
+// https://ui.perfetto.dev).
+struct FrameTimer
+{
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::uint32_t history_size = 256;
+
+    enum Phase : std::uint8_t
+    {
+        Phase_Poll = 0,
+        Phase_Encode,
+        Phase_Submit,
+        Phase_Present,
+        Phase_Count,
+    };
+
+    // Rolling window of recent durations in milliseconds
+    struct History
+    {
+        float values[history_size];
+        std::uint32_t head;
+        std::uint32_t count;
+
+        void push(float value);
+        float get_percentile(float p) const;
+    };
+
+    struct TraceEvent
+    {
+        Phase phase;
+        std::uint64_t frame;
+        std::int64_t start_us;
+        std::int64_t duration_us;
+    };
+
+    History phases[Phase_Count];
+    History total;
+    Clock::time_point origin{Clock::now()};
+    Clock::time_point frame_start;
+    Clock::time_point phase_start;
+    Phase phase;
+    std::uint64_t frame_index;
+
+    struct
+    {
+        std::string path;
+        std::uint64_t first_frame;
+        std::uint64_t frame_count;
+        std::vector<TraceEvent> events;
+    } trace;
+
+    // Captures the given range of frames and writes them to a trace file once the last one ends
+    void set_trace(char const* path, std::uint64_t first_frame, std::uint64_t frame_count);
+
+    // Starts a new frame in the poll phase
+    void begin_frame();
+
+    // Ends the current phase and starts the given one
+    void mark(Phase next);
+
+    void end_frame();
+
+    bool write_trace() const;
+
+    void report() const;
+
+  private:
+    void end_phase(Clock::time_point now);
+};
+
+char const* to_string(FrameTimer::Phase value);
+
+} // namespace wgpu::sandbox
@@ -1,2 +1,5 @@
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -0,0 +1,175 @@
+#include "mapped_file.hpp"
+
+#include <cassert>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+#ifndef _WIN32
+
+std::size_t get_page_size()
+{
+    static std::size_t const result = std::size_t(sysconf(_SC_PAGESIZE));
+    return result;
+}
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+MappedFile MappedFile::make(char const* const path)
+{
+    MappedFile result{};
+
+    HANDLE const file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return result;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return result;
+    }
+
+    HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return result;
+    }
+
+    void* const data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return result;
+    }
+
+    result.data = static_cast<std::uint8_t const*>(data);
+    result.size = std::size_t(size.QuadPart);
+    result.file_handle = file;
+    result.mapping_handle = mapping;
+    return result;
+}
+
+void MappedFile::release(MappedFile& file)
+{
+    if (file.data)
+    {
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.mapping_handle);
+        CloseHandle(file.file_handle);
+    }
+
+    file = {};
+}
+
+void MappedFile::advise_sequential() const
+{
+    // Handled by FILE_FLAG_SEQUENTIAL_SCAN when the file is opened
+}
+
+void MappedFile::discard(std::size_t const offset, std::size_t const size) const
+{
+    assert(offset + size <= this->size);
+
+    // Unlocking pages that aren't locked removes them from the working set
+    VirtualUnlock(const_cast<std::uint8_t*>(data + offset), size);
+}
+
+#else
+
+MappedFile MappedFile::make(char const* const path)
+{
+    MappedFile result{};
+    result.fd = -1;
+
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return result;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return result;
+    }
+
+    void* const data = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(fd);
+        return result;
+    }
+
+    result.data = static_cast<std::uint8_t const*>(data);
+    result.size = std::size_t(info.st_size);
+    result.fd = fd;
+    return result;
+}
+
+void MappedFile::release(MappedFile& file)
+{
+    if (file.data)
+    {
+        munmap(const_cast<std::uint8_t*>(file.data), file.size);
+        close(file.fd);
+    }
+
+    file = {};
+}
+
+void MappedFile::advise_sequential() const
+{
+    if (data)
+        madvise(const_cast<std::uint8_t*>(data), size, MADV_SEQUENTIAL);
+}
+
+void MappedFile::discard(std::size_t const offset, std::size_t const size) const
+{
+    assert(offset + size <= this->size);
+
+    // madvise requires a page aligned address so only whole pages within the range are dropped
+    std::size_t const page_size = get_page_size();
+    std::size_t const begin = (offset + page_size - 1) / page_size * page_size;
+    std::size_t const end = (offset + size) / page_size * page_size;
+
+    if (begin < end)
+        madvise(const_cast<std::uint8_t*>(data + begin), end - begin, MADV_DONTNEED);
+}
+
+#endif
+
+std::span<std::uint8_t const> MappedFile::get_range(
+    std::size_t const offset,
+    std::size_t const size) const
+{
+    assert(offset + size <= this->size);
+    return {data + offset, size};
+}
+
+} // namespace wgpu::sandbox
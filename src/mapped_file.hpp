@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace wgpu::sandbox
+{
+
+// Read-only memory mapping of an entire file. Pages are loaded by the OS on first access so files
+// larger than physical memory can be mapped as long as they're read in pieces.
+struct MappedFile
+{
+    std::uint8_t const* data;
+    std::size_t size;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#else
+    int fd;
+#endif
+
+    // Returns a file with null data if the file can't be opened or is empty
+    static MappedFile make(char const* path);
+
+    static void release(MappedFile& file);
+
+    bool is_valid() const { return data != nullptr; }
+
+    std::span<std::uint8_t const> get_range(std::size_t offset, std::size_t size) const;
+
+    // Hints that the file will be read front to back
+    void advise_sequential() const;
+
+    // Hints that the given range won't be read again so its pages can be reclaimed right away
+    void discard(std::size_t offset, std::size_t size) const;
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,239 @@
+#include "mesh_file.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "wgpu_upload.hpp"
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+// Size of pieces copied into buffers created with mapped memory
+constexpr std::uint64_t mapped_copy_size = 64ull << 20;
+
+void get_bounds(
+    MeshBuffers const& mesh,
+    std::uint32_t const position_offset,
+    float min[3],
+    float max[3])
+{
+    std::fill_n(min, 3, std::numeric_limits<float>::max());
+    std::fill_n(max, 3, std::numeric_limits<float>::lowest());
+
+    std::uint32_t const vertex_count = mesh.get_vertex_count();
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        float p[3];
+        std::memcpy(p, &mesh.vertices[i * mesh.vertex_stride + position_offset], sizeof(p));
+
+        for (int j = 0; j < 3; ++j)
+        {
+            min[j] = std::min(min[j], p[j]);
+            max[j] = std::max(max[j], p[j]);
+        }
+    }
+
+    if (vertex_count == 0)
+    {
+        std::fill_n(min, 3, 0.0f);
+        std::fill_n(max, 3, 0.0f);
+    }
+}
+
+bool write_padded(std::FILE* const file, void const* const data, std::uint64_t const size)
+{
+    static constexpr std::uint8_t zeros[MeshFileHeader::section_alignment]{};
+
+    if (std::fwrite(data, 1, size, file) != size)
+        return false;
+
+    std::uint64_t const pad = align_up(size, MeshFileHeader::section_alignment) - size;
+    return std::fwrite(zeros, 1, pad, file) == pad;
+}
+
+bool is_valid_header(MeshFileHeader const& header, std::size_t const file_size)
+{
+    auto const is_within = [&](std::uint64_t const offset, std::uint64_t const size) {
+        return offset <= file_size && size <= file_size - offset;
+    };
+
+    std::uint64_t const index_stride = (header.index_format == WGPUIndexFormat_Uint16) ? 2 : 4;
+
+    return header.magic == MeshFileHeader::magic_value
+           && header.version == MeshFileHeader::version_value
+           && is_within(header.vertex_offset, align_up(header.vertex_size, copy_alignment))
+           && is_within(header.index_offset, align_up(header.index_size, copy_alignment))
+           && std::uint64_t(header.vertex_count) * header.vertex_stride == header.vertex_size
+           && std::uint64_t(header.index_count) * index_stride == header.index_size;
+}
+
+} // namespace
+
+bool write_mesh_file(
+    char const* const path,
+    MeshBuffers const& mesh,
+    VertexAttributes const& attributes,
+    VertexQuantization const* const quantization)
+{
+    WGPUIndexFormat const index_format = select_index_format(mesh.get_vertex_count());
+    std::vector<std::uint8_t> const index_data = pack_indices(mesh.indices, index_format);
+
+    MeshFileHeader header{};
+    header.magic = MeshFileHeader::magic_value;
+    header.version = MeshFileHeader::version_value;
+    header.vertex_offset = MeshFileHeader::section_alignment;
+    header.vertex_size = mesh.vertices.size();
+    header.index_offset =
+        header.vertex_offset + align_up(header.vertex_size, MeshFileHeader::section_alignment);
+    header.index_size = index_data.size();
+    header.vertex_count = mesh.get_vertex_count();
+    header.index_count = std::uint32_t(mesh.indices.size());
+    header.vertex_stride = mesh.vertex_stride;
+    header.index_format = index_format;
+
+    if (quantization)
+    {
+        header.attributes.position = 0;
+        header.attributes.normal = quantization->normal_offset;
+        header.attributes.tex_coords = quantization->tex_coords_offset;
+        header.is_quantized = 1;
+
+        // Quantized positions span [-1, 1] in each dimension
+        for (int i = 0; i < 3; ++i)
+        {
+            header.position_scale[i] = quantization->position_scale[i];
+            header.position_offset[i] = quantization->position_offset[i];
+            header.bounds_min[i] = header.position_offset[i] - header.position_scale[i];
+            header.bounds_max[i] = header.position_offset[i] + header.position_scale[i];
+        }
+    }
+    else
+    {
+        header.attributes = attributes;
+        std::fill_n(header.position_scale, 3, 1.0f);
+        get_bounds(mesh, attributes.position, header.bounds_min, header.bounds_max);
+    }
+
+    std::FILE* const file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+
+    // Sections are padded out to the alignment which also keeps the end of the file aligned for
+    // buffer copies
+    bool const ok = write_padded(file, &header, sizeof(header))
+                    && write_padded(file, mesh.vertices.data(), mesh.vertices.size())
+                    && write_padded(file, index_data.data(), index_data.size());
+
+    return (std::fclose(file) == 0) && ok;
+}
+
+MeshFile MeshFile::make(char const* const path)
+{
+    static_assert(sizeof(MeshFileHeader) <= MeshFileHeader::section_alignment);
+
+    MeshFile result{};
+    result.file = MappedFile::make(path);
+
+    if (result.file.is_valid() && result.file.size >= sizeof(MeshFileHeader))
+    {
+        // Mapped memory is page aligned so the header can be read in place
+        auto const header = reinterpret_cast<MeshFileHeader const*>(result.file.data);
+        if (is_valid_header(*header, result.file.size))
+            result.header = header;
+    }
+
+    return result;
+}
+
+void MeshFile::release(MeshFile& mesh)
+{
+    MappedFile::release(mesh.file);
+    mesh = {};
+}
+
+void upload_file_range(
+    MappedFile const& file,
+    std::uint64_t const offset,
+    std::uint64_t const size,
+    UploadRing& uploads,
+    WGPUBuffer const dst,
+    std::uint64_t const dst_offset,
+    bool const submit)
+{
+    assert(offset + size <= file.size);
+    file.advise_sequential();
+
+    WGPUQueue const queue = wgpuDeviceGetQueue(uploads.device);
+
+    for (std::uint64_t copied = 0; copied < size;)
+    {
+        std::uint64_t const piece_size = std::min(size - copied, uploads.chunk_size);
+
+        std::span<std::uint8_t> const staged =
+            uploads.stage(dst, dst_offset + copied, piece_size);
+        std::memcpy(staged.data(), file.data + offset + copied, piece_size);
+        file.discard(offset + copied, piece_size);
+
+        if (submit)
+        {
+            WGPUCommandEncoder const encoder =
+                wgpuDeviceCreateCommandEncoder(uploads.device, nullptr);
+            uploads.finish(encoder);
+
+            WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(encoder, nullptr);
+            wgpuQueueSubmit(queue, 1, &cmds);
+            uploads.submit();
+
+            wgpuCommandBufferRelease(cmds);
+            wgpuCommandEncoderRelease(encoder);
+        }
+
+        copied += piece_size;
+    }
+}
+
+WGPUBuffer make_buffer_from_file(
+    WGPUDevice const device,
+    MappedFile const& file,
+    std::uint64_t const offset,
+    std::uint64_t const size,
+    WGPUBufferUsage const usage)
+{
+    assert(offset + size <= file.size);
+    file.advise_sequential();
+
+    WGPUBufferDescriptor const desc{
+        .usage = usage,
+        .size = align_up(size, copy_alignment),
+        .mappedAtCreation = true,
+    };
+    WGPUBuffer const result = wgpuDeviceCreateBuffer(device, &desc);
+    if (!result)
+        return nullptr;
+
+    auto const dst = static_cast<std::uint8_t*>(wgpuBufferGetMappedRange(result, 0, desc.size));
+    assert(dst);
+
+    for (std::uint64_t copied = 0; copied < size;)
+    {
+        std::uint64_t const piece_size = std::min(size - copied, mapped_copy_size);
+        std::memcpy(dst + copied, file.data + offset + copied, piece_size);
+        file.discard(offset + copied, piece_size);
+        copied += piece_size;
+    }
+
+    // Zero any padding
+    std::memset(dst + size, 0, desc.size - size);
+
+    wgpuBufferUnmap(result);
+    return result;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <webgpu/webgpu.h>
+
+#include "mapped_file.hpp"
+#include "mesh_optimizer.hpp"
+#include "vertex_quantization.hpp"
+
+namespace wgpu::sandbox
+{
+
+struct UploadRing;
+
+// Header at the start of a binary mesh file. Vertex and index sections follow, each starting on
+// a page boundary so that they can be mapped and streamed independently. All values are little
+// endian.
+struct MeshFileHeader
+{
+    static constexpr std::uint32_t magic_value = 0x4853454d; // "MESH"
+    static constexpr std::uint32_t version_value = 1;
+    static constexpr std::uint64_t section_alignment = 4096;
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t vertex_offset;
+    std::uint64_t vertex_size;
+    std::uint64_t index_offset;
+    std::uint64_t index_size;
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+    std::uint32_t vertex_stride;
+    std::uint32_t index_format; // WGPUIndexFormat
+    VertexAttributes attributes;
+
+    // Set if positions are Snorm16x4 decoded as position_offset + position_scale * value.xyz.
+    // Other attributes are quantized as described by VertexQuantization.
+    std::uint32_t is_quantized;
+    float position_scale[3];
+    float position_offset[3];
+
+    // Local space bounding box
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+// Writes a mesh to a binary mesh file. If quantization is given, the mesh is expected to hold
+// vertices produced by quantize_vertices. Returns false if the file couldn't be written.
+bool write_mesh_file(
+    char const* path,
+    MeshBuffers const& mesh,
+    VertexAttributes const& attributes,
+    VertexQuantization const* quantization = nullptr);
+
+// Memory mapped binary mesh file
+struct MeshFile
+{
+    MappedFile file;
+    MeshFileHeader const* header;
+
+    // Returns a file with a null header if the file can't be opened or isn't a valid mesh file
+    static MeshFile make(char const* path);
+
+    static void release(MeshFile& mesh);
+
+    bool is_valid() const { return header != nullptr; }
+
+    std::span<std::uint8_t const> get_vertices() const
+    {
+        return file.get_range(header->vertex_offset, header->vertex_size);
+    }
+
+    std::span<std::uint8_t const> get_indices() const
+    {
+        return file.get_range(header->index_offset, header->index_size);
+    }
+};
+
+// Copies a range of a mapped file into dst through the upload ring. The file is read straight into
+// staging memory in pieces no larger than the ring's chunk size and each piece's pages are
+// discarded once copied. If submit is true, copies are submitted piece by piece so that staging
+// memory stays bounded by the ring's capacity, which allows streaming files larger than memory.
+// Otherwise, copies are recorded with the ring's next call to finish as usual.
+void upload_file_range(
+    MappedFile const& file,
+    std::uint64_t offset,
+    std::uint64_t size,
+    UploadRing& uploads,
+    WGPUBuffer dst,
+    std::uint64_t dst_offset,
+    bool submit);
+
+// Makes a buffer holding a range of a mapped file. The file is copied directly into the buffer's
+// mapped memory without staging. Returns null if the buffer couldn't be created.
+WGPUBuffer make_buffer_from_file(
+    WGPUDevice device,
+    MappedFile const& file,
+    std::uint64_t offset,
+    std::uint64_t size,
+    WGPUBufferUsage usage);
+
+} // namespace wgpu::sandbox
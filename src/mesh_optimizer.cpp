@@ -0,0 +1,436 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr std::uint32_t no_index = ~0u;
+
+// Triangles adjacent to each vertex in CSR form
+struct Adjacency
+{
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> triangles;
+
+    static Adjacency make(
+        std::span<std::uint32_t const> const indices,
+        std::uint32_t const vertex_count)
+    {
+        Adjacency result{};
+        result.offsets.assign(vertex_count + 1, 0);
+        result.triangles.resize(indices.size());
+
+        for (std::uint32_t const v : indices)
+            ++result.offsets[v + 1];
+
+        for (std::uint32_t i = 0; i < vertex_count; ++i)
+            result.offsets[i + 1] += result.offsets[i];
+
+        std::vector<std::uint32_t> heads(result.offsets.begin(), result.offsets.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); ++i)
+            result.triangles[heads[indices[i]]++] = std::uint32_t(i / 3);
+
+        return result;
+    }
+
+    std::span<std::uint32_t const> get(std::uint32_t const vertex) const
+    {
+        return {triangles.data() + offsets[vertex], triangles.data() + offsets[vertex + 1]};
+    }
+};
+
+// FIFO cache where a vertex is resident if it was inserted fewer than cache_size misses ago
+struct VertexCache
+{
+    std::vector<std::uint32_t> timestamps;
+    std::uint32_t time;
+    std::uint32_t size;
+
+    static VertexCache make(std::uint32_t const vertex_count, std::uint32_t const cache_size)
+    {
+        VertexCache result{};
+        result.timestamps.assign(vertex_count, 0);
+        result.time = cache_size + 1;
+        result.size = cache_size;
+        return result;
+    }
+
+    bool is_resident(std::uint32_t const vertex) const
+    {
+        return time - timestamps[vertex] <= size;
+    }
+
+    // Returns true on a miss
+    bool access(std::uint32_t const vertex)
+    {
+        if (is_resident(vertex))
+            return false;
+
+        timestamps[vertex] = time++;
+        return true;
+    }
+};
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+Vec3 operator+(Vec3 const& a, Vec3 const& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 operator-(Vec3 const& a, Vec3 const& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator*(Vec3 const& a, float const t) { return {a.x * t, a.y * t, a.z * t}; }
+float dot(Vec3 const& a, Vec3 const& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vec3 cross(Vec3 const& a, Vec3 const& b)
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Vec3 get_position(MeshBuffers const& mesh, std::uint32_t const vertex, std::uint32_t const offset)
+{
+    Vec3 result;
+    std::memcpy(&result, mesh.vertices.data() + vertex * mesh.vertex_stride + offset, sizeof(Vec3));
+    return result;
+}
+
+// Returns the next vertex to fan around given the vertices of the last fan, or no_index if all
+// triangles have been emitted
+std::uint32_t get_next_vertex(
+    std::span<std::uint32_t const> const candidates,
+    std::vector<std::uint32_t>& dead_ends,
+    std::vector<std::uint32_t> const& live_counts,
+    VertexCache const& cache,
+    std::uint32_t& cursor)
+{
+    // Prefer candidates that will still be in the cache after their remaining triangles are
+    // emitted, breaking ties in favour of the oldest
+    std::uint32_t result = no_index;
+    std::int64_t best_priority = -1;
+
+    for (std::uint32_t const v : candidates)
+    {
+        if (live_counts[v] == 0)
+            continue;
+
+        std::int64_t priority = 0;
+        std::int64_t const age = cache.time - cache.timestamps[v];
+        if (age + 2 * std::int64_t(live_counts[v]) <= cache.size)
+            priority = age;
+
+        if (priority > best_priority)
+        {
+            best_priority = priority;
+            result = v;
+        }
+    }
+
+    if (result != no_index)
+        return result;
+
+    // Otherwise backtrack through recently used vertices
+    while (!dead_ends.empty())
+    {
+        std::uint32_t const v = dead_ends.back();
+        dead_ends.pop_back();
+
+        if (live_counts[v] > 0)
+            return v;
+    }
+
+    // Otherwise take the next vertex in input order
+    for (; cursor < live_counts.size(); ++cursor)
+    {
+        if (live_counts[cursor] > 0)
+            return cursor;
+    }
+
+    return no_index;
+}
+
+} // namespace
+
+VertexCacheStats get_vertex_cache_stats(
+    std::span<std::uint32_t const> const indices,
+    std::uint32_t const vertex_count,
+    std::uint32_t const cache_size)
+{
+    VertexCacheStats result{};
+    result.triangle_count = std::uint32_t(indices.size() / 3);
+
+    VertexCache cache = VertexCache::make(vertex_count, cache_size);
+    std::vector<bool> is_used(vertex_count);
+
+    for (std::uint32_t const v : indices)
+    {
+        result.miss_count += cache.access(v);
+
+        if (!is_used[v])
+        {
+            is_used[v] = true;
+            ++result.vertex_count;
+        }
+    }
+
+    return result;
+}
+
+VertexCacheStats get_vertex_cache_stats(MeshBuffers const& mesh, std::uint32_t const cache_size)
+{
+    return get_vertex_cache_stats(mesh.indices, mesh.get_vertex_count(), cache_size);
+}
+
+void dedup_vertices(MeshBuffers& mesh)
+{
+    std::uint32_t const vertex_count = mesh.get_vertex_count();
+    std::uint32_t const stride = mesh.vertex_stride;
+
+    // Vertices are keyed by their bytes
+    std::unordered_map<std::string_view, std::uint32_t> unique{};
+    unique.reserve(vertex_count);
+
+    std::vector<std::uint32_t> remap(vertex_count);
+    std::vector<std::uint8_t> vertices{};
+    vertices.reserve(mesh.vertices.size());
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::string_view const key{
+            reinterpret_cast<char const*>(mesh.vertices.data()) + i * stride,
+            stride};
+
+        auto const [it, is_new] = unique.try_emplace(key, std::uint32_t(vertices.size() / stride));
+        if (is_new)
+            vertices.insert(vertices.end(), key.begin(), key.end());
+
+        remap[i] = it->second;
+    }
+
+    for (std::uint32_t& v : mesh.indices)
+        v = remap[v];
+
+    // Keys refer to the old vertices so they have to go first
+    unique.clear();
+    mesh.vertices = std::move(vertices);
+}
+
+void optimize_vertex_cache(MeshBuffers& mesh, std::uint32_t const cache_size)
+{
+    std::uint32_t const vertex_count = mesh.get_vertex_count();
+    std::uint32_t const triangle_count = mesh.get_triangle_count();
+    if (triangle_count == 0)
+        return;
+
+    Adjacency const adjacency = Adjacency::make(mesh.indices, vertex_count);
+
+    std::vector<std::uint32_t> live_counts(vertex_count);
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+        live_counts[v] = std::uint32_t(adjacency.get(v).size());
+
+    std::vector<bool> is_emitted(triangle_count);
+    std::vector<std::uint32_t> dead_ends{};
+    std::vector<std::uint32_t> candidates{};
+    VertexCache cache = VertexCache::make(vertex_count, cache_size);
+    std::uint32_t cursor = 0;
+
+    std::vector<std::uint32_t> result{};
+    result.reserve(mesh.indices.size());
+
+    std::uint32_t fan = get_next_vertex({}, dead_ends, live_counts, cache, cursor);
+    while (fan != no_index)
+    {
+        // Emit all remaining triangles around the fanning vertex
+        candidates.clear();
+        for (std::uint32_t const t : adjacency.get(fan))
+        {
+            if (is_emitted[t])
+                continue;
+
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                std::uint32_t const v = mesh.indices[t * 3 + i];
+                result.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                --live_counts[v];
+                cache.access(v);
+            }
+
+            is_emitted[t] = true;
+        }
+
+        fan = get_next_vertex(candidates, dead_ends, live_counts, cache, cursor);
+    }
+
+    assert(result.size() == mesh.indices.size());
+    mesh.indices = std::move(result);
+}
+
+void optimize_overdraw(
+    MeshBuffers& mesh,
+    std::uint32_t const position_offset,
+    std::uint32_t const cache_size)
+{
+    std::uint32_t const triangle_count = mesh.get_triangle_count();
+    if (triangle_count == 0)
+        return;
+
+    // Split into clusters where a triangle shares no vertices with the cache. These are the
+    // points where the vertex cache order starts over so reordering clusters costs little.
+    std::vector<std::uint32_t> cluster_starts{};
+    {
+        VertexCache cache = VertexCache::make(mesh.get_vertex_count(), cache_size);
+        for (std::uint32_t t = 0; t < triangle_count; ++t)
+        {
+            std::uint32_t misses = 0;
+            for (std::uint32_t i = 0; i < 3; ++i)
+                misses += cache.access(mesh.indices[t * 3 + i]);
+
+            if (misses == 3)
+                cluster_starts.push_back(t);
+        }
+        cluster_starts.push_back(triangle_count);
+    }
+
+    struct Cluster
+    {
+        std::uint32_t begin;
+        std::uint32_t end;
+        float sort_key;
+    };
+    std::vector<Cluster> clusters(cluster_starts.size() - 1);
+
+    // Area weighted centroid and normal of each cluster
+    std::vector<Vec3> centroids(clusters.size());
+    std::vector<Vec3> normals(clusters.size());
+    Vec3 mesh_centroid{};
+    float mesh_area = 0.0f;
+
+    for (std::size_t c = 0; c < clusters.size(); ++c)
+    {
+        clusters[c].begin = cluster_starts[c];
+        clusters[c].end = cluster_starts[c + 1];
+
+        Vec3 centroid{};
+        Vec3 normal{};
+        float area = 0.0f;
+
+        for (std::uint32_t t = clusters[c].begin; t < clusters[c].end; ++t)
+        {
+            Vec3 const p0 = get_position(mesh, mesh.indices[t * 3 + 0], position_offset);
+            Vec3 const p1 = get_position(mesh, mesh.indices[t * 3 + 1], position_offset);
+            Vec3 const p2 = get_position(mesh, mesh.indices[t * 3 + 2], position_offset);
+
+            Vec3 const n = cross(p1 - p0, p2 - p0);
+            float const a = std::sqrt(dot(n, n));
+
+            centroid = centroid + (p0 + p1 + p2) * (a / 3.0f);
+            normal = normal + n;
+            area += a;
+        }
+
+        mesh_centroid = mesh_centroid + centroid;
+        mesh_area += area;
+
+        centroids[c] = (area > 0.0f) ? centroid * (1.0f / area) : centroid;
+        float const len = std::sqrt(dot(normal, normal));
+        normals[c] = (len > 0.0f) ? normal * (1.0f / len) : normal;
+    }
+
+    if (mesh_area > 0.0f)
+        mesh_centroid = mesh_centroid * (1.0f / mesh_area);
+
+    // Clusters that face away from the center are more likely to occlude others so draw them
+    // first
+    for (std::size_t c = 0; c < clusters.size(); ++c)
+        clusters[c].sort_key = dot(centroids[c] - mesh_centroid, normals[c]);
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const& a, Cluster const& b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<std::uint32_t> result{};
+    result.reserve(mesh.indices.size());
+
+    for (Cluster const& cluster : clusters)
+    {
+        result.insert(
+            result.end(),
+            mesh.indices.begin() + cluster.begin * 3,
+            mesh.indices.begin() + cluster.end * 3);
+    }
+
+    mesh.indices = std::move(result);
+}
+
+void optimize_vertex_fetch(MeshBuffers& mesh)
+{
+    std::uint32_t const stride = mesh.vertex_stride;
+
+    std::vector<std::uint32_t> remap(mesh.get_vertex_count(), no_index);
+    std::vector<std::uint8_t> vertices{};
+    vertices.reserve(mesh.vertices.size());
+
+    for (std::uint32_t& v : mesh.indices)
+    {
+        if (remap[v] == no_index)
+        {
+            remap[v] = std::uint32_t(vertices.size() / stride);
+            auto const src = mesh.vertices.begin() + v * stride;
+            vertices.insert(vertices.end(), src, src + stride);
+        }
+
+        v = remap[v];
+    }
+
+    mesh.vertices = std::move(vertices);
+}
+
+void optimize_mesh(MeshBuffers& mesh, std::uint32_t const position_offset)
+{
+    dedup_vertices(mesh);
+    optimize_vertex_cache(mesh);
+    optimize_overdraw(mesh, position_offset);
+    optimize_vertex_fetch(mesh);
+}
+
+WGPUIndexFormat select_index_format(std::uint32_t const vertex_count)
+{
+    return (vertex_count <= 0x10000) ? WGPUIndexFormat_Uint16 : WGPUIndexFormat_Uint32;
+}
+
+std::vector<std::uint8_t> pack_indices(
+    std::span<std::uint32_t const> const indices,
+    WGPUIndexFormat const format)
+{
+    std::vector<std::uint8_t> result{};
+
+    if (format == WGPUIndexFormat_Uint16)
+    {
+        result.resize(indices.size() * sizeof(std::uint16_t));
+        auto const dst = reinterpret_cast<std::uint16_t*>(result.data());
+
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            assert(indices[i] <= 0xffff);
+            dst[i] = std::uint16_t(indices[i]);
+        }
+    }
+    else
+    {
+        assert(format == WGPUIndexFormat_Uint32);
+        result.resize(indices.size() * sizeof(std::uint32_t));
+        std::memcpy(result.data(), indices.data(), result.size());
+    }
+
+    return result;
+}
+
+} // namespace wgpu::sandbox
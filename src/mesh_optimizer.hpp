@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Indexed triangle list with interleaved vertex attributes
+struct MeshBuffers
+{
+    std::vector<std::uint8_t> vertices;
+    std::vector<std::uint32_t> indices;
+    std::uint32_t vertex_stride;
+
+    std::uint32_t get_vertex_count() const
+    {
+        return std::uint32_t(vertices.size() / vertex_stride);
+    }
+
+    std::uint32_t get_triangle_count() const { return std::uint32_t(indices.size() / 3); }
+};
+
+// Post-transform vertex cache efficiency under a FIFO cache model
+struct VertexCacheStats
+{
+    std::uint32_t miss_count;
+    std::uint32_t triangle_count;
+    std::uint32_t vertex_count;
+
+    // Average cache miss ratio i.e. vertices transformed per triangle. 0.5 is ideal for large
+    // regular meshes and 3.0 is the worst case.
+    float get_acmr() const { return triangle_count ? float(miss_count) / triangle_count : 0.0f; }
+
+    // Average transform to vertex ratio i.e. number of times each vertex is transformed. 1.0 is
+    // ideal.
+    float get_atvr() const { return vertex_count ? float(miss_count) / vertex_count : 0.0f; }
+};
+
+constexpr std::uint32_t default_vertex_cache_size = 16;
+
+VertexCacheStats get_vertex_cache_stats(
+    std::span<std::uint32_t const> indices,
+    std::uint32_t vertex_count,
+    std::uint32_t cache_size = default_vertex_cache_size);
+
+VertexCacheStats get_vertex_cache_stats(
+    MeshBuffers const& mesh,
+    std::uint32_t cache_size = default_vertex_cache_size);
+
+// Merges vertices with identical attributes
+void dedup_vertices(MeshBuffers& mesh);
+
+// Reorders triangles for post-transform vertex cache reuse (Tipsify, Sander et al. 2007)
+void optimize_vertex_cache(
+    MeshBuffers& mesh,
+    std::uint32_t cache_size = default_vertex_cache_size);
+
+// Reorders clusters of triangles so that outward facing clusters tend to be drawn first while
+// keeping the vertex cache order within each cluster. Expects the result of optimize_vertex_cache.
+// Positions are read as 3 floats at the given offset within each vertex.
+void optimize_overdraw(
+    MeshBuffers& mesh,
+    std::uint32_t position_offset = 0,
+    std::uint32_t cache_size = default_vertex_cache_size);
+
+// Reorders vertices in order of first use and drops unreferenced vertices
+void optimize_vertex_fetch(MeshBuffers& mesh);
+
+// Runs all of the above in order
+void optimize_mesh(MeshBuffers& mesh, std::uint32_t position_offset = 0);
+
+// Returns the smallest index format that can address the given number of vertices
+WGPUIndexFormat select_index_format(std::uint32_t vertex_count);
+
+// Converts indices to the given format
+std::vector<std::uint8_t> pack_indices(
+    std::span<std::uint32_t const> indices,
+    WGPUIndexFormat format);
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,257 @@
+#include "range_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+struct Bin
+{
+    std::uint32_t fl;
+    std::uint32_t sl;
+};
+
+// Returns the bin whose size class contains the given number of units
+Bin get_bin(std::uint64_t const units)
+{
+    constexpr auto sl_bits = RangeAllocator::sl_bits;
+    constexpr auto sl_count = RangeAllocator::sl_count;
+
+    // Small sizes map linearly into the first level
+    if (units < sl_count)
+        return {0, std::uint32_t(units)};
+
+    std::uint32_t const log2 = std::bit_width(units) - 1;
+    return {
+        log2 - sl_bits + 1,
+        std::uint32_t(units >> (log2 - sl_bits)) - sl_count,
+    };
+}
+
+// Rounds up to the smallest size in the next bin so that any range found there is large enough
+std::uint64_t round_up_to_bin(std::uint64_t const units)
+{
+    if (units < RangeAllocator::sl_count)
+        return units;
+
+    std::uint32_t const log2 = std::bit_width(units) - 1;
+    std::uint64_t const step = std::uint64_t{1} << (log2 - RangeAllocator::sl_bits);
+    return units + step - 1;
+}
+
+} // namespace
+
+RangeAllocator RangeAllocator::make(std::uint64_t const capacity, std::uint64_t const granularity)
+{
+    assert(std::has_single_bit(granularity));
+
+    RangeAllocator result{};
+    result.granularity = granularity;
+    result.capacity = (capacity + granularity - 1) & ~(granularity - 1);
+    assert(get_bin(result.capacity / granularity).fl < fl_count);
+
+    for (auto& heads : result.free_heads)
+        std::fill(std::begin(heads), std::end(heads), no_node);
+
+    // Start with a single free range covering everything
+    std::uint32_t const node = result.make_node();
+    result.nodes[node].size = result.capacity;
+    result.insert_free(node);
+
+    return result;
+}
+
+RangeAllocator::Allocation RangeAllocator::allocate(std::uint64_t const size)
+{
+    std::uint64_t const units = std::max<std::uint64_t>((size + granularity - 1) / granularity, 1);
+    std::uint64_t const alloc_size = units * granularity;
+
+    std::uint32_t const node = find_free(units);
+    if (node == no_node)
+        return {};
+
+    remove_free(node);
+
+    // Split off any remainder as a new free range
+    if (nodes[node].size > alloc_size)
+    {
+        std::uint32_t const rest = make_node();
+        Node& curr = nodes[node];
+        Node& next = nodes[rest];
+
+        next.offset = curr.offset + alloc_size;
+        next.size = curr.size - alloc_size;
+        next.prev_range = node;
+        next.next_range = curr.next_range;
+
+        if (curr.next_range != no_node)
+            nodes[curr.next_range].prev_range = rest;
+
+        curr.next_range = rest;
+        curr.size = alloc_size;
+        insert_free(rest);
+    }
+
+    used += alloc_size;
+    ++allocation_count;
+
+    Node const& curr = nodes[node];
+    return {curr.offset, curr.size, node};
+}
+
+void RangeAllocator::free(Allocation const& alloc)
+{
+    assert(alloc.is_valid());
+    std::uint32_t node = alloc.node;
+    assert(!nodes[node].is_free);
+
+    used -= nodes[node].size;
+    --allocation_count;
+
+    // Merge with the previous range if it's free
+    if (std::uint32_t const prev = nodes[node].prev_range;
+        prev != no_node && nodes[prev].is_free)
+    {
+        remove_free(prev);
+        nodes[prev].size += nodes[node].size;
+        nodes[prev].next_range = nodes[node].next_range;
+
+        if (nodes[node].next_range != no_node)
+            nodes[nodes[node].next_range].prev_range = prev;
+
+        unused_nodes.push_back(node);
+        node = prev;
+    }
+
+    // Merge with the next range if it's free
+    if (std::uint32_t const next = nodes[node].next_range;
+        next != no_node && nodes[next].is_free)
+    {
+        remove_free(next);
+        nodes[node].size += nodes[next].size;
+        nodes[node].next_range = nodes[next].next_range;
+
+        if (nodes[next].next_range != no_node)
+            nodes[nodes[next].next_range].prev_range = node;
+
+        unused_nodes.push_back(next);
+    }
+
+    insert_free(node);
+}
+
+RangeAllocator::Stats RangeAllocator::get_stats() const
+{
+    Stats result{
+        .capacity = capacity,
+        .used = used,
+        .allocation_count = allocation_count,
+        .free_range_count = free_range_count,
+    };
+
+    // The largest free range is in the highest non-empty bin
+    if (fl_bitmap != 0)
+    {
+        std::uint32_t const fl = std::bit_width(fl_bitmap) - 1;
+        std::uint32_t const sl = std::bit_width(sl_bitmaps[fl]) - 1;
+
+        for (std::uint32_t i = free_heads[fl][sl]; i != no_node; i = nodes[i].next_free)
+            result.largest_free = std::max(result.largest_free, nodes[i].size);
+    }
+
+    return result;
+}
+
+std::uint32_t RangeAllocator::make_node()
+{
+    if (unused_nodes.empty())
+    {
+        nodes.push_back({});
+        return std::uint32_t(nodes.size() - 1);
+    }
+
+    std::uint32_t const node = unused_nodes.back();
+    unused_nodes.pop_back();
+    nodes[node] = {};
+    return node;
+}
+
+void RangeAllocator::insert_free(std::uint32_t const node)
+{
+    Node& curr = nodes[node];
+    Bin const bin = get_bin(curr.size / granularity);
+
+    std::uint32_t& head = free_heads[bin.fl][bin.sl];
+    curr.is_free = true;
+    curr.prev_free = no_node;
+    curr.next_free = head;
+
+    if (head != no_node)
+        nodes[head].prev_free = node;
+
+    head = node;
+    fl_bitmap |= 1u << bin.fl;
+    sl_bitmaps[bin.fl] |= 1u << bin.sl;
+    ++free_range_count;
+}
+
+void RangeAllocator::remove_free(std::uint32_t const node)
+{
+    Node& curr = nodes[node];
+    assert(curr.is_free);
+
+    if (curr.prev_free != no_node)
+    {
+        nodes[curr.prev_free].next_free = curr.next_free;
+    }
+    else
+    {
+        Bin const bin = get_bin(curr.size / granularity);
+        free_heads[bin.fl][bin.sl] = curr.next_free;
+
+        // Clear bitmap bits if the list is now empty
+        if (curr.next_free == no_node)
+        {
+            sl_bitmaps[bin.fl] &= ~(1u << bin.sl);
+            if (sl_bitmaps[bin.fl] == 0)
+                fl_bitmap &= ~(1u << bin.fl);
+        }
+    }
+
+    if (curr.next_free != no_node)
+        nodes[curr.next_free].prev_free = curr.prev_free;
+
+    curr.is_free = false;
+    curr.prev_free = no_node;
+    curr.next_free = no_node;
+    --free_range_count;
+}
+
+std::uint32_t RangeAllocator::find_free(std::uint64_t const units) const
+{
+    Bin bin = get_bin(round_up_to_bin(units));
+    if (bin.fl >= fl_count)
+        return no_node;
+
+    // Look for a non-empty list in the same first level bin, then in any larger one
+    std::uint32_t sl_map = sl_bitmaps[bin.fl] & (~0u << bin.sl);
+    if (sl_map == 0)
+    {
+        std::uint32_t const fl_map = (bin.fl + 1 < fl_count) ? fl_bitmap & (~0u << (bin.fl + 1))
+                                                              : 0;
+        if (fl_map == 0)
+            return no_node;
+
+        bin.fl = std::countr_zero(fl_map);
+        sl_map = sl_bitmaps[bin.fl];
+    }
+
+    bin.sl = std::countr_zero(sl_map);
+    return free_heads[bin.fl][bin.sl];
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace wgpu::sandbox
+{
+
+// Two-level segregated fit (TLSF) allocator for ranges within a fixed capacity. Only manages
+// offsets so that it can be used to sub-allocate GPU resources. Allocation and free are O(1) and
+// adjacent free ranges are merged on free.
+struct RangeAllocator
+{
+    static constexpr std::uint32_t sl_bits = 3;
+    static constexpr std::uint32_t sl_count = 1 << sl_bits;
+    static constexpr std::uint32_t fl_count = 32;
+    static constexpr std::uint32_t no_node = ~0u;
+
+    struct Allocation
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t node{no_node};
+        bool is_valid() const { return node != no_node; }
+    };
+
+    struct Stats
+    {
+        std::uint64_t capacity;
+        std::uint64_t used;
+        std::uint64_t largest_free;
+        std::uint32_t allocation_count;
+        std::uint32_t free_range_count;
+
+        // Fraction of free space that isn't part of the largest free range
+        float get_fragmentation() const
+        {
+            std::uint64_t const free = capacity - used;
+            return (free > 0) ? 1.0f - float(largest_free) / float(free) : 0.0f;
+        }
+    };
+
+    struct Node
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t prev_range{no_node};
+        std::uint32_t next_range{no_node};
+        std::uint32_t prev_free{no_node};
+        std::uint32_t next_free{no_node};
+        bool is_free;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> unused_nodes;
+    std::uint32_t free_heads[fl_count][sl_count];
+    std::uint32_t fl_bitmap;
+    std::uint32_t sl_bitmaps[fl_count];
+    std::uint64_t capacity;
+    std::uint64_t granularity;
+    std::uint64_t used;
+    std::uint32_t allocation_count;
+    std::uint32_t free_range_count;
+
+    // Capacity and all allocation sizes are rounded up to a multiple of granularity, which must
+    // be a power of two
+    static RangeAllocator make(std::uint64_t capacity, std::uint64_t granularity = 1);
+
+    // Returns an invalid allocation if there's no free range large enough
+    Allocation allocate(std::uint64_t size);
+
+    void free(Allocation const& alloc);
+
+    Stats get_stats() const;
+
+  private:
+    std::uint32_t make_node();
+    void insert_free(std::uint32_t node);
+    void remove_free(std::uint32_t node);
+    std::uint32_t find_free(std::uint64_t units) const;
+};
+
+} // namespace wgpu::sandbox
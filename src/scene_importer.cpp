@@ -0,0 +1,761 @@
+#include "scene_importer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <fmt/core.h>
+
+#include <cgltf.h>
+#include <stb_image.h>
+
+#include "mapped_file.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double get_ms_since(Clock::time_point const start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+constexpr float identity[16]{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+VertexAttributes get_attributes(bool const with_normals)
+{
+    return {
+        .position = 0,
+        .normal = with_normals ? std::uint32_t(sizeof(float[3])) : VertexAttributes::none,
+        .tex_coords = std::uint32_t(with_normals ? sizeof(float[6]) : sizeof(float[3])),
+    };
+}
+
+std::uint32_t get_vertex_stride(bool const with_normals)
+{
+    return std::uint32_t(with_normals ? sizeof(float[8]) : sizeof(float[5]));
+}
+
+void set_image(
+    stbi_uc* const data,
+    int const width,
+    int const height,
+    ImportedScene::Image& result)
+{
+    if (!data)
+        return;
+
+    result.data.assign(data, data + std::size_t(width) * height * 4);
+    result.width = std::uint32_t(width);
+    result.height = std::uint32_t(height);
+    stbi_image_free(data);
+}
+
+void decode_image(
+    std::uint8_t const* const src,
+    std::size_t const size,
+    ImportedScene::Image& result)
+{
+    int width, height, channels;
+    stbi_uc* const data = stbi_load_from_memory(src, int(size), &width, &height, &channels, 4);
+    set_image(data, width, height, result);
+}
+
+void load_image(char const* const path, ImportedScene::Image& result)
+{
+    int width, height, channels;
+    stbi_uc* const data = stbi_load(path, &width, &height, &channels, 4);
+    set_image(data, width, height, result);
+}
+
+void optimize_meshes(TaskPool& pool, ImportedScene& scene)
+{
+    pool.run(scene.meshes.size(), [&](std::size_t const index) {
+        optimize_mesh(scene.meshes[index].buffers, scene.attributes.position);
+    });
+}
+
+//
+// glTF
+//
+
+cgltf_accessor const* find_attribute(
+    cgltf_primitive const& prim,
+    cgltf_attribute_type const type,
+    cgltf_size const components)
+{
+    for (cgltf_size i = 0; i < prim.attributes_count; ++i)
+    {
+        cgltf_attribute const& attr = prim.attributes[i];
+        if (attr.type == type && attr.index == 0)
+            return (cgltf_num_components(attr.data->type) == components) ? attr.data : nullptr;
+    }
+
+    return nullptr;
+}
+
+// Unpacks an accessor into its slot of interleaved vertices
+void interleave(
+    cgltf_accessor const* const src,
+    cgltf_size const components,
+    std::uint32_t const offset,
+    std::vector<float>& scratch,
+    MeshBuffers& result)
+{
+    cgltf_size const vertex_count = result.get_vertex_count();
+    if (!src || offset == VertexAttributes::none || src->count != vertex_count)
+        return;
+
+    scratch.resize(vertex_count * components);
+    cgltf_accessor_unpack_floats(src, scratch.data(), scratch.size());
+
+    for (cgltf_size i = 0; i < vertex_count; ++i)
+    {
+        std::memcpy(
+            &result.vertices[i * result.vertex_stride + offset],
+            &scratch[i * components],
+            components * sizeof(float));
+    }
+}
+
+// Returns false if the primitive refers to vertices that don't exist
+bool decode_primitive(
+    cgltf_primitive const& prim,
+    VertexAttributes const& attributes,
+    MeshBuffers& result)
+{
+    cgltf_accessor const* const positions =
+        find_attribute(prim, cgltf_attribute_type_position, 3);
+    if (!positions)
+        return true;
+
+    cgltf_size const vertex_count = positions->count;
+    result.vertices.resize(vertex_count * result.vertex_stride);
+
+    // Missing attributes are left as zero
+    std::vector<float> scratch{};
+    interleave(positions, 3, attributes.position, scratch, result);
+    interleave(
+        find_attribute(prim, cgltf_attribute_type_normal, 3),
+        3,
+        attributes.normal,
+        scratch,
+        result);
+    interleave(
+        find_attribute(prim, cgltf_attribute_type_texcoord, 2),
+        2,
+        attributes.tex_coords,
+        scratch,
+        result);
+
+    if (prim.indices)
+    {
+        result.indices.resize(prim.indices->count);
+        for (cgltf_size i = 0; i < prim.indices->count; ++i)
+        {
+            cgltf_size const index = cgltf_accessor_read_index(prim.indices, i);
+            if (index >= vertex_count)
+            {
+                result = {};
+                return false;
+            }
+
+            result.indices[i] = std::uint32_t(index);
+        }
+    }
+    else
+    {
+        result.indices.resize(vertex_count);
+        for (cgltf_size i = 0; i < vertex_count; ++i)
+            result.indices[i] = std::uint32_t(i);
+    }
+
+    // Drop any trailing partial triangle
+    result.indices.resize(result.indices.size() / 3 * 3);
+    return true;
+}
+
+void decode_gltf_image(
+    cgltf_options const& options,
+    cgltf_image const& image,
+    std::string_view const base_dir,
+    ImportedScene::Image& result)
+{
+    // Embedded in a buffer (e.g. in .glb files)
+    if (image.buffer_view)
+    {
+        decode_image(cgltf_buffer_view_data(image.buffer_view), image.buffer_view->size, result);
+        return;
+    }
+
+    if (!image.uri)
+        return;
+
+    std::string_view const uri{image.uri};
+
+    // Embedded as a base64 data URI
+    if (uri.starts_with("data:"))
+    {
+        std::size_t const start = uri.find("base64,");
+        if (start == std::string_view::npos)
+            return;
+
+        std::string_view base64 = uri.substr(start + 7);
+        while (base64.ends_with('='))
+            base64.remove_suffix(1);
+
+        std::size_t const size = base64.size() * 3 / 4;
+        void* data = nullptr;
+        cgltf_result const res = cgltf_load_buffer_base64(&options, size, base64.data(), &data);
+        if (res == cgltf_result_success)
+        {
+            decode_image(static_cast<std::uint8_t const*>(data), size, result);
+            std::free(data);
+        }
+
+        return;
+    }
+
+    // External file relative to the glTF file
+    std::string path{base_dir};
+    path += uri;
+    path.resize(cgltf_decode_uri(path.data() + base_dir.size()) + base_dir.size());
+    load_image(path.c_str(), result);
+}
+
+//
+// OBJ
+//
+
+// Face corner indices into the file's positions, tex coords, and normals. -1 if absent.
+struct ObjCorner
+{
+    std::int64_t index[3];
+};
+
+// Line-aligned range of an OBJ file and everything parsed from it
+struct ObjBlock
+{
+    std::string_view text;
+    std::vector<float> values[3]; // Positions, tex coords, normals
+    std::vector<ObjCorner> corners; // Three per triangle
+
+    // Negative indices count back from the last element read so far in the file. These are stored
+    // relative to the start of the block and fixed up once preceding blocks have been counted.
+    std::vector<std::uint8_t> is_relative; // Bit per corner index
+    std::size_t base[3];
+};
+
+constexpr std::size_t obj_components[3]{3, 2, 3};
+
+// Splits off the next whitespace delimited token
+std::string_view next_token(std::string_view& line)
+{
+    std::size_t const begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos)
+    {
+        line = {};
+        return {};
+    }
+
+    std::size_t const end = std::min(line.find_first_of(" \t\r", begin), line.size());
+    std::string_view const result = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return result;
+}
+
+// Tokens are views into the mapped file so they're copied to add a null terminator
+struct TokenString
+{
+    char data[64];
+
+    TokenString(std::string_view const token)
+    {
+        std::size_t const n = std::min(token.size(), sizeof(data) - 1);
+        std::copy_n(token.data(), n, data);
+        data[n] = '\0';
+    }
+};
+
+void parse_corner(std::string_view const token, ObjBlock& block)
+{
+    // Corners are given as v, v/vt, v//vn, or v/vt/vn
+    ObjCorner corner{{-1, -1, -1}};
+    std::uint8_t is_relative = 0;
+
+    std::string_view rest = token;
+    for (int i = 0; i < 3 && !rest.empty(); ++i)
+    {
+        std::size_t const slash = rest.find('/');
+        std::string_view const part = rest.substr(0, slash);
+        rest = (slash == std::string_view::npos) ? std::string_view{} : rest.substr(slash + 1);
+
+        if (part.empty())
+            continue;
+
+        std::int64_t const value = std::strtoll(TokenString{part}.data, nullptr, 10);
+        if (value < 0)
+        {
+            corner.index[i] = std::int64_t(block.values[i].size() / obj_components[i]) + value;
+            is_relative |= std::uint8_t(1 << i);
+        }
+        else
+        {
+            corner.index[i] = value - 1;
+        }
+    }
+
+    block.corners.push_back(corner);
+    block.is_relative.push_back(is_relative);
+}
+
+void parse_block(ObjBlock& block)
+{
+    std::string_view text = block.text;
+    while (!text.empty())
+    {
+        std::size_t const end = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(std::min(end + 1, text.size()));
+
+        std::string_view const tag = next_token(line);
+        int const type = (tag == "v") ? 0 : (tag == "vt") ? 1 : (tag == "vn") ? 2 : -1;
+
+        if (type >= 0)
+        {
+            for (std::size_t i = 0; i < obj_components[type]; ++i)
+            {
+                std::string_view const token = next_token(line);
+                block.values[type].push_back(std::strtof(TokenString{token}.data, nullptr));
+            }
+        }
+        else if (tag == "f")
+        {
+            // Polygons are triangulated as fans
+            std::string_view const first = next_token(line);
+            std::string_view prev = next_token(line);
+            for (std::string_view curr = next_token(line); !curr.empty(); curr = next_token(line))
+            {
+                parse_corner(first, block);
+                parse_corner(prev, block);
+                parse_corner(curr, block);
+                prev = curr;
+            }
+        }
+    }
+}
+
+struct ObjCornerHash
+{
+    std::size_t operator()(ObjCorner const& corner) const
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::int64_t const i : corner.index)
+            h = (h ^ std::uint64_t(i)) * 1099511628211ull;
+
+        return std::size_t(h);
+    }
+};
+
+struct ObjCornerEqual
+{
+    bool operator()(ObjCorner const& a, ObjCorner const& b) const
+    {
+        return std::equal(a.index, a.index + 3, b.index);
+    }
+};
+
+} // namespace
+
+void ImportedScene::report() const
+{
+    std::size_t vertex_count = 0;
+    std::size_t triangle_count = 0;
+    for (Mesh const& mesh : meshes)
+    {
+        vertex_count += mesh.buffers.get_vertex_count();
+        triangle_count += mesh.buffers.get_triangle_count();
+    }
+
+    fmt::println("Scene import:");
+    fmt::println(
+        "\t{} meshes, {} instances, {} images",
+        meshes.size(),
+        instances.size(),
+        images.size());
+    fmt::println("\t{} vertices, {} triangles", vertex_count, triangle_count);
+    fmt::println("\tread: {:.2f} ms", timings.read_ms);
+    fmt::println("\tmeshes: {:.2f} ms", timings.mesh_ms);
+    fmt::println("\timages: {:.2f} ms", timings.image_ms);
+    fmt::println("\toptimize: {:.2f} ms", timings.optimize_ms);
+    fmt::println("\ttotal: {:.2f} ms", timings.total_ms);
+}
+
+bool import_gltf(
+    char const* const path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result)
+{
+    Clock::time_point const start = Clock::now();
+    result = {};
+    result.attributes = get_attributes(options.with_normals);
+
+    // Parse the file and load its buffers
+    cgltf_options const gltf_options{};
+    cgltf_data* data = nullptr;
+    {
+        Clock::time_point const t0 = Clock::now();
+
+        if (cgltf_parse_file(&gltf_options, path, &data) != cgltf_result_success)
+            return false;
+
+        // Validation checks that accessors and views stay within their buffers which decoding
+        // relies on
+        if (cgltf_load_buffers(&gltf_options, data, path) != cgltf_result_success
+            || cgltf_validate(data) != cgltf_result_success)
+        {
+            fmt::println("Invalid glTF file: {}", path);
+            cgltf_free(data);
+            return false;
+        }
+
+        result.timings.read_ms = get_ms_since(t0);
+    }
+
+    // Flatten triangle primitives of all meshes
+    std::vector<cgltf_primitive const*> prims{};
+    std::vector<std::size_t> mesh_prims(data->meshes_count + 1);
+    for (cgltf_size i = 0; i < data->meshes_count; ++i)
+    {
+        mesh_prims[i] = prims.size();
+
+        cgltf_mesh const& mesh = data->meshes[i];
+        for (cgltf_size j = 0; j < mesh.primitives_count; ++j)
+        {
+            if (mesh.primitives[j].type == cgltf_primitive_type_triangles)
+                prims.push_back(&mesh.primitives[j]);
+        }
+    }
+    mesh_prims.back() = prims.size();
+
+    // Decode primitives
+    {
+        Clock::time_point const t0 = Clock::now();
+        result.meshes.resize(prims.size());
+        std::atomic<bool> is_valid{true};
+
+        pool.run(prims.size(), [&](std::size_t const index) {
+            cgltf_primitive const& prim = *prims[index];
+            ImportedScene::Mesh& mesh = result.meshes[index];
+            mesh.buffers.vertex_stride = get_vertex_stride(options.with_normals);
+            if (!decode_primitive(prim, result.attributes, mesh.buffers))
+                is_valid = false;
+
+            mesh.image = ImportedScene::none;
+            cgltf_material const* const mat = prim.material;
+            if (mat && mat->has_pbr_metallic_roughness)
+            {
+                cgltf_texture const* const tex =
+                    mat->pbr_metallic_roughness.base_color_texture.texture;
+                if (tex && tex->image)
+                    mesh.image = std::uint32_t(tex->image - data->images);
+            }
+        });
+
+        result.timings.mesh_ms = get_ms_since(t0);
+
+        if (!is_valid)
+        {
+            fmt::println("Invalid glTF file: {} (index out of range)", path);
+            cgltf_free(data);
+            result = {};
+            return false;
+        }
+    }
+
+    // Decode images
+    if (options.load_images)
+    {
+        Clock::time_point const t0 = Clock::now();
+        result.images.resize(data->images_count);
+
+        std::string_view const path_view{path};
+        std::size_t const sep = path_view.find_last_of("/\\");
+        std::string_view const base_dir =
+            (sep == std::string_view::npos) ? std::string_view{} : path_view.substr(0, sep + 1);
+
+        pool.run(data->images_count, [&](std::size_t const index) {
+            decode_gltf_image(gltf_options, data->images[index], base_dir, result.images[index]);
+        });
+
+        result.timings.image_ms = get_ms_since(t0);
+    }
+
+    // Add an instance of each primitive per node that refers to its mesh
+    for (cgltf_size i = 0; i < data->nodes_count; ++i)
+    {
+        cgltf_node const& node = data->nodes[i];
+        if (!node.mesh)
+            continue;
+
+        ImportedScene::Instance inst{};
+        cgltf_node_transform_world(&node, inst.local_to_world);
+
+        std::size_t const mesh_index = std::size_t(node.mesh - data->meshes);
+        for (std::size_t j = mesh_prims[mesh_index]; j < mesh_prims[mesh_index + 1]; ++j)
+        {
+            inst.mesh = std::uint32_t(j);
+            result.instances.push_back(inst);
+        }
+    }
+
+    // Files without nodes get one instance per primitive
+    if (data->nodes_count == 0)
+    {
+        for (std::size_t i = 0; i < prims.size(); ++i)
+        {
+            ImportedScene::Instance& inst = result.instances.emplace_back();
+            inst.mesh = std::uint32_t(i);
+            std::copy_n(identity, 16, inst.local_to_world);
+        }
+    }
+
+    cgltf_free(data);
+
+    if (options.optimize)
+    {
+        Clock::time_point const t0 = Clock::now();
+        optimize_meshes(pool, result);
+        result.timings.optimize_ms = get_ms_since(t0);
+    }
+
+    result.timings.total_ms = get_ms_since(start);
+    return true;
+}
+
+bool import_obj(
+    char const* const path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result)
+{
+    Clock::time_point const start = Clock::now();
+    result = {};
+    result.attributes = get_attributes(options.with_normals);
+
+    MappedFile file = MappedFile::make(path);
+    if (!file.is_valid())
+        return false;
+
+    // Parse line-aligned blocks in parallel
+    std::vector<ObjBlock> blocks{};
+    {
+        Clock::time_point const t0 = Clock::now();
+        file.advise_sequential();
+
+        std::string_view const text{reinterpret_cast<char const*>(file.data), file.size};
+        std::size_t const block_count = pool.get_thread_count() * 4;
+        blocks.resize(block_count);
+
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < block_count; ++i)
+        {
+            std::size_t end = text.size() * (i + 1) / block_count;
+            end = std::min(text.find('\n', std::max(end, begin)), text.size());
+            if (end < text.size())
+                ++end;
+
+            blocks[i].text = text.substr(begin, end - begin);
+            begin = end;
+        }
+
+        pool.run(block_count, [&](std::size_t const index) { parse_block(blocks[index]); });
+        result.timings.read_ms = get_ms_since(t0);
+    }
+
+    // Resolve relative indices and build vertices from unique corners
+    {
+        Clock::time_point const t0 = Clock::now();
+
+        std::vector<float> values[3]{};
+        for (ObjBlock& block : blocks)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                block.base[i] = values[i].size() / obj_components[i];
+                values[i].insert(values[i].end(), block.values[i].begin(), block.values[i].end());
+                block.values[i] = {};
+            }
+        }
+
+        pool.run(blocks.size(), [&](std::size_t const index) {
+            ObjBlock& block = blocks[index];
+            for (std::size_t i = 0; i < block.corners.size(); ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (block.is_relative[i] & (1 << j))
+                        block.corners[i].index[j] += std::int64_t(block.base[j]);
+                }
+            }
+        });
+
+        MeshBuffers& mesh = result.meshes.emplace_back().buffers;
+        result.meshes.back().image = ImportedScene::none;
+        mesh.vertex_stride = get_vertex_stride(options.with_normals);
+
+        std::uint32_t const offsets[3]{
+            result.attributes.position,
+            result.attributes.tex_coords,
+            result.attributes.normal,
+        };
+
+        std::unordered_map<ObjCorner, std::uint32_t, ObjCornerHash, ObjCornerEqual>
+            corner_to_vertex{};
+        for (ObjBlock const& block : blocks)
+        {
+            for (ObjCorner const& corner : block.corners)
+            {
+                auto const [it, inserted] =
+                    corner_to_vertex.try_emplace(corner, mesh.get_vertex_count());
+                mesh.indices.push_back(it->second);
+
+                if (!inserted)
+                    continue;
+
+                std::size_t const dst = mesh.vertices.size();
+                mesh.vertices.resize(dst + mesh.vertex_stride);
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    std::int64_t const index = corner.index[i];
+                    std::size_t const n = obj_components[i];
+                    if (offsets[i] == VertexAttributes::none || index < 0
+                        || std::size_t(index + 1) * n > values[i].size())
+                    {
+                        continue;
+                    }
+
+                    std::memcpy(
+                        &mesh.vertices[dst + offsets[i]],
+                        &values[i][index * n],
+                        n * sizeof(float));
+                }
+
+                // OBJ tex coords have their origin at the bottom left
+                if (offsets[1] != VertexAttributes::none && corner.index[1] >= 0)
+                {
+                    std::uint8_t* const v = &mesh.vertices[dst + offsets[1] + sizeof(float)];
+                    float value;
+                    std::memcpy(&value, v, sizeof(float));
+                    value = 1.0f - value;
+                    std::memcpy(v, &value, sizeof(float));
+                }
+            }
+        }
+
+        ImportedScene::Instance& inst = result.instances.emplace_back();
+        inst.mesh = 0;
+        std::copy_n(identity, 16, inst.local_to_world);
+
+        result.timings.mesh_ms = get_ms_since(t0);
+    }
+
+    MappedFile::release(file);
+
+    if (options.optimize)
+    {
+        Clock::time_point const t0 = Clock::now();
+        optimize_meshes(pool, result);
+        result.timings.optimize_ms = get_ms_since(t0);
+    }
+
+    result.timings.total_ms = get_ms_since(start);
+    return true;
+}
+
+bool import_scene(
+    char const* const path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result)
+{
+    std::string_view const path_view{path};
+    std::string ext{path_view.substr(path_view.find_last_of('.') + 1)};
+    for (char& c : ext)
+        c = char(std::tolower(static_cast<unsigned char>(c)));
+
+    if (ext == "gltf" || ext == "glb")
+        return import_gltf(path, pool, options, result);
+
+    if (ext == "obj")
+        return import_obj(path, pool, options, result);
+
+    return false;
+}
+
+MeshBuffers bake_instances(ImportedScene const& scene)
+{
+    VertexAttributes const& attrs = scene.attributes;
+
+    MeshBuffers result{};
+    result.vertex_stride = get_vertex_stride(attrs.normal != VertexAttributes::none);
+
+    for (ImportedScene::Instance const& inst : scene.instances)
+    {
+        MeshBuffers const& mesh = scene.meshes[inst.mesh].buffers;
+
+        std::uint32_t const base = result.get_vertex_count();
+        for (std::uint32_t const index : mesh.indices)
+            result.indices.push_back(base + index);
+
+        std::size_t const begin = result.vertices.size();
+        result.vertices.insert(result.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+
+        float const* const m = inst.local_to_world;
+        for (std::size_t v = begin; v < result.vertices.size(); v += mesh.vertex_stride)
+        {
+            // Points get the full transform. Normals use the upper 3x3 which is only correct for
+            // rotation and uniform scale.
+            auto const transform = [&](std::uint32_t const offset, float const w) {
+                float p[3];
+                std::memcpy(p, &result.vertices[v + offset], sizeof(p));
+
+                float q[3];
+                for (int i = 0; i < 3; ++i)
+                    q[i] = m[i] * p[0] + m[i + 4] * p[1] + m[i + 8] * p[2] + m[i + 12] * w;
+
+                if (w == 0.0f)
+                {
+                    float const len = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+                    if (len > 0.0f)
+                    {
+                        for (float& x : q)
+                            x /= len;
+                    }
+                }
+
+                std::memcpy(&result.vertices[v + offset], q, sizeof(q));
+            };
+            transform(attrs.position, 1.0f);
+
+            if (attrs.normal != VertexAttributes::none)
+                transform(attrs.normal, 0.0f);
+        }
+    }
+
+    return result;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh_optimizer.hpp"
+#include "task_pool.hpp"
+#include "vertex_quantization.hpp"
+
+namespace wgpu::sandbox
+{
+
+struct ImportOptions
+{
+    bool with_normals{true};
+    bool optimize{true};
+    bool load_images{true};
+};
+
+// Wall time spent in each stage of an import
+struct ImportTimings
+{
+    double read_ms; // Reading and parsing the file
+    double mesh_ms; // Decoding vertex and index data
+    double image_ms; // Decoding images
+    double optimize_ms;
+    double total_ms;
+};
+
+// Scene data laid out for direct upload. Every mesh shares the same interleaved vertex layout
+// (float position, normal if requested, and tex coords) with u32 indices. Images are RGBA8 with
+// tightly packed rows.
+struct ImportedScene
+{
+    static constexpr std::uint32_t none = ~0u;
+
+    struct Mesh
+    {
+        MeshBuffers buffers;
+        std::uint32_t image; // Base color image or none
+    };
+
+    struct Instance
+    {
+        std::uint32_t mesh;
+        float local_to_world[16];
+    };
+
+    struct Image
+    {
+        std::vector<std::uint8_t> data;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    std::vector<Mesh> meshes;
+    std::vector<Instance> instances;
+    std::vector<Image> images;
+    VertexAttributes attributes;
+    ImportTimings timings;
+
+    void report() const;
+};
+
+// Imports triangle primitives from a glTF 2.0 file (.gltf or .glb). Each primitive becomes a mesh
+// and each node that refers to a mesh adds an instance of its primitives. Accessors and images are
+// decoded in parallel on the given pool. Returns false if the file can't be loaded or fails
+// validation, including any indices that are out of range.
+bool import_gltf(
+    char const* path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result);
+
+// Imports a Wavefront OBJ file as a single mesh with one instance. Polygons are triangulated as
+// fans, and groups and materials are ignored. The file is parsed in parallel in line-aligned
+// blocks. Returns false if the file can't be loaded.
+bool import_obj(
+    char const* path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result);
+
+// Calls the importer that matches the file extension
+bool import_scene(
+    char const* path,
+    TaskPool& pool,
+    ImportOptions const& options,
+    ImportedScene& result);
+
+// Merges all instances into a single mesh in world space
+MeshBuffers bake_instances(ImportedScene const& scene);
+
+} // namespace wgpu::sandbox
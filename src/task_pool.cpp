@@ -0,0 +1,155 @@
+#include "task_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+void run_tasks(TaskPool::Loop& loop)
+{
+    for (std::size_t i = loop.next++; i < loop.count; i = loop.next++)
+        loop.task(i, loop.userdata);
+}
+
+// Returns a loop that still has unclaimed iterations. Must be called with the mutex held.
+TaskPool::Loop* find_loop(TaskPool::Shared const& shared)
+{
+    for (TaskPool::Loop* const loop : shared.loops)
+    {
+        if (loop->next < loop->count)
+            return loop;
+    }
+
+    return nullptr;
+}
+
+void run_worker(TaskPool::Shared& shared)
+{
+    std::unique_lock lock{shared.mutex};
+
+    while (true)
+    {
+        shared.wake.wait(lock, [&]() {
+            return shared.is_stopping || !shared.jobs.empty() || find_loop(shared);
+        });
+
+        // Loops are helped with first since their callers are blocked on them
+        if (TaskPool::Loop* const loop = find_loop(shared))
+        {
+            ++loop->helper_count;
+            lock.unlock();
+
+            run_tasks(*loop);
+
+            lock.lock();
+            if (--loop->helper_count == 0)
+                shared.done.notify_all();
+        }
+        else if (!shared.jobs.empty())
+        {
+            TaskPool::Job job = std::move(shared.jobs.front());
+            shared.jobs.pop_front();
+            lock.unlock();
+
+            job();
+
+            lock.lock();
+        }
+        else
+        {
+            // Queued jobs are still run when stopping so that none are dropped
+            assert(shared.is_stopping);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+TaskPool TaskPool::make(std::size_t thread_count)
+{
+    assert(thread_count > 0);
+
+#ifdef __EMSCRIPTEN__
+    // NOTE(dr): Web builds don't enable pthreads so everything runs on the calling thread
+    thread_count = 1;
+#endif
+
+    TaskPool result{};
+    result.shared = std::make_unique<Shared>();
+
+    result.workers.reserve(thread_count - 1);
+    for (std::size_t i = 1; i < thread_count; ++i)
+        result.workers.emplace_back(run_worker, std::ref(*result.shared));
+
+    return result;
+}
+
+void TaskPool::release(TaskPool& pool)
+{
+    if (pool.shared)
+    {
+        {
+            std::scoped_lock lock{pool.shared->mutex};
+            pool.shared->is_stopping = true;
+        }
+        pool.shared->wake.notify_all();
+
+        for (std::thread& worker : pool.workers)
+            worker.join();
+    }
+
+    pool = {};
+}
+
+void TaskPool::run(std::size_t const count, Task* const task, void* const userdata)
+{
+    if (count == 0)
+        return;
+
+    // Skip synchronization if there's nothing to share
+    if (workers.empty() || count == 1)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            task(i, userdata);
+
+        return;
+    }
+
+    Loop loop{};
+    loop.task = task;
+    loop.userdata = userdata;
+    loop.count = count;
+    {
+        std::scoped_lock lock{shared->mutex};
+        shared->loops.push_back(&loop);
+    }
+    shared->wake.notify_all();
+
+    run_tasks(loop);
+
+    // Once every iteration has been claimed, the loop is done when its helpers are
+    std::unique_lock lock{shared->mutex};
+    shared->done.wait(lock, [&]() { return loop.helper_count == 0; });
+    shared->loops.erase(std::find(shared->loops.begin(), shared->loops.end(), &loop));
+}
+
+void TaskPool::enqueue(Job job)
+{
+    if (workers.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::scoped_lock lock{shared->mutex};
+        shared->jobs.push_back(std::move(job));
+    }
+    shared->wake.notify_one();
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace wgpu::sandbox
+{
+
+// Fixed set of worker threads that run the iterations of a parallel loop together with the
+// calling thread. Workers also run queued background jobs when they're not helping with a loop.
+// Loops can be run from any thread including from within jobs.
+struct TaskPool
+{
+    using Task = void(std::size_t index, void* userdata);
+    using Job = std::function<void()>;
+
+    // Loop in progress. Lives on the stack of the thread that called run.
+    struct Loop
+    {
+        Task* task;
+        void* userdata;
+        std::size_t count;
+        std::atomic<std::size_t> next;
+        std::size_t helper_count; // Workers currently running iterations
+    };
+
+    // State shared with workers. Heap allocated so that the pool itself stays movable.
+    struct Shared
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::vector<Loop*> loops;
+        std::deque<Job> jobs;
+        bool is_stopping;
+    };
+
+    std::unique_ptr<Shared> shared;
+    std::vector<std::thread> workers;
+
+    // Makes a pool that runs loops on the given number of threads including the caller's
+    static TaskPool make(std::size_t thread_count);
+
+    // Finishes any queued jobs then joins workers
+    static void release(TaskPool& pool);
+
+    // Calls task for each index in [0, count) and blocks until all calls have returned
+    void run(std::size_t count, Task* task, void* userdata);
+
+    template <typename Func>
+    void run(std::size_t const count, Func&& func)
+    {
+        static_assert(std::is_invocable_v<Func, std::size_t>);
+        run(
+            count,
+            [](std::size_t const index, void* const userdata) {
+                (*static_cast<std::remove_reference_t<Func>*>(userdata))(index);
+            },
+            &func);
+    }
+
+    // Queues a job to run on a worker. Without workers, the job runs on the calling thread before
+    // returning.
+    void enqueue(Job job);
+
+    std::size_t get_thread_count() const { return workers.size() + 1; }
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,465 @@
+#include "texture_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <fmt/core.h>
+
+#include <stb_image.h>
+
+#include "wgpu_mipmaps.hpp"
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double get_elapsed_ms(Clock::time_point const start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+float srgb_to_linear(float const c)
+{
+    return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linear_to_srgb(float const c)
+{
+    return (c <= 0.0031308f) ? 12.92f * c : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// Weights of the three source texels starting at 2x along one axis. Matches the weights used by
+// MipmapGenerator so that odd sizes don't shift or drop texels.
+void get_weights(
+    std::uint32_t const x,
+    std::uint32_t const src_size,
+    std::uint32_t const dst_size,
+    float result[3])
+{
+    if (src_size == 1)
+    {
+        result[0] = 1.0f;
+        result[1] = result[2] = 0.0f;
+    }
+    else if (src_size == 2 * dst_size)
+    {
+        result[0] = result[1] = 0.5f;
+        result[2] = 0.0f;
+    }
+    else
+    {
+        float const n = float(dst_size);
+        float const i = float(x);
+        result[0] = (n - i) / (2.0f * n + 1.0f);
+        result[1] = n / (2.0f * n + 1.0f);
+        result[2] = (i + 1.0f) / (2.0f * n + 1.0f);
+    }
+}
+
+// Box filters a level of RGBA8 texels down to the next
+void downsample(
+    std::uint8_t const* const src,
+    TextureCacheHeader::Level const& src_level,
+    std::uint8_t* const dst,
+    TextureCacheHeader::Level const& dst_level,
+    bool const is_srgb)
+{
+    float to_linear[256];
+    for (int i = 0; i < 256; ++i)
+        to_linear[i] = is_srgb ? srgb_to_linear(i / 255.0f) : i / 255.0f;
+
+    for (std::uint32_t y = 0; y < dst_level.height; ++y)
+    {
+        float wy[3];
+        get_weights(y, src_level.height, dst_level.height, wy);
+
+        for (std::uint32_t x = 0; x < dst_level.width; ++x)
+        {
+            float wx[3];
+            get_weights(x, src_level.width, dst_level.width, wx);
+
+            float sum[4]{};
+            for (std::uint32_t j = 0; j < 3; ++j)
+            {
+                std::uint32_t const sy = std::min(2 * y + j, src_level.height - 1);
+                for (std::uint32_t i = 0; i < 3; ++i)
+                {
+                    float const w = wx[i] * wy[j];
+                    if (w == 0.0f)
+                        continue;
+
+                    std::uint32_t const sx = std::min(2 * x + i, src_level.width - 1);
+                    std::uint8_t const* const texel =
+                        src + std::size_t(sy) * src_level.bytes_per_row + sx * 4;
+                    for (int k = 0; k < 3; ++k)
+                        sum[k] += w * to_linear[texel[k]];
+
+                    // Alpha is always linear
+                    sum[3] += w * (texel[3] / 255.0f);
+                }
+            }
+
+            std::uint8_t* const texel = dst + std::size_t(y) * dst_level.bytes_per_row + x * 4;
+            for (int k = 0; k < 4; ++k)
+            {
+                float const c = (is_srgb && k < 3) ? linear_to_srgb(sum[k]) : sum[k];
+                texel[k] = std::uint8_t(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+std::string get_entry_path(char const* const cache_dir, std::uint64_t const key)
+{
+    return fmt::format("{}/{:016x}.texc", cache_dir, key);
+}
+
+// Lays out the levels of a mip chain with the given base size one after another. Returns the total
+// size of the entry including its header.
+std::uint64_t layout_levels(
+    std::uint32_t const width,
+    std::uint32_t const height,
+    std::uint32_t const level_count,
+    TextureCacheHeader::Level* const levels)
+{
+    std::uint64_t offset = align_up(sizeof(TextureCacheHeader), TextureCacheHeader::row_alignment);
+    for (std::uint32_t i = 0; i < level_count; ++i)
+    {
+        TextureCacheHeader::Level& level = levels[i];
+        level.offset = offset;
+        level.width = std::max(width >> i, 1u);
+        level.height = std::max(height >> i, 1u);
+        level.bytes_per_row =
+            std::uint32_t(align_up(level.width * 4, TextureCacheHeader::row_alignment));
+        offset += std::uint64_t(level.bytes_per_row) * level.height;
+    }
+
+    return offset;
+}
+
+// Checks that the header describes exactly the layout that decode would have written for an image
+// of its base size so that levels can be uploaded without further checks
+bool is_valid_header(
+    TextureCacheHeader const& header,
+    std::uint64_t const key,
+    std::size_t const file_size)
+{
+    // Largest width whose padded rows still fit in bytes_per_row
+    constexpr std::uint32_t max_width =
+        (std::numeric_limits<std::uint32_t>::max() - TextureCacheHeader::row_alignment) / 4;
+
+    TextureCacheHeader::Level const& base = header.levels[0];
+    if (header.magic != TextureCacheHeader::magic_value
+        || header.version != TextureCacheHeader::version_value || header.key != key
+        || header.format != WGPUTextureFormat_RGBA8Unorm || header.level_count == 0
+        || header.level_count > TextureCacheHeader::max_level_count || base.width == 0
+        || base.width > max_width || base.height == 0
+        || header.level_count > get_mip_level_count(base.width, base.height))
+    {
+        return false;
+    }
+
+    TextureCacheHeader::Level expected[TextureCacheHeader::max_level_count];
+    if (layout_levels(base.width, base.height, header.level_count, expected) > file_size)
+        return false;
+
+    return std::equal(
+        header.levels,
+        header.levels + header.level_count,
+        expected,
+        [](TextureCacheHeader::Level const& a, TextureCacheHeader::Level const& b) {
+            return a.offset == b.offset && a.width == b.width && a.height == b.height
+                   && a.bytes_per_row == b.bytes_per_row;
+        });
+}
+
+// Decodes the source image and lays out its levels in memory as they'll be stored in the cache
+bool decode(
+    std::span<std::uint8_t const> const src,
+    std::uint64_t const key,
+    TextureCacheOptions const& options,
+    CachedTexture& result)
+{
+    int width, height, channels;
+    stbi_uc* const pixels =
+        stbi_load_from_memory(src.data(), int(src.size()), &width, &height, &channels, 4);
+    if (!pixels)
+        return false;
+
+    TextureCacheHeader header{};
+    header.magic = TextureCacheHeader::magic_value;
+    header.version = TextureCacheHeader::version_value;
+    header.key = key;
+    header.format = WGPUTextureFormat_RGBA8Unorm;
+    header.level_count = options.with_mips ? std::min(
+                                                 get_mip_level_count(width, height),
+                                                 TextureCacheHeader::max_level_count)
+                                           : 1;
+
+    std::uint64_t const size = layout_levels(
+        std::uint32_t(width),
+        std::uint32_t(height),
+        header.level_count,
+        header.levels);
+
+    result.memory.assign(size, 0);
+    std::memcpy(result.memory.data(), &header, sizeof(header));
+
+    // Copy level 0 row by row to pad it out
+    {
+        TextureCacheHeader::Level const& level = header.levels[0];
+        for (std::uint32_t y = 0; y < level.height; ++y)
+        {
+            std::memcpy(
+                result.memory.data() + level.offset + std::size_t(y) * level.bytes_per_row,
+                pixels + std::size_t(y) * level.width * 4,
+                level.width * 4);
+        }
+    }
+    stbi_image_free(pixels);
+
+    auto const t0 = Clock::now();
+    for (std::uint32_t i = 1; i < header.level_count; ++i)
+    {
+        downsample(
+            result.memory.data() + header.levels[i - 1].offset,
+            header.levels[i - 1],
+            result.memory.data() + header.levels[i].offset,
+            header.levels[i],
+            options.is_srgb);
+    }
+    result.timings.mips_ms = get_elapsed_ms(t0);
+
+    result.header = reinterpret_cast<TextureCacheHeader const*>(result.memory.data());
+    return true;
+}
+
+// Returns a temporary path next to the given one that no other writer will use, whether in this
+// process or another
+std::string get_temp_path(std::string const& path)
+{
+#ifdef _WIN32
+    int const pid = _getpid();
+#else
+    int const pid = getpid();
+#endif
+
+    static std::atomic<std::uint32_t> counter{};
+    std::size_t const thread_id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    return fmt::format("{}.{}-{:x}-{}.tmp", path, pid, thread_id, counter++);
+}
+
+// Writes to a temporary file first so that a partially written entry is never seen by a reader.
+// Concurrent writers of the same entry each write their own file and the last rename wins.
+bool write_entry(std::string const& path, std::span<std::uint8_t const> const data)
+{
+    std::string const tmp_path = get_temp_path(path);
+    std::FILE* const file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool const is_written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (std::fclose(file) != 0 || !is_written)
+    {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    std::error_code err{};
+    std::filesystem::rename(tmp_path, path, err);
+    if (err)
+        std::remove(tmp_path.c_str());
+
+    return !err;
+}
+
+} // namespace
+
+void CachedTexture::release(CachedTexture& texture)
+{
+    MappedFile::release(texture.file);
+    texture = {};
+}
+
+std::span<std::uint8_t const> CachedTexture::get_level(std::uint32_t const level) const
+{
+    TextureCacheHeader::Level const& info = header->levels[level];
+    auto const base = reinterpret_cast<std::uint8_t const*>(header);
+    return {base + info.offset, std::size_t(info.bytes_per_row) * info.height};
+}
+
+void CachedTexture::report(char const* const name) const
+{
+    fmt::println(
+        "Texture cache {} for {} ({}x{}, {} levels):",
+        is_hit ? "hit" : "miss",
+        name,
+        header->levels[0].width,
+        header->levels[0].height,
+        header->level_count);
+    fmt::println("\thash: {:.2f} ms", timings.hash_ms);
+    fmt::println("\t{}: {:.2f} ms", is_hit ? "read" : "decode", timings.read_ms);
+
+    if (!is_hit)
+    {
+        fmt::println("\tmips: {:.2f} ms", timings.mips_ms);
+        fmt::println("\twrite: {:.2f} ms", timings.write_ms);
+    }
+
+    fmt::println("\ttotal: {:.2f} ms", timings.total_ms);
+}
+
+std::uint64_t get_texture_cache_key(
+    std::span<std::uint8_t const> const src,
+    TextureCacheOptions const& options)
+{
+    Hasher hasher{};
+    hasher.add(TextureCacheHeader::version_value);
+    hasher.add(options.with_mips);
+    hasher.add(options.is_srgb);
+    hasher.add(src.size());
+    hasher.add_bytes(src.data(), src.size());
+    return hasher.value;
+}
+
+CachedTexture load_cached_texture(
+    char const* const src_path,
+    char const* const cache_dir,
+    TextureCacheOptions const& options)
+{
+    auto const t0 = Clock::now();
+
+    MappedFile src = MappedFile::make(src_path);
+    if (!src.is_valid())
+        return {};
+
+    src.advise_sequential();
+    CachedTexture result = load_cached_texture(src.get_range(0, src.size), cache_dir, options);
+    MappedFile::release(src);
+
+    // Include the time spent mapping the source
+    double const map_ms = get_elapsed_ms(t0) - result.timings.total_ms;
+    result.timings.hash_ms += map_ms;
+    result.timings.total_ms += map_ms;
+
+    return result;
+}
+
+CachedTexture load_cached_texture(
+    std::span<std::uint8_t const> const src,
+    char const* const cache_dir,
+    TextureCacheOptions const& options)
+{
+    auto const t0 = Clock::now();
+    CachedTexture result{};
+
+    std::uint64_t const key = get_texture_cache_key(src, options);
+    result.timings.hash_ms = get_elapsed_ms(t0);
+
+    std::string const entry_path = cache_dir ? get_entry_path(cache_dir, key) : std::string{};
+
+    // Use the cached entry if there's a valid one
+    if (cache_dir)
+    {
+        auto const t1 = Clock::now();
+        result.file = MappedFile::make(entry_path.c_str());
+
+        if (result.file.is_valid() && result.file.size >= sizeof(TextureCacheHeader))
+        {
+            auto const header = reinterpret_cast<TextureCacheHeader const*>(result.file.data);
+            if (is_valid_header(*header, key, result.file.size))
+            {
+                result.header = header;
+                result.is_hit = true;
+            }
+        }
+
+        if (!result.is_hit)
+            MappedFile::release(result.file);
+
+        result.timings.read_ms = get_elapsed_ms(t1);
+    }
+
+    if (!result.is_hit)
+    {
+        auto const t1 = Clock::now();
+        bool const is_decoded = decode(src, key, options, result);
+        result.timings.read_ms = get_elapsed_ms(t1) - result.timings.mips_ms;
+
+        if (is_decoded && cache_dir)
+        {
+            auto const t2 = Clock::now();
+            std::error_code err{};
+            std::filesystem::create_directories(cache_dir, err);
+
+            if (!write_entry(entry_path, result.memory))
+                fmt::println("Failed to write texture cache entry {}", entry_path);
+
+            result.timings.write_ms = get_elapsed_ms(t2);
+        }
+    }
+
+    result.timings.total_ms = get_elapsed_ms(t0);
+
+    return result;
+}
+
+WGPUTexture make_texture_from_cache(
+    WGPUDevice const device,
+    CachedTexture const& texture,
+    WGPUTextureUsage const usage)
+{
+    TextureCacheHeader const& header = *texture.header;
+
+    WGPUTextureDescriptor const desc{
+        .usage = usage | WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {header.levels[0].width, header.levels[0].height, 1},
+        .format = WGPUTextureFormat(header.format),
+        .mipLevelCount = header.level_count,
+        .sampleCount = 1,
+    };
+    WGPUTexture const result = wgpuDeviceCreateTexture(device, &desc);
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+    for (std::uint32_t i = 0; i < header.level_count; ++i)
+    {
+        TextureCacheHeader::Level const& level = header.levels[i];
+        std::span<std::uint8_t const> const data = texture.get_level(i);
+
+        WGPUTexelCopyTextureInfo const dst{
+            .texture = result,
+            .mipLevel = i,
+        };
+        WGPUTexelCopyBufferLayout const layout{
+            .bytesPerRow = level.bytes_per_row,
+            .rowsPerImage = level.height,
+        };
+        WGPUExtent3D const extent{level.width, level.height, 1};
+        wgpuQueueWriteTexture(queue, &dst, data.data(), data.size(), &layout, &extent);
+    }
+
+    return result;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+#include "mapped_file.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Header at the start of a cached texture file. Each level's rows are padded to row_alignment so
+// they can be copied to the GPU from a buffer or straight from the mapped file. All values are
+// little endian.
+struct TextureCacheHeader
+{
+    static constexpr std::uint32_t magic_value = 0x43584554; // "TEXC"
+    static constexpr std::uint32_t version_value = 1;
+    static constexpr std::uint32_t row_alignment = 256;
+    static constexpr std::uint32_t max_level_count = 16;
+
+    struct Level
+    {
+        std::uint64_t offset;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t bytes_per_row;
+        std::uint32_t padding;
+    };
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t format; // WGPUTextureFormat, currently always RGBA8Unorm
+    std::uint32_t level_count;
+    Level levels[max_level_count];
+};
+
+struct TextureCacheOptions
+{
+    bool with_mips{true};
+    bool is_srgb{true}; // Texels are sRGB encoded so mips are filtered after conversion to linear
+};
+
+// Time spent in each stage of a cached load
+struct TextureCacheTimings
+{
+    double hash_ms;
+    double read_ms; // Mapping and validating a cache entry on a hit, decoding on a miss
+    double mips_ms;
+    double write_ms;
+    double total_ms;
+};
+
+// Decoded RGBA8 image with all of its mip levels, laid out as described by the header. Data is
+// either mapped from a cache entry or held in memory if no entry could be used.
+struct CachedTexture
+{
+    MappedFile file;
+    std::vector<std::uint8_t> memory;
+    TextureCacheHeader const* header;
+    TextureCacheTimings timings;
+    bool is_hit;
+
+    static void release(CachedTexture& texture);
+
+    bool is_valid() const { return header != nullptr; }
+
+    std::span<std::uint8_t const> get_level(std::uint32_t level) const;
+
+    void report(char const* name) const;
+};
+
+// Returns the cache key for the given source file contents and options
+std::uint64_t get_texture_cache_key(
+    std::span<std::uint8_t const> src,
+    TextureCacheOptions const& options);
+
+// Loads a decoded image from the cache if it holds an entry for the current contents of the source
+// file. Otherwise, decodes the image (PNG, JPEG, etc.), builds mips if requested and writes a new
+// entry. Entries are named after their key so editing the source file leaves its old entry unused
+// rather than stale. If cache_dir is null, the image is decoded into memory without caching.
+// Returns an invalid texture if the source can't be read or decoded.
+CachedTexture load_cached_texture(
+    char const* src_path,
+    char const* cache_dir,
+    TextureCacheOptions const& options = {});
+
+// Same as above for source file contents that are already in memory, e.g. read from an asset pack
+CachedTexture load_cached_texture(
+    std::span<std::uint8_t const> src,
+    char const* cache_dir,
+    TextureCacheOptions const& options = {});
+
+// Creates a texture with the same levels as the cached image and uploads all of them. Usage is
+// added to TextureBinding | CopyDst.
+WGPUTexture make_texture_from_cache(
+    WGPUDevice device,
+    CachedTexture const& texture,
+    WGPUTextureUsage usage = WGPUTextureUsage_None);
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,224 @@
+#include "vertex_quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <fmt/core.h>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr float snorm16_max = 32767.0f;
+constexpr float unorm16_max = 65535.0f;
+
+void read_floats(
+    std::uint8_t const* const vertex,
+    std::uint32_t const offset,
+    float* const dst,
+    std::size_t const count)
+{
+    std::memcpy(dst, vertex + offset, count * sizeof(float));
+}
+
+float get_length(float const v[3]) { return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]); }
+
+float get_angle_deg(float const a[3], float const b[3])
+{
+    float const cos_angle = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) /
+                            std::max(get_length(a) * get_length(b), 1.0e-12f);
+    return std::acos(std::clamp(cos_angle, -1.0f, 1.0f)) * (180.0f / 3.14159265f);
+}
+
+} // namespace
+
+void VertexQuantization::report() const
+{
+    fmt::println("Vertex quantization:");
+    fmt::println("\tstride: {} bytes", stride);
+    fmt::println(
+        "\tmax position error: {:.3g} ({:.3g} of extent)",
+        max_position_error,
+        (extent > 0.0f) ? max_position_error / extent : 0.0f);
+
+    if (normal_offset != VertexAttributes::none)
+        fmt::println("\tmax normal error: {:.3g} deg", max_normal_error);
+
+    if (tex_coords_offset != VertexAttributes::none)
+        fmt::println("\tmax tex coords error: {:.3g}", max_tex_coords_error);
+}
+
+VertexQuantization quantize_vertices(
+    MeshBuffers const& mesh,
+    VertexAttributes const& attributes,
+    MeshBuffers& result)
+{
+    std::uint32_t const vertex_count = mesh.get_vertex_count();
+
+    // Lay out attributes
+    VertexQuantization info{};
+    info.stride = 4 * sizeof(std::int16_t);
+    info.normal_offset = VertexAttributes::none;
+    info.tex_coords_offset = VertexAttributes::none;
+
+    if (attributes.normal != VertexAttributes::none)
+    {
+        info.normal_offset = info.stride;
+        info.stride += 2 * sizeof(std::int16_t);
+    }
+
+    if (attributes.tex_coords != VertexAttributes::none)
+    {
+        info.tex_coords_offset = info.stride;
+        info.stride += 2 * sizeof(std::uint16_t);
+    }
+
+    // Map position bounds to [-1, 1]
+    {
+        float min[3]{INFINITY, INFINITY, INFINITY};
+        float max[3]{-INFINITY, -INFINITY, -INFINITY};
+
+        for (std::uint32_t i = 0; i < vertex_count; ++i)
+        {
+            float p[3];
+            read_floats(&mesh.vertices[i * mesh.vertex_stride], attributes.position, p, 3);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                min[j] = std::min(min[j], p[j]);
+                max[j] = std::max(max[j], p[j]);
+            }
+        }
+
+        for (int j = 0; j < 3; ++j)
+        {
+            float const half = (vertex_count > 0) ? 0.5f * (max[j] - min[j]) : 0.0f;
+            info.position_offset[j] = (vertex_count > 0) ? min[j] + half : 0.0f;
+            info.position_scale[j] = (half > 0.0f) ? half : 1.0f;
+            info.extent = std::max(info.extent, 2.0f * half);
+        }
+    }
+
+    result.vertex_stride = info.stride;
+    result.vertices.assign(std::size_t(vertex_count) * info.stride, 0);
+    result.indices = mesh.indices;
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::uint8_t const* const src = &mesh.vertices[i * mesh.vertex_stride];
+        std::uint8_t* const dst = &result.vertices[i * info.stride];
+
+        // Position
+        {
+            float p[3];
+            read_floats(src, attributes.position, p, 3);
+
+            std::int16_t q[4];
+            for (int j = 0; j < 3; ++j)
+            {
+                q[j] = quantize_snorm16((p[j] - info.position_offset[j]) / info.position_scale[j]);
+
+                float const decoded =
+                    info.position_offset[j] + info.position_scale[j] * dequantize_snorm16(q[j]);
+                float const err = std::abs(decoded - p[j]);
+                info.max_position_error = std::max(info.max_position_error, err);
+            }
+            q[3] = std::int16_t(snorm16_max);
+
+            std::memcpy(dst, q, sizeof(q));
+        }
+
+        // Normal
+        if (attributes.normal != VertexAttributes::none)
+        {
+            float n[3];
+            read_floats(src, attributes.normal, n, 3);
+
+            float oct[2];
+            encode_octahedral(n, oct);
+
+            std::int16_t const q[2]{quantize_snorm16(oct[0]), quantize_snorm16(oct[1])};
+            std::memcpy(dst + info.normal_offset, q, sizeof(q));
+
+            float const decoded_oct[2]{dequantize_snorm16(q[0]), dequantize_snorm16(q[1])};
+            float decoded[3];
+            decode_octahedral(decoded_oct, decoded);
+            info.max_normal_error = std::max(info.max_normal_error, get_angle_deg(n, decoded));
+        }
+
+        // Texture coordinates
+        if (attributes.tex_coords != VertexAttributes::none)
+        {
+            float uv[2];
+            read_floats(src, attributes.tex_coords, uv, 2);
+
+            std::uint16_t q[2];
+            for (int j = 0; j < 2; ++j)
+            {
+                // Coordinates outside of [0, 1] are clamped which shows up as error
+                q[j] = quantize_unorm16(uv[j]);
+                float const err = std::abs(dequantize_unorm16(q[j]) - uv[j]);
+                info.max_tex_coords_error = std::max(info.max_tex_coords_error, err);
+            }
+
+            std::memcpy(dst + info.tex_coords_offset, q, sizeof(q));
+        }
+    }
+
+    return info;
+}
+
+std::int16_t quantize_snorm16(float const value)
+{
+    return std::int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * snorm16_max));
+}
+
+float dequantize_snorm16(std::int16_t const value)
+{
+    return std::max(float(value) / snorm16_max, -1.0f);
+}
+
+std::uint16_t quantize_unorm16(float const value)
+{
+    return std::uint16_t(std::lround(std::clamp(value, 0.0f, 1.0f) * unorm16_max));
+}
+
+float dequantize_unorm16(std::uint16_t const value) { return float(value) / unorm16_max; }
+
+void encode_octahedral(float const normal[3], float result[2])
+{
+    float const sum = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    float const x = (sum > 0.0f) ? normal[0] / sum : 0.0f;
+    float const y = (sum > 0.0f) ? normal[1] / sum : 0.0f;
+
+    // Fold the lower hemisphere over the diagonals
+    if (normal[2] < 0.0f)
+    {
+        result[0] = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+        result[1] = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+    }
+    else
+    {
+        result[0] = x;
+        result[1] = y;
+    }
+}
+
+void decode_octahedral(float const value[2], float result[3])
+{
+    result[0] = value[0];
+    result[1] = value[1];
+    result[2] = 1.0f - std::abs(value[0]) - std::abs(value[1]);
+
+    float const t = std::max(-result[2], 0.0f);
+    result[0] += (result[0] >= 0.0f) ? -t : t;
+    result[1] += (result[1] >= 0.0f) ? -t : t;
+
+    float const len = get_length(result);
+    for (int i = 0; i < 3; ++i)
+        result[i] /= len;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mesh_optimizer.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Offsets of float attributes within a source vertex. Positions are 3 floats, normals are 3
+// floats, and texture coordinates are 2 floats.
+struct VertexAttributes
+{
+    static constexpr std::uint32_t none = ~0u;
+    std::uint32_t position{0};
+    std::uint32_t normal{none};
+    std::uint32_t tex_coords{none};
+};
+
+// Max acceptable decoding error for each attribute
+struct QuantizationTolerance
+{
+    float position{1.0e-4f}; // Relative to the largest extent of the mesh
+    float normal{0.5f}; // Degrees
+    float tex_coords{1.0f / 8192.0f};
+};
+
+// Describes a mesh quantized by quantize_vertices. Quantized vertices are laid out as
+//
+//  position: Snorm16x4, decoded as position_offset + position_scale * value.xyz
+//  normal: Snorm16x2, octahedral encoded (if present)
+//  tex_coords: Unorm16x2 (if present)
+//
+// which is half the size of the float equivalent or less.
+struct VertexQuantization
+{
+    float position_scale[3];
+    float position_offset[3];
+    std::uint32_t stride;
+    std::uint32_t normal_offset;
+    std::uint32_t tex_coords_offset;
+
+    // Largest decoding errors over all vertices
+    float extent;
+    float max_position_error;
+    float max_normal_error; // Degrees
+    float max_tex_coords_error;
+
+    bool is_within(QuantizationTolerance const& tolerance) const
+    {
+        return max_position_error <= tolerance.position * extent &&
+               max_normal_error <= tolerance.normal &&
+               max_tex_coords_error <= tolerance.tex_coords;
+    }
+
+    void report() const;
+};
+
+// Quantizes vertex attributes and measures the resulting error. Indices are copied as is.
+VertexQuantization quantize_vertices(
+    MeshBuffers const& mesh,
+    VertexAttributes const& attributes,
+    MeshBuffers& result);
+
+std::int16_t quantize_snorm16(float value);
+
+float dequantize_snorm16(std::int16_t value);
+
+std::uint16_t quantize_unorm16(float value);
+
+float dequantize_unorm16(std::uint16_t value);
+
+// Maps a unit vector to a point in [-1, 1]^2 by projecting onto an octahedron and unfolding it
+void encode_octahedral(float const normal[3], float result[2]);
+
+void decode_octahedral(float const value[2], float result[3]);
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,185 @@
+#include "wgpu_bind_group_cache.hpp"
+
+#include <cassert>
+
+#include <fmt/core.h>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+bool refers_to(BindGroupCache::Key const& key, void const* const resource)
+{
+    if (key.layout == resource)
+        return true;
+
+    for (BindGroupCache::Key::Binding const& b : key.bindings)
+    {
+        if (b.buffer == resource || b.sampler == resource || b.texture_view == resource)
+            return true;
+    }
+
+    return false;
+}
+
+template <typename Func>
+void for_each_resource(BindGroupCache::Key const& key, Func&& func)
+{
+    func(key.layout);
+
+    for (BindGroupCache::Key::Binding const& b : key.bindings)
+    {
+        if (b.buffer)
+            func(b.buffer);
+        if (b.sampler)
+            func(b.sampler);
+        if (b.texture_view)
+            func(b.texture_view);
+    }
+}
+
+} // namespace
+
+std::size_t BindGroupCache::KeyHash::operator()(Key const& key) const
+{
+    Hasher hasher{};
+    hasher.add(key.layout);
+    hasher.add(key.bindings.size());
+
+    for (Key::Binding const& b : key.bindings)
+    {
+        hasher.add(b.binding);
+        hasher.add(b.buffer);
+        hasher.add(b.offset);
+        hasher.add(b.size);
+        hasher.add(b.sampler);
+        hasher.add(b.texture_view);
+    }
+
+    return std::size_t(hasher.value);
+}
+
+BindGroupCache BindGroupCache::make(WGPUDevice const device)
+{
+    BindGroupCache result{};
+    result.device = device;
+    return result;
+}
+
+void BindGroupCache::release(BindGroupCache& cache)
+{
+    for (auto& [key, bind_group] : cache.entries)
+        wgpuBindGroupRelease(bind_group);
+
+    cache = {};
+}
+
+WGPUBindGroup BindGroupCache::get(WGPUBindGroupDescriptor const& desc)
+{
+    scratch.layout = desc.layout;
+    scratch.bindings.clear();
+
+    for (std::size_t i = 0; i < desc.entryCount; ++i)
+    {
+        auto const& entry = desc.entries[i];
+        scratch.bindings.push_back({
+            .binding = entry.binding,
+            .buffer = entry.buffer,
+            .offset = entry.offset,
+            .size = entry.size,
+            .sampler = entry.sampler,
+            .texture_view = entry.textureView,
+        });
+    }
+
+    auto const it = entries.find(scratch);
+    if (it != entries.end())
+    {
+        ++stats.hits;
+        wgpuBindGroupAddRef(it->second);
+        return it->second;
+    }
+
+    WGPUBindGroup const bind_group = wgpuDeviceCreateBindGroup(device, &desc);
+    assert(bind_group);
+    ++stats.misses;
+
+    add_resource_refs(scratch);
+    entries.emplace(scratch, bind_group);
+
+    wgpuBindGroupAddRef(bind_group);
+    return bind_group;
+}
+
+void BindGroupCache::invalidate(void const* const resource)
+{
+    // Most resources aren't referred to by any cached bind groups
+    if (!resource_counts.contains(resource))
+        return;
+
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (refers_to(it->first, resource))
+        {
+            remove_resource_refs(it->first);
+            wgpuBindGroupRelease(it->second);
+            it = entries.erase(it);
+            ++stats.invalidations;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    assert(!resource_counts.contains(resource));
+}
+
+void BindGroupCache::release_resource(WGPUBuffer const buffer)
+{
+    invalidate(buffer);
+    wgpuBufferRelease(buffer);
+}
+
+void BindGroupCache::release_resource(WGPUTextureView const view)
+{
+    invalidate(view);
+    wgpuTextureViewRelease(view);
+}
+
+void BindGroupCache::release_resource(WGPUSampler const sampler)
+{
+    invalidate(sampler);
+    wgpuSamplerRelease(sampler);
+}
+
+void BindGroupCache::report() const
+{
+    fmt::println("Bind group cache:");
+    fmt::println(
+        "\t{} hits, {} misses, {} invalidations",
+        stats.hits,
+        stats.misses,
+        stats.invalidations);
+}
+
+void BindGroupCache::add_resource_refs(Key const& key)
+{
+    for_each_resource(key, [&](void const* const resource) { ++resource_counts[resource]; });
+}
+
+void BindGroupCache::remove_resource_refs(Key const& key)
+{
+    for_each_resource(key, [&](void const* const resource) {
+        auto const it = resource_counts.find(resource);
+        assert(it != resource_counts.end());
+
+        if (--it->second == 0)
+            resource_counts.erase(it);
+    });
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Reuses bind groups created from the same layout and bound resources. The cache holds one
+// reference to each bind group and returns a new reference on every lookup so the caller releases
+// it as if it had been created directly.
+//
+// Cached bind groups keep the resources they refer to alive, so resources should be released
+// through the cache. This drops any bind groups that refer to them, which also prevents a new
+// resource that happens to reuse a handle from being matched with a stale bind group.
+struct BindGroupCache
+{
+    // Full description of a bind group, compared on lookup so that hash collisions can't return
+    // the wrong bind group
+    struct Key
+    {
+        struct Binding
+        {
+            std::uint32_t binding;
+            WGPUBuffer buffer;
+            std::uint64_t offset;
+            std::uint64_t size;
+            WGPUSampler sampler;
+            WGPUTextureView texture_view;
+
+            bool operator==(Binding const&) const = default;
+        };
+
+        WGPUBindGroupLayout layout;
+        std::vector<Binding> bindings;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const;
+    };
+
+    struct Stats
+    {
+        std::uint32_t hits;
+        std::uint32_t misses;
+        std::uint32_t invalidations;
+    };
+
+    WGPUDevice device;
+    std::unordered_map<Key, WGPUBindGroup, KeyHash> entries;
+    // Number of cached bind groups that refer to each resource
+    std::unordered_map<void const*, std::uint32_t> resource_counts;
+    Key scratch; // Reused between lookups to avoid allocating
+    Stats stats;
+
+    static BindGroupCache make(WGPUDevice device);
+
+    static void release(BindGroupCache& cache);
+
+    WGPUBindGroup get(WGPUBindGroupDescriptor const& desc);
+
+    // Drops any cached bind groups that refer to the given buffer, texture view, sampler, or
+    // layout. Does nothing if none do.
+    void invalidate(void const* resource);
+
+    // Drops any cached bind groups that refer to the given resource then releases it
+    void release_resource(WGPUBuffer buffer);
+    void release_resource(WGPUTextureView view);
+    void release_resource(WGPUSampler sampler);
+
+    void report() const;
+
+  private:
+    void add_resource_refs(Key const& key);
+    void remove_resource_refs(Key const& key);
+};
+
+} // namespace wgpu::sandbox
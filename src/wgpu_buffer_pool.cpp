@@ -0,0 +1,110 @@
+#include "wgpu_buffer_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+BufferPool BufferPool::make(
+    WGPUDevice const device,
+    WGPUBufferUsage const usage,
+    std::uint64_t const page_size)
+{
+    BufferPool result{};
+    result.device = device;
+    result.usage = usage;
+    result.alignment = get_min_offset_alignment(device, usage);
+    result.page_size = page_size;
+
+    return result;
+}
+
+void BufferPool::release(BufferPool& pool)
+{
+    for (Page& page : pool.pages)
+        wgpuBufferRelease(page.buffer);
+
+    pool = {};
+}
+
+BufferPool::Allocation BufferPool::allocate(std::uint64_t const size)
+{
+    std::size_t page_index = 0;
+    RangeAllocator::Allocation alloc{};
+
+    for (; page_index < pages.size(); ++page_index)
+    {
+        alloc = pages[page_index].allocator.allocate(size);
+        if (alloc.is_valid())
+            break;
+    }
+
+    // No page has room so add another
+    if (!alloc.is_valid())
+    {
+        Page& page = pages.emplace_back();
+        page.allocator = RangeAllocator::make(std::max(page_size, size), alignment);
+
+        WGPUBufferDescriptor const desc{
+            .usage = usage,
+            .size = page.allocator.capacity,
+        };
+        page.buffer = wgpuDeviceCreateBuffer(device, &desc);
+        assert(page.buffer);
+
+        alloc = page.allocator.allocate(size);
+        assert(alloc.is_valid());
+    }
+
+    return {
+        .range{pages[page_index].buffer, alloc.offset, size},
+        .alloc = alloc,
+        .page = std::uint32_t(page_index),
+    };
+}
+
+void BufferPool::free(Allocation const& alloc)
+{
+    assert(alloc.is_valid());
+    assert(alloc.page < pages.size());
+    pages[alloc.page].allocator.free(alloc.alloc);
+}
+
+RangeAllocator::Stats BufferPool::get_stats() const
+{
+    RangeAllocator::Stats result{};
+
+    for (Page const& page : pages)
+    {
+        RangeAllocator::Stats const stats = page.allocator.get_stats();
+        result.capacity += stats.capacity;
+        result.used += stats.used;
+        result.largest_free = std::max(result.largest_free, stats.largest_free);
+        result.allocation_count += stats.allocation_count;
+        result.free_range_count += stats.free_range_count;
+    }
+
+    return result;
+}
+
+std::uint64_t get_min_offset_alignment(WGPUDevice const device, WGPUBufferUsage const usage)
+{
+    WGPULimits limits{};
+    [[maybe_unused]]
+    auto const status = wgpuDeviceGetLimits(device, &limits);
+    assert(status == WGPUStatus_Success);
+
+    std::uint64_t result = copy_alignment;
+
+    if (usage & WGPUBufferUsage_Uniform)
+        result = std::max<std::uint64_t>(result, limits.minUniformBufferOffsetAlignment);
+
+    if (usage & WGPUBufferUsage_Storage)
+        result = std::max<std::uint64_t>(result, limits.minStorageBufferOffsetAlignment);
+
+    return result;
+}
+
+} // namespace wgpu::sandbox
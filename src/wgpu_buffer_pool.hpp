@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+#include "range_allocator.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Range of a buffer. Used in place of an owned buffer by anything that's sub-allocated.
+struct BufferRange
+{
+    WGPUBuffer buffer;
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+// Sub-allocates ranges from a small number of large device buffers which share the same usage.
+// Ranges are aligned as required to bind them at their offset.
+struct BufferPool
+{
+    struct Allocation
+    {
+        BufferRange range;
+        RangeAllocator::Allocation alloc;
+        std::uint32_t page;
+        bool is_valid() const { return alloc.is_valid(); }
+    };
+
+    struct Page
+    {
+        WGPUBuffer buffer;
+        RangeAllocator allocator;
+    };
+
+    WGPUDevice device;
+    WGPUBufferUsage usage;
+    std::uint64_t page_size;
+    std::uint64_t alignment;
+    std::vector<Page> pages;
+
+    static BufferPool make(
+        WGPUDevice device,
+        WGPUBufferUsage usage,
+        std::uint64_t page_size = 16 << 20);
+
+    static void release(BufferPool& pool);
+
+    // Allocates a range from the first page with room, adding a page if needed. Requests larger
+    // than the page size get a page of their own.
+    Allocation allocate(std::uint64_t size);
+
+    void free(Allocation const& alloc);
+
+    // Returns stats summed over all pages. largest_free is the largest over all pages.
+    RangeAllocator::Stats get_stats() const;
+};
+
+// Returns the offset alignment required to bind a buffer with the given usage
+std::uint64_t get_min_offset_alignment(WGPUDevice device, WGPUBufferUsage usage);
+
+} // namespace wgpu::sandbox
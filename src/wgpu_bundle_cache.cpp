@@ -0,0 +1,100 @@
+#include "wgpu_bundle_cache.hpp"
+
+#include <cassert>
+
+#include <fmt/core.h>
+
+namespace wgpu::sandbox
+{
+
+RenderBundleCache RenderBundleCache::make(
+    WGPUDevice const device,
+    WGPUTextureFormat const* const color_formats,
+    std::uint32_t const color_format_count,
+    WGPUTextureFormat const depth_format,
+    std::uint32_t const slot_count)
+{
+    assert(slot_count > 0);
+
+    RenderBundleCache result{};
+    result.device = device;
+    result.color_formats.assign(color_formats, color_formats + color_format_count);
+    result.depth_format = depth_format;
+    result.slots.resize(slot_count);
+    return result;
+}
+
+void RenderBundleCache::release(RenderBundleCache& cache)
+{
+    for (Slot const& slot : cache.slots)
+    {
+        if (slot.bundle)
+            wgpuRenderBundleRelease(slot.bundle);
+    }
+
+    cache = {};
+}
+
+WGPURenderBundle RenderBundleCache::get(
+    std::uint32_t const slot,
+    std::uint64_t const key,
+    Record* const record,
+    void* const userdata)
+{
+    Slot& dst = slots[slot];
+
+    if (dst.bundle && dst.key == key)
+    {
+        ++stats.hits;
+        return dst.bundle;
+    }
+
+    WGPURenderBundleEncoderDescriptor const desc{
+        .colorFormatCount = color_formats.size(),
+        .colorFormats = color_formats.data(),
+        .depthStencilFormat = depth_format,
+        .sampleCount = 1,
+    };
+    WGPURenderBundleEncoder const encoder = wgpuDeviceCreateRenderBundleEncoder(device, &desc);
+    record(encoder, userdata);
+
+    WGPURenderBundle const bundle = wgpuRenderBundleEncoderFinish(encoder, nullptr);
+    assert(bundle);
+    wgpuRenderBundleEncoderRelease(encoder);
+    ++stats.misses;
+
+    // Commands already submitted with the old bundle keep their own reference to it
+    if (dst.bundle)
+        wgpuRenderBundleRelease(dst.bundle);
+
+    dst.bundle = bundle;
+    dst.key = key;
+
+    return bundle;
+}
+
+void RenderBundleCache::invalidate()
+{
+    for (Slot& slot : slots)
+    {
+        if (slot.bundle)
+        {
+            wgpuRenderBundleRelease(slot.bundle);
+            ++stats.invalidations;
+        }
+
+        slot = {};
+    }
+}
+
+void RenderBundleCache::report() const
+{
+    fmt::println("Render bundle cache:");
+    fmt::println(
+        "\t{} hits, {} misses, {} invalidations",
+        stats.hits,
+        stats.misses,
+        stats.invalidations);
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Keeps render bundles for a draw sequence that rarely changes so that it can be replayed each
+// frame instead of re-encoded. A bundle is kept for each frame slot since dynamic offsets into
+// per-frame uniform regions are baked into the recorded commands.
+//
+// The caller identifies the draw sequence with a key, typically a hash of the pipelines, bind
+// groups, buffers, and offsets it refers to. A slot's bundle is re-recorded whenever its key
+// changes.
+struct RenderBundleCache
+{
+    using Record = void(WGPURenderBundleEncoder encoder, void* userdata);
+
+    struct Slot
+    {
+        WGPURenderBundle bundle;
+        std::uint64_t key;
+    };
+
+    struct Stats
+    {
+        std::uint32_t hits;
+        std::uint32_t misses;
+        std::uint32_t invalidations;
+    };
+
+    WGPUDevice device;
+    std::vector<WGPUTextureFormat> color_formats;
+    WGPUTextureFormat depth_format;
+    std::vector<Slot> slots;
+    Stats stats;
+
+    static RenderBundleCache make(
+        WGPUDevice device,
+        WGPUTextureFormat const* color_formats,
+        std::uint32_t color_format_count,
+        WGPUTextureFormat depth_format,
+        std::uint32_t slot_count);
+
+    static void release(RenderBundleCache& cache);
+
+    // Returns the bundle for the given slot, recording a new one if the key has changed. The cache
+    // keeps ownership of the returned bundle.
+    WGPURenderBundle get(std::uint32_t slot, std::uint64_t key, Record* record, void* userdata);
+
+    template <typename Func>
+    WGPURenderBundle get(std::uint32_t const slot, std::uint64_t const key, Func&& record)
+    {
+        static_assert(std::is_invocable_v<Func, WGPURenderBundleEncoder>);
+        return get(
+            slot,
+            key,
+            [](WGPURenderBundleEncoder const encoder, void* const userdata) {
+                (*static_cast<std::remove_reference_t<Func>*>(userdata))(encoder);
+            },
+            &record);
+    }
+
+    // Drops all bundles e.g. when render target formats change
+    void invalidate();
+
+    void report() const;
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,231 @@
+#include "wgpu_culling.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr char const* shader_src = R"(
+struct Instance {
+    local_to_world: mat4x4f,
+    bounds: vec4f,
+};
+
+struct Params {
+    planes: array<vec4f, 6>,
+    instance_count: u32,
+};
+
+struct DrawArgs {
+    index_count: u32,
+    instance_count: atomic<u32>,
+    first_index: u32,
+    base_vertex: i32,
+    first_instance: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> instances: array<Instance>;
+@group(0) @binding(2) var<storage, read_write> visible: array<u32>;
+@group(0) @binding(3) var<storage, read_write> draw_args: DrawArgs;
+
+@compute @workgroup_size(64)
+fn cull_main(@builtin(global_invocation_id) id: vec3u) {
+    let index = id.x;
+    if (index >= params.instance_count) {
+        return;
+    }
+
+    let bounds = instances[index].bounds;
+    for (var i = 0u; i < 6u; i++) {
+        let plane = params.planes[i];
+        if (dot(plane.xyz, bounds.xyz) + plane.w < -bounds.w) {
+            return;
+        }
+    }
+
+    visible[atomicAdd(&draw_args.instance_count, 1u)] = index;
+}
+)";
+
+// Matches Params in the culling shader
+struct Params
+{
+    float planes[6][4];
+    std::uint32_t instance_count;
+    std::uint32_t padding[3];
+};
+
+WGPUComputePipeline make_pipeline(WGPUDevice const device)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = reinterpret_cast<WGPUChainedStruct*>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    assert(shader);
+
+    WGPUComputePipelineDescriptor const desc{
+        .compute{
+            .module = shader,
+            .entryPoint{"cull_main", WGPU_STRLEN},
+        },
+    };
+    WGPUComputePipeline const result = wgpuDeviceCreateComputePipeline(device, &desc);
+    wgpuShaderModuleRelease(shader);
+
+    return result;
+}
+
+WGPUBuffer make_buffer(
+    WGPUDevice const device,
+    WGPUBufferUsage const usage,
+    std::uint64_t const size)
+{
+    WGPUBufferDescriptor const desc{
+        .usage = usage | WGPUBufferUsage_CopyDst,
+        .size = size,
+    };
+    return wgpuDeviceCreateBuffer(device, &desc);
+}
+
+} // namespace
+
+GpuCuller GpuCuller::make(WGPUDevice const device, std::uint32_t const capacity)
+{
+    assert(capacity > 0);
+
+    GpuCuller result{};
+    result.capacity = capacity;
+    result.pipeline = make_pipeline(device);
+    assert(result.pipeline);
+
+    result.params = make_buffer(device, WGPUBufferUsage_Uniform, sizeof(Params));
+    result.instances = make_buffer(
+        device,
+        WGPUBufferUsage_Storage,
+        std::uint64_t(capacity) * sizeof(Instance));
+    result.visible = make_buffer(
+        device,
+        WGPUBufferUsage_Storage,
+        std::uint64_t(capacity) * sizeof(std::uint32_t));
+    result.draw_args = make_buffer(
+        device,
+        WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect,
+        sizeof(DrawArgs));
+
+    WGPUBindGroupEntry const entries[]{
+        {.binding = 0, .buffer = result.params, .size = sizeof(Params)},
+        {.binding = 1, .buffer = result.instances, .size = WGPU_WHOLE_SIZE},
+        {.binding = 2, .buffer = result.visible, .size = WGPU_WHOLE_SIZE},
+        {.binding = 3, .buffer = result.draw_args, .size = sizeof(DrawArgs)},
+    };
+    WGPUBindGroupDescriptor const desc{
+        .layout = wgpuComputePipelineGetBindGroupLayout(result.pipeline, 0),
+        .entryCount = sizeof(entries) / sizeof(entries[0]),
+        .entries = entries,
+    };
+    result.bind_group = wgpuDeviceCreateBindGroup(device, &desc);
+    wgpuBindGroupLayoutRelease(desc.layout);
+    assert(result.bind_group);
+
+    return result;
+}
+
+void GpuCuller::release(GpuCuller& culler)
+{
+    wgpuBindGroupRelease(culler.bind_group);
+    wgpuBufferRelease(culler.draw_args);
+    wgpuBufferRelease(culler.visible);
+    wgpuBufferRelease(culler.instances);
+    wgpuBufferRelease(culler.params);
+    wgpuComputePipelineRelease(culler.pipeline);
+    culler = {};
+}
+
+void GpuCuller::set_instances(
+    WGPUQueue const queue,
+    Instance const* const src,
+    std::uint32_t const count)
+{
+    assert(count <= capacity);
+    wgpuQueueWriteBuffer(queue, instances, 0, src, count * sizeof(Instance));
+    instance_count = count;
+}
+
+void GpuCuller::cull(
+    WGPUCommandEncoder const encoder,
+    WGPUQueue const queue,
+    float const world_to_clip[16],
+    std::uint32_t const index_count)
+{
+    Params params_data{};
+    get_frustum_planes(world_to_clip, params_data.planes);
+    params_data.instance_count = instance_count;
+    wgpuQueueWriteBuffer(queue, params, 0, &params_data, sizeof(params_data));
+
+    // Visible instances are counted from zero each frame
+    DrawArgs const args{.index_count = index_count};
+    wgpuQueueWriteBuffer(queue, draw_args, 0, &args, sizeof(args));
+
+    WGPUComputePassEncoder const pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
+    wgpuComputePassEncoderSetPipeline(pass, pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, nullptr);
+
+    std::uint32_t const group_count = (instance_count + workgroup_size - 1) / workgroup_size;
+    if (group_count > 0)
+        wgpuComputePassEncoderDispatchWorkgroups(pass, group_count, 1, 1);
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+}
+
+void get_frustum_planes(float const world_to_clip[16], float result[6][4])
+{
+    // Planes are sums and differences of the matrix's rows (Gribb & Hartmann)
+    auto const m = [&](int const row, int const col) { return world_to_clip[col * 4 + row]; };
+    constexpr int rows[6][2]{
+        {0, 1}, // Left: w + x
+        {0, -1}, // Right: w - x
+        {1, 1}, // Bottom: w + y
+        {1, -1}, // Top: w - y
+        {2, 0}, // Near: z
+        {2, -1}, // Far: w - z
+    };
+
+    for (int i = 0; i < 6; ++i)
+    {
+        int const row = rows[i][0];
+        int const sign = rows[i][1];
+
+        for (int j = 0; j < 4; ++j)
+            result[i][j] = (sign == 0) ? m(row, j) : m(3, j) + float(sign) * m(row, j);
+
+        float const len = std::sqrt(
+            result[i][0] * result[i][0] + result[i][1] * result[i][1] +
+            result[i][2] * result[i][2]);
+
+        for (int j = 0; j < 4; ++j)
+            result[i][j] /= len;
+    }
+}
+
+bool is_sphere_visible(float const planes[6][4], float const sphere[4])
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        float const* p = planes[i];
+        if (p[0] * sphere[0] + p[1] * sphere[1] + p[2] * sphere[2] + p[3] < -sphere[3])
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Frustum culls instances on the GPU and writes arguments for a single indexed indirect draw. A
+// compute pass tests each instance's bounding sphere against the frustum and appends the indices
+// of visible instances to a compacted list. The render pass then draws with
+// DrawIndexedIndirect, reading transforms via instances[visible[instance_index]].
+//
+// CPU cost per frame is a uniform write and one dispatch regardless of the number of instances.
+struct GpuCuller
+{
+    static constexpr std::uint32_t workgroup_size = 64;
+
+    // Matches Instance in the culling shader
+    struct Instance
+    {
+        float local_to_world[16];
+        float bounds[4]; // World space center and radius
+    };
+
+    // Matches DrawIndexedIndirect args
+    struct DrawArgs
+    {
+        std::uint32_t index_count;
+        std::uint32_t instance_count;
+        std::uint32_t first_index;
+        std::int32_t base_vertex;
+        std::uint32_t first_instance;
+    };
+
+    WGPUComputePipeline pipeline;
+    WGPUBuffer params;
+    WGPUBuffer instances; // Storage, array<Instance>
+    WGPUBuffer visible; // Storage, array<u32>
+    WGPUBuffer draw_args; // Indirect, DrawArgs
+    WGPUBindGroup bind_group;
+    std::uint32_t capacity;
+    std::uint32_t instance_count;
+
+    static GpuCuller make(WGPUDevice device, std::uint32_t capacity);
+
+    static void release(GpuCuller& culler);
+
+    void set_instances(WGPUQueue queue, Instance const* src, std::uint32_t count);
+
+    // Records a compute pass that culls instances against the frustum of the given world to clip
+    // transform. Draw args are set up to draw index_count indices per visible instance.
+    void cull(
+        WGPUCommandEncoder encoder,
+        WGPUQueue queue,
+        float const world_to_clip[16],
+        std::uint32_t index_count);
+
+    // Draws all instances that passed the last cull
+    void draw(WGPURenderPassEncoder encoder) const
+    {
+        wgpuRenderPassEncoderDrawIndexedIndirect(encoder, draw_args, 0);
+    }
+};
+
+// Extracts normalized frustum planes from a column-major world to clip transform. Planes are
+// stored as (nx, ny, nz, d) and face inward. Assumes clip space depth in [0, 1].
+void get_frustum_planes(float const world_to_clip[16], float result[6][4]);
+
+bool is_sphere_visible(float const planes[6][4], float const sphere[4]);
+
+} // namespace wgpu::sandbox
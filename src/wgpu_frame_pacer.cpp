@@ -0,0 +1,89 @@
+#include "wgpu_frame_pacer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+
+FramePacer FramePacer::make(WGPUDevice const device, std::uint32_t const frames_in_flight)
+{
+    assert(frames_in_flight > 0 && frames_in_flight <= max_frames_in_flight);
+
+    FramePacer result{};
+    result.device = device;
+    result.frames_in_flight = frames_in_flight;
+    return result;
+}
+
+void FramePacer::release(FramePacer& pacer)
+{
+    // Callbacks for pending frames refer to the pacer
+    pacer.wait_idle();
+    pacer = {};
+}
+
+std::uint32_t FramePacer::begin_frame()
+{
+    assert(frames_begun == frames_submitted);
+
+    // Only the oldest pending frame has to complete to free up a slot
+    if (get_pending_count() >= frames_in_flight)
+    {
+        wait_for_condition(device, submissions[get_slot(frames_completed)], [&]() {
+            return get_pending_count() < frames_in_flight;
+        });
+    }
+
+    std::uint32_t const slot = get_slot();
+    ++frames_begun;
+    return slot;
+}
+
+void FramePacer::end_frame()
+{
+    assert(frames_begun == frames_submitted + 1);
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+    submissions[get_slot()] = get_submission_index(queue);
+    std::uint64_t const frame = ++frames_submitted;
+
+    // Mark the frame as complete once the GPU is done with everything submitted up to now
+    WGPUQueueWorkDoneCallbackInfo cb_info{};
+    cb_info.userdata1 = this;
+    cb_info.userdata2 = reinterpret_cast<void*>(std::uintptr_t(frame));
+    cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+    cb_info.callback =
+#ifdef __EMSCRIPTEN__
+        // NOTE(dr): Callback from webgpu.h in Emdawnwebgpu has a different signature
+        [](
+            [[maybe_unused]] WGPUQueueWorkDoneStatus status,
+            WGPUStringView /*msg*/,
+            void* userdata1,
+            void* userdata2) {
+#else
+        [](
+            [[maybe_unused]] WGPUQueueWorkDoneStatus status,
+            void* userdata1,
+            void* userdata2) {
+#endif
+            auto& pacer = *static_cast<FramePacer*>(userdata1);
+            auto const frame = std::uint64_t(reinterpret_cast<std::uintptr_t>(userdata2));
+            assert(status == WGPUQueueWorkDoneStatus_Success);
+            pacer.frames_completed = std::max(pacer.frames_completed, frame);
+        };
+    wgpuQueueOnSubmittedWorkDone(queue, cb_info);
+}
+
+void FramePacer::wait_idle() const
+{
+    if (get_pending_count() > 0)
+    {
+        wait_for_condition(device, submissions[get_slot(frames_submitted - 1)], [&]() {
+            return get_pending_count() == 0;
+        });
+    }
+}
+
+} // namespace wgpu::sandbox
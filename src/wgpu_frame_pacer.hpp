@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Limits how many frames the CPU can get ahead of the GPU. Completion of each frame is tracked
+// with a submitted work done callback and a new frame only begins once there's a free slot. The
+// slot index can be used to select per-frame resources which are then guaranteed not to be in use
+// by the GPU.
+struct FramePacer
+{
+    static constexpr std::uint32_t max_frames_in_flight = 3;
+
+    WGPUDevice device;
+    std::uint64_t frames_begun;
+    std::uint64_t frames_submitted;
+    std::uint64_t frames_completed;
+    std::uint32_t frames_in_flight;
+    std::uint64_t submissions[max_frames_in_flight]; // Queue submission index of each slot's frame
+
+    static FramePacer make(WGPUDevice device, std::uint32_t frames_in_flight = 2);
+
+    // Waits for all submitted frames to complete
+    static void release(FramePacer& pacer);
+
+    // Blocks until fewer than frames_in_flight frames are pending on the GPU. Returns the slot of
+    // the new frame.
+    std::uint32_t begin_frame();
+
+    // Must be called after all of the frame's work has been submitted
+    void end_frame();
+
+    // Slot of the current frame between begin_frame and end_frame
+    std::uint32_t get_slot() const { return get_slot(frames_submitted); }
+    std::uint32_t get_slot(std::uint64_t frame) const
+    {
+        return std::uint32_t(frame % frames_in_flight);
+    }
+    std::uint32_t get_pending_count() const
+    {
+        return std::uint32_t(frames_submitted - frames_completed);
+    }
+
+    void wait_idle() const;
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,61 @@
+#include "wgpu_instance_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wgpu::sandbox
+{
+
+InstanceBuffer InstanceBuffer::make(std::uint32_t const stride)
+{
+    // Vertex buffer strides must be a multiple of 4 bytes
+    assert(stride > 0 && stride % 4 == 0);
+
+    InstanceBuffer result{};
+    result.stride = stride;
+    return result;
+}
+
+void InstanceBuffer::release(InstanceBuffer& instances)
+{
+    if (instances.buffer)
+        wgpuBufferRelease(instances.buffer);
+
+    instances = {};
+}
+
+void InstanceBuffer::push(void const* const src)
+{
+    auto const bytes = static_cast<std::uint8_t const*>(src);
+    data.insert(data.end(), bytes, bytes + stride);
+    ++count;
+}
+
+bool InstanceBuffer::upload(WGPUDevice const device, WGPUQueue const queue)
+{
+    std::uint64_t const size = get_size();
+    bool const is_resized = size > capacity;
+
+    if (is_resized)
+    {
+        if (buffer)
+            wgpuBufferRelease(buffer);
+
+        // Grow geometrically to avoid recreating the buffer every time an instance is added
+        capacity = std::max(size, 2 * capacity);
+
+        WGPUBufferDescriptor const desc{
+            .usage = WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst,
+            .size = capacity,
+        };
+        buffer = wgpuDeviceCreateBuffer(device, &desc);
+        assert(buffer);
+    }
+
+    if (size > 0)
+        wgpuQueueWriteBuffer(queue, buffer, 0, data.data(), size);
+
+    return is_resized;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Builds a vertex buffer of per-instance attributes for use with WGPUVertexStepMode_Instance.
+// Instances are appended on the CPU and written to the GPU in one call. The GPU buffer is
+// recreated with extra room whenever it's too small to hold all instances.
+struct InstanceBuffer
+{
+    WGPUBuffer buffer;
+    std::vector<std::uint8_t> data;
+    std::uint64_t capacity;
+    std::uint32_t stride;
+    std::uint32_t count;
+
+    static InstanceBuffer make(std::uint32_t stride);
+
+    static void release(InstanceBuffer& instances);
+
+    void clear()
+    {
+        data.clear();
+        count = 0;
+    }
+
+    void push(void const* src);
+
+    template <typename T>
+    void push(T const& value)
+    {
+        assert(sizeof(T) == stride);
+        push(static_cast<void const*>(&value));
+    }
+
+    // Writes instances to the GPU. Returns true if the buffer was recreated in which case any
+    // recorded commands that refer to the old one are stale.
+    bool upload(WGPUDevice device, WGPUQueue queue);
+
+    void bind(WGPURenderPassEncoder encoder, std::uint32_t slot) const
+    {
+        wgpuRenderPassEncoderSetVertexBuffer(encoder, slot, buffer, 0, get_size());
+    }
+
+    void bind(WGPURenderBundleEncoder encoder, std::uint32_t slot) const
+    {
+        wgpuRenderBundleEncoderSetVertexBuffer(encoder, slot, buffer, 0, get_size());
+    }
+
+    std::uint64_t get_size() const { return std::uint64_t(count) * stride; }
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,518 @@
+#include "wgpu_ktx2.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <basisu_transcoder.h>
+
+#include "mapped_file.hpp"
+#include "wgpu_mipmaps.hpp"
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr std::uint8_t ktx2_identifier[12]{
+    0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+struct Ktx2Header
+{
+    std::uint8_t identifier[12];
+    std::uint32_t vk_format;
+    std::uint32_t type_size;
+    std::uint32_t pixel_width;
+    std::uint32_t pixel_height;
+    std::uint32_t pixel_depth;
+    std::uint32_t layer_count;
+    std::uint32_t face_count;
+    std::uint32_t level_count;
+    std::uint32_t supercompression_scheme;
+    std::uint32_t dfd_offset;
+    std::uint32_t dfd_size;
+    std::uint32_t kvd_offset;
+    std::uint32_t kvd_size;
+    std::uint64_t sgd_offset;
+    std::uint64_t sgd_size;
+};
+static_assert(sizeof(Ktx2Header) == 80);
+
+// Follows the header, one per mip level
+struct Ktx2Level
+{
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t uncompressed_size;
+};
+
+struct FormatInfo
+{
+    std::uint32_t vk_format;
+    WGPUTextureFormat format;
+    std::uint32_t block_size; // Texels along each side of a block
+    std::uint32_t block_bytes;
+};
+
+constexpr FormatInfo format_infos[]{
+    {37, WGPUTextureFormat_RGBA8Unorm, 1, 4},
+    {43, WGPUTextureFormat_RGBA8UnormSrgb, 1, 4},
+    {133, WGPUTextureFormat_BC1RGBAUnorm, 4, 8},
+    {134, WGPUTextureFormat_BC1RGBAUnormSrgb, 4, 8},
+    {137, WGPUTextureFormat_BC3RGBAUnorm, 4, 16},
+    {138, WGPUTextureFormat_BC3RGBAUnormSrgb, 4, 16},
+    {139, WGPUTextureFormat_BC4RUnorm, 4, 8},
+    {141, WGPUTextureFormat_BC5RGUnorm, 4, 16},
+    {145, WGPUTextureFormat_BC7RGBAUnorm, 4, 16},
+    {146, WGPUTextureFormat_BC7RGBAUnormSrgb, 4, 16},
+    {147, WGPUTextureFormat_ETC2RGB8Unorm, 4, 8},
+    {148, WGPUTextureFormat_ETC2RGB8UnormSrgb, 4, 8},
+    {149, WGPUTextureFormat_ETC2RGB8A1Unorm, 4, 8},
+    {150, WGPUTextureFormat_ETC2RGB8A1UnormSrgb, 4, 8},
+    {151, WGPUTextureFormat_ETC2RGBA8Unorm, 4, 16},
+    {152, WGPUTextureFormat_ETC2RGBA8UnormSrgb, 4, 16},
+    {157, WGPUTextureFormat_ASTC4x4Unorm, 4, 16},
+    {158, WGPUTextureFormat_ASTC4x4UnormSrgb, 4, 16},
+};
+
+FormatInfo const* find_format_info(std::uint32_t const vk_format)
+{
+    for (FormatInfo const& info : format_infos)
+    {
+        if (info.vk_format == vk_format)
+            return &info;
+    }
+
+    return nullptr;
+}
+
+FormatInfo const* find_format_info(WGPUTextureFormat const format)
+{
+    for (FormatInfo const& info : format_infos)
+    {
+        if (info.format == format)
+            return &info;
+    }
+
+    return nullptr;
+}
+
+bool is_supported(WGPUTextureFormat const format, TextureCompressionSupport const& support)
+{
+    if (format >= WGPUTextureFormat_BC1RGBAUnorm && format <= WGPUTextureFormat_BC7RGBAUnormSrgb)
+        return support.bc;
+
+    if (format >= WGPUTextureFormat_ETC2RGB8Unorm && format <= WGPUTextureFormat_EACRG11Snorm)
+        return support.etc2;
+
+    if (format == WGPUTextureFormat_ASTC4x4Unorm || format == WGPUTextureFormat_ASTC4x4UnormSrgb)
+        return support.astc;
+
+    return true;
+}
+
+// Target of a Basis Universal transcode along with the texture formats it's uploaded as
+struct TranscodeTarget
+{
+    basist::transcoder_texture_format basis_format;
+    WGPUTextureFormat format;
+    WGPUTextureFormat srgb_format;
+};
+
+// Picks the best supported transcode target. Block formats need level 0 to be a whole number of
+// blocks so unaligned images fall back to RGBA8.
+TranscodeTarget select_transcode_target(
+    TextureCompressionSupport const& support,
+    std::uint32_t const width,
+    std::uint32_t const height)
+{
+    using basist::transcoder_texture_format;
+
+    if (width % 4 == 0 && height % 4 == 0)
+    {
+        if (support.bc)
+        {
+            return {
+                transcoder_texture_format::cTFBC7_RGBA,
+                WGPUTextureFormat_BC7RGBAUnorm,
+                WGPUTextureFormat_BC7RGBAUnormSrgb};
+        }
+
+        if (support.astc)
+        {
+            return {
+                transcoder_texture_format::cTFASTC_4x4_RGBA,
+                WGPUTextureFormat_ASTC4x4Unorm,
+                WGPUTextureFormat_ASTC4x4UnormSrgb};
+        }
+
+        if (support.etc2)
+        {
+            return {
+                transcoder_texture_format::cTFETC2_RGBA,
+                WGPUTextureFormat_ETC2RGBA8Unorm,
+                WGPUTextureFormat_ETC2RGBA8UnormSrgb};
+        }
+    }
+
+    return {
+        transcoder_texture_format::cTFRGBA32,
+        WGPUTextureFormat_RGBA8Unorm,
+        WGPUTextureFormat_RGBA8UnormSrgb};
+}
+
+void init_transcoder()
+{
+    // Builds lookup tables shared by all transcoders. Only needs to happen once per process.
+    [[maybe_unused]] static bool const is_init = (basist::basisu_transcoder_init(), true);
+}
+
+std::uint64_t get_rgba8_size(
+    std::uint32_t const width,
+    std::uint32_t const height,
+    std::uint32_t const level_count)
+{
+    std::uint64_t result = 0;
+    for (std::uint32_t i = 0; i < level_count; ++i)
+        result += std::uint64_t(std::max(width >> i, 1u)) * std::max(height >> i, 1u) * 4;
+
+    return result;
+}
+
+WGPUTexture make_texture(
+    WGPUDevice const device,
+    WGPUTextureFormat const format,
+    std::uint32_t const width,
+    std::uint32_t const height,
+    std::uint32_t const level_count)
+{
+    // Allow viewing sRGB data without conversion
+    WGPUTextureFormat const view_format = get_linear_view_format(format);
+
+    WGPUTextureDescriptor const desc{
+        .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {width, height, 1},
+        .format = format,
+        .mipLevelCount = level_count,
+        .sampleCount = 1,
+        .viewFormatCount = (view_format != format) ? 1u : 0u,
+        .viewFormats = &view_format,
+    };
+    return wgpuDeviceCreateTexture(device, &desc);
+}
+
+// Size of a mip level stored as tightly packed rows of blocks
+std::uint64_t get_level_size(
+    FormatInfo const& info,
+    std::uint32_t const width,
+    std::uint32_t const height)
+{
+    std::uint64_t const blocks_x = (width + info.block_size - 1) / info.block_size;
+    std::uint64_t const blocks_y = (height + info.block_size - 1) / info.block_size;
+    return blocks_x * blocks_y * info.block_bytes;
+}
+
+// Writes a mip level given as rows of blocks. Compressed levels are copied in whole blocks even
+// where they extend past the edge of the level.
+void write_level(
+    WGPUQueue const queue,
+    WGPUTexture const texture,
+    FormatInfo const& info,
+    std::uint32_t const level,
+    std::uint32_t const width,
+    std::uint32_t const height,
+    void const* const data,
+    std::size_t const size)
+{
+    std::uint32_t const blocks_x = (width + info.block_size - 1) / info.block_size;
+    std::uint32_t const blocks_y = (height + info.block_size - 1) / info.block_size;
+
+    WGPUTexelCopyTextureInfo const dst{
+        .texture = texture,
+        .mipLevel = level,
+    };
+    WGPUTexelCopyBufferLayout const layout{
+        .bytesPerRow = blocks_x * info.block_bytes,
+        .rowsPerImage = blocks_y,
+    };
+    WGPUExtent3D const extent{blocks_x * info.block_size, blocks_y * info.block_size, 1};
+    wgpuQueueWriteTexture(queue, &dst, data, size, &layout, &extent);
+}
+
+WGPUTexture load_direct(
+    WGPUDevice const device,
+    std::uint8_t const* const data,
+    std::size_t const size,
+    Ktx2Header const& header,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo& result)
+{
+    FormatInfo const* const info = find_format_info(header.vk_format);
+    if (!info || !is_supported(info->format, support))
+        return nullptr;
+
+    // NOTE(dr): Zstandard-supercompressed block data would need a separate decoder. Only Basis
+    // Universal payloads are supercompressed in practice.
+    if (header.supercompression_scheme != 0)
+        return nullptr;
+
+    std::uint32_t const width = header.pixel_width;
+    std::uint32_t const height = header.pixel_height;
+    if (width % info->block_size != 0 || height % info->block_size != 0)
+        return nullptr;
+
+    std::uint32_t const level_count = std::max(header.level_count, 1u);
+    if (level_count > get_mip_level_count(width, height)
+        || sizeof(Ktx2Header) + level_count * sizeof(Ktx2Level) > size)
+        return nullptr;
+
+    // Each level must be within the file and hold exactly the blocks its dimensions require since
+    // they're copied to the GPU as is
+    Ktx2Level const* const levels = reinterpret_cast<Ktx2Level const*>(data + sizeof(Ktx2Header));
+    for (std::uint32_t i = 0; i < level_count; ++i)
+    {
+        Ktx2Level const& level = levels[i];
+        std::uint64_t const expected_size =
+            get_level_size(*info, std::max(width >> i, 1u), std::max(height >> i, 1u));
+
+        if (level.size != expected_size || level.offset > size || level.size > size - level.offset)
+            return nullptr;
+    }
+
+    WGPUTexture const texture = make_texture(device, info->format, width, height, level_count);
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+
+    for (std::uint32_t i = 0; i < level_count; ++i)
+    {
+        write_level(
+            queue,
+            texture,
+            *info,
+            i,
+            std::max(width >> i, 1u),
+            std::max(height >> i, 1u),
+            data + levels[i].offset,
+            levels[i].size);
+
+        result.gpu_size += levels[i].size;
+    }
+
+    result.format = info->format;
+    result.width = width;
+    result.height = height;
+    result.level_count = level_count;
+    return texture;
+}
+
+WGPUTexture load_transcoded(
+    WGPUDevice const device,
+    std::uint8_t const* const data,
+    std::size_t const size,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo& result)
+{
+    init_transcoder();
+
+    basist::ktx2_transcoder transcoder{};
+    if (!transcoder.init(data, std::uint32_t(size)) || !transcoder.start_transcoding())
+        return nullptr;
+
+    if (transcoder.get_faces() != 1 || transcoder.get_layers() > 1)
+        return nullptr;
+
+    std::uint32_t const width = transcoder.get_width();
+    std::uint32_t const height = transcoder.get_height();
+    std::uint32_t const level_count = std::max(transcoder.get_levels(), 1u);
+    bool const is_srgb = transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB;
+
+    TranscodeTarget const target = select_transcode_target(support, width, height);
+    WGPUTextureFormat const format = is_srgb ? target.srgb_format : target.format;
+    FormatInfo const* const info = find_format_info(format);
+
+    WGPUTexture const texture = make_texture(device, format, width, height, level_count);
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+    std::vector<std::uint8_t> buffer{};
+
+    for (std::uint32_t i = 0; i < level_count; ++i)
+    {
+        basist::ktx2_image_level_info level{};
+        if (!transcoder.get_image_level_info(level, i, 0, 0))
+        {
+            wgpuTextureRelease(texture);
+            return nullptr;
+        }
+
+        // Uncompressed targets are sized in pixels rather than blocks
+        std::uint32_t const unit_count = (info->block_size == 1)
+                                             ? level.m_orig_width * level.m_orig_height
+                                             : level.m_total_blocks;
+        buffer.resize(std::size_t(unit_count) * info->block_bytes);
+
+        if (!transcoder.transcode_image_level(
+                i,
+                0,
+                0,
+                buffer.data(),
+                unit_count,
+                target.basis_format))
+        {
+            wgpuTextureRelease(texture);
+            return nullptr;
+        }
+
+        write_level(
+            queue,
+            texture,
+            *info,
+            i,
+            level.m_orig_width,
+            level.m_orig_height,
+            buffer.data(),
+            buffer.size());
+
+        result.gpu_size += buffer.size();
+    }
+
+    result.format = format;
+    result.width = width;
+    result.height = height;
+    result.level_count = level_count;
+    result.is_transcoded = true;
+    return texture;
+}
+
+} // namespace
+
+TextureCompressionSupport TextureCompressionSupport::make(WGPUDevice const device)
+{
+    return {
+        .bc = bool(wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionBC)),
+        .etc2 = bool(wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionETC2)),
+        .astc = bool(wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionASTC)),
+    };
+}
+
+std::size_t get_texture_compression_features(WGPUAdapter const adapter, WGPUFeatureName result[3])
+{
+    constexpr WGPUFeatureName features[]{
+        WGPUFeatureName_TextureCompressionBC,
+        WGPUFeatureName_TextureCompressionETC2,
+        WGPUFeatureName_TextureCompressionASTC,
+    };
+
+    std::size_t count = 0;
+    for (WGPUFeatureName const feature : features)
+    {
+        if (wgpuAdapterHasFeature(adapter, feature))
+            result[count++] = feature;
+    }
+
+    return count;
+}
+
+void Ktx2TextureInfo::report(char const* const name) const
+{
+    fmt::println(
+        "{}: {}x{}, {} levels, {}{}",
+        name,
+        width,
+        height,
+        level_count,
+        to_string(format),
+        is_transcoded ? " (transcoded)" : "");
+    fmt::println(
+        "\t{:.1f} KB on GPU, {:.1f} KB saved vs. RGBA8, loaded in {:.2f} ms",
+        gpu_size / 1024.0,
+        (double(rgba8_size) - double(gpu_size)) / 1024.0,
+        load_ms);
+}
+
+WGPUTexture make_texture_from_ktx2(
+    WGPUDevice const device,
+    void const* const data,
+    std::size_t const size,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo* const info)
+{
+    using Clock = std::chrono::steady_clock;
+    auto const t0 = Clock::now();
+
+    auto const bytes = static_cast<std::uint8_t const*>(data);
+    if (size < sizeof(Ktx2Header)
+        || std::memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)) != 0)
+    {
+        return nullptr;
+    }
+
+    Ktx2Header header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1)
+        return nullptr;
+
+    Ktx2TextureInfo result{};
+    WGPUTexture const texture = (header.vk_format == 0)
+                                    ? load_transcoded(device, bytes, size, support, result)
+                                    : load_direct(device, bytes, size, header, support, result);
+
+    if (texture && info)
+    {
+        result.rgba8_size = get_rgba8_size(result.width, result.height, result.level_count);
+        result.load_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        *info = result;
+    }
+
+    return texture;
+}
+
+WGPUTexture make_texture_from_ktx2(
+    WGPUDevice const device,
+    char const* const path,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo* const info)
+{
+    MappedFile file = MappedFile::make(path);
+    if (!file.is_valid())
+        return nullptr;
+
+    file.advise_sequential();
+    WGPUTexture const result = make_texture_from_ktx2(device, file.data, file.size, support, info);
+    MappedFile::release(file);
+
+    return result;
+}
+
+WGPUTextureFormat get_linear_view_format(WGPUTextureFormat const format)
+{
+    switch (format)
+    {
+        case WGPUTextureFormat_RGBA8UnormSrgb:
+            return WGPUTextureFormat_RGBA8Unorm;
+        case WGPUTextureFormat_BGRA8UnormSrgb:
+            return WGPUTextureFormat_BGRA8Unorm;
+        case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            return WGPUTextureFormat_BC1RGBAUnorm;
+        case WGPUTextureFormat_BC2RGBAUnormSrgb:
+            return WGPUTextureFormat_BC2RGBAUnorm;
+        case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            return WGPUTextureFormat_BC3RGBAUnorm;
+        case WGPUTextureFormat_BC7RGBAUnormSrgb:
+            return WGPUTextureFormat_BC7RGBAUnorm;
+        case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+            return WGPUTextureFormat_ETC2RGB8Unorm;
+        case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+            return WGPUTextureFormat_ETC2RGB8A1Unorm;
+        case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+            return WGPUTextureFormat_ETC2RGBA8Unorm;
+        case WGPUTextureFormat_ASTC4x4UnormSrgb:
+            return WGPUTextureFormat_ASTC4x4Unorm;
+        default:
+            return format;
+    }
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Block compressed texture formats that the device can sample from
+struct TextureCompressionSupport
+{
+    bool bc;
+    bool etc2;
+    bool astc;
+
+    static TextureCompressionSupport make(WGPUDevice device);
+};
+
+// Writes the texture compression features supported by the adapter to result so they can be
+// requested when creating a device. Returns the number of features written (at most 3).
+std::size_t get_texture_compression_features(WGPUAdapter adapter, WGPUFeatureName result[3]);
+
+// Describes a texture loaded from a KTX2 file
+struct Ktx2TextureInfo
+{
+    WGPUTextureFormat format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t level_count;
+    std::uint64_t gpu_size; // Bytes uploaded across all levels
+    std::uint64_t rgba8_size; // Bytes the same levels would take as RGBA8
+    bool is_transcoded;
+    double load_ms;
+
+    void report(char const* name) const;
+};
+
+// Creates a 2D texture from a KTX2 file in memory and uploads all of its mip levels.
+//
+// Files holding BC, ETC2 or ASTC 4x4 data (or plain RGBA8) are uploaded as-is, provided the
+// device supports that format. Basis Universal files (ETC1S or UASTC, optionally supercompressed)
+// are transcoded on the CPU to the first format supported of BC7, ASTC 4x4 and ETC2, falling back
+// to RGBA8 if the device has no compressed formats.
+//
+// sRGB files use the matching sRGB format and also allow views with the non-sRGB format (see
+// get_linear_view_format). Cube maps, arrays and Zstandard-supercompressed block formats aren't
+// supported. Returns null if the file can't be loaded.
+WGPUTexture make_texture_from_ktx2(
+    WGPUDevice device,
+    void const* data,
+    std::size_t size,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo* info = nullptr);
+
+WGPUTexture make_texture_from_ktx2(
+    WGPUDevice device,
+    char const* path,
+    TextureCompressionSupport const& support,
+    Ktx2TextureInfo* info = nullptr);
+
+// Returns the non-sRGB counterpart of the given format or the format itself if it has none
+WGPUTextureFormat get_linear_view_format(WGPUTextureFormat format);
+
+} // namespace wgpu::sandbox
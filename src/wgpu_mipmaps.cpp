@@ -0,0 +1,230 @@
+#include "wgpu_mipmaps.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr char const* shader_src = R"(
+override is_srgb: bool = false;
+
+@group(0) @binding(0) var src: texture_2d<f32>;
+@group(0) @binding(1) var dst: texture_storage_2d<rgba8unorm, write>;
+
+fn to_linear(c: vec3f) -> vec3f {
+    return select(pow((c + 0.055) / 1.055, vec3f(2.4)), c / 12.92, c <= vec3f(0.04045));
+}
+
+fn to_srgb(c: vec3f) -> vec3f {
+    return select(1.055 * pow(c, vec3f(1.0 / 2.4)) - 0.055, 12.92 * c, c <= vec3f(0.0031308));
+}
+
+fn load_linear(p: vec2u, src_size: vec2u) -> vec4f {
+    let c = textureLoad(src, min(p, src_size - 1u), 0);
+    if (is_srgb) {
+        return vec4f(to_linear(c.rgb), c.a);
+    }
+    return c;
+}
+
+// Weights of the three source texels starting at 2x along one axis
+fn get_weights(x: u32, src_size: u32, dst_size: u32) -> vec3f {
+    if (src_size == 1u) {
+        return vec3f(1.0, 0.0, 0.0);
+    }
+    if (src_size == 2u * dst_size) {
+        return vec3f(0.5, 0.5, 0.0);
+    }
+    let n = f32(dst_size);
+    let i = f32(x);
+    return vec3f(n - i, n, i + 1.0) / (2.0 * n + 1.0);
+}
+
+@compute @workgroup_size(8, 8)
+fn downsample_main(@builtin(global_invocation_id) id: vec3u) {
+    let dst_size = textureDimensions(dst);
+    if (any(id.xy >= dst_size)) {
+        return;
+    }
+
+    let src_size = textureDimensions(src);
+    let wx = get_weights(id.x, src_size.x, dst_size.x);
+    let wy = get_weights(id.y, src_size.y, dst_size.y);
+
+    var sum = vec4f(0.0);
+    for (var j = 0u; j < 3u; j++) {
+        for (var i = 0u; i < 3u; i++) {
+            let w = wx[i] * wy[j];
+            if (w > 0.0) {
+                sum += w * load_linear(2u * id.xy + vec2u(i, j), src_size);
+            }
+        }
+    }
+
+    if (is_srgb) {
+        sum = vec4f(to_srgb(sum.rgb), sum.a);
+    }
+    textureStore(dst, id.xy, sum);
+}
+)";
+
+WGPUComputePipeline make_pipeline(WGPUDevice const device, bool const is_srgb)
+{
+    WGPUShaderSourceWGSL shader_desc_src{
+        .chain{.sType = WGPUSType_ShaderSourceWGSL},
+        .code{shader_src, WGPU_STRLEN},
+    };
+    WGPUShaderModuleDescriptor const shader_desc{
+        .nextInChain = reinterpret_cast<WGPUChainedStruct*>(&shader_desc_src),
+    };
+    WGPUShaderModule const shader = wgpuDeviceCreateShaderModule(device, &shader_desc);
+    assert(shader);
+
+    WGPUConstantEntry const constant{
+        .key{"is_srgb", WGPU_STRLEN},
+        .value = is_srgb ? 1.0 : 0.0,
+    };
+    WGPUComputePipelineDescriptor const desc{
+        .compute{
+            .module = shader,
+            .entryPoint{"downsample_main", WGPU_STRLEN},
+            .constantCount = 1,
+            .constants = &constant,
+        },
+    };
+    WGPUComputePipeline const result = wgpuDeviceCreateComputePipeline(device, &desc);
+    wgpuShaderModuleRelease(shader);
+
+    return result;
+}
+
+WGPUTextureView make_level_view(WGPUTexture const texture, std::uint32_t const level)
+{
+    WGPUTextureViewDescriptor const desc{
+        .format = WGPUTextureFormat_RGBA8Unorm,
+        .dimension = WGPUTextureViewDimension_2D,
+        .baseMipLevel = level,
+        .mipLevelCount = 1,
+        .arrayLayerCount = 1,
+    };
+    return wgpuTextureCreateView(texture, &desc);
+}
+
+} // namespace
+
+std::uint32_t get_mip_level_count(std::uint32_t const width, std::uint32_t const height)
+{
+    std::uint32_t size = std::max(width, height);
+    std::uint32_t result = 1;
+
+    while (size > 1)
+    {
+        size >>= 1;
+        ++result;
+    }
+
+    return result;
+}
+
+MipmapGenerator MipmapGenerator::make(WGPUDevice const device)
+{
+    MipmapGenerator result{};
+    result.pipelines[0] = make_pipeline(device, false);
+    result.pipelines[1] = make_pipeline(device, true);
+    assert(result.pipelines[0] && result.pipelines[1]);
+    return result;
+}
+
+void MipmapGenerator::release(MipmapGenerator& generator)
+{
+    for (WGPUComputePipeline const pipeline : generator.pipelines)
+        wgpuComputePipelineRelease(pipeline);
+
+    generator = {};
+}
+
+void MipmapGenerator::generate(
+    WGPUDevice const device,
+    WGPUCommandEncoder const encoder,
+    WGPUTexture const* const textures,
+    std::size_t const texture_count,
+    bool const is_srgb) const
+{
+    WGPUComputePipeline const pipeline = pipelines[is_srgb];
+    WGPUBindGroupLayout const layout = wgpuComputePipelineGetBindGroupLayout(pipeline, 0);
+
+    WGPUComputePassEncoder const pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
+    wgpuComputePassEncoderSetPipeline(pass, pipeline);
+
+    // Dispatches within a pass are synchronized with each other so each level can read the one
+    // written before it
+    for (std::size_t i = 0; i < texture_count; ++i)
+    {
+        WGPUTexture const texture = textures[i];
+        assert(wgpuTextureGetFormat(texture) == WGPUTextureFormat_RGBA8Unorm);
+        assert((wgpuTextureGetUsage(texture) & mipmap_texture_usage) == mipmap_texture_usage);
+
+        std::uint32_t const level_count = wgpuTextureGetMipLevelCount(texture);
+        std::uint32_t width = wgpuTextureGetWidth(texture);
+        std::uint32_t height = wgpuTextureGetHeight(texture);
+        WGPUTextureView src_view = make_level_view(texture, 0);
+
+        for (std::uint32_t level = 1; level < level_count; ++level)
+        {
+            width = std::max(width >> 1, 1u);
+            height = std::max(height >> 1, 1u);
+            WGPUTextureView const dst_view = make_level_view(texture, level);
+
+            WGPUBindGroupEntry const entries[]{
+                {.binding = 0, .textureView = src_view},
+                {.binding = 1, .textureView = dst_view},
+            };
+            WGPUBindGroupDescriptor const desc{
+                .layout = layout,
+                .entryCount = sizeof(entries) / sizeof(entries[0]),
+                .entries = entries,
+            };
+            WGPUBindGroup const bind_group = wgpuDeviceCreateBindGroup(device, &desc);
+            assert(bind_group);
+
+            wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, nullptr);
+            wgpuComputePassEncoderDispatchWorkgroups(
+                pass,
+                (width + workgroup_size - 1) / workgroup_size,
+                (height + workgroup_size - 1) / workgroup_size,
+                1);
+
+            // NOTE(dr): Recorded commands keep their resources alive so these can be released
+            // before the encoder is submitted
+            wgpuBindGroupRelease(bind_group);
+            wgpuTextureViewRelease(src_view);
+            src_view = dst_view;
+        }
+
+        wgpuTextureViewRelease(src_view);
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    wgpuBindGroupLayoutRelease(layout);
+}
+
+void MipmapGenerator::generate(
+    WGPUDevice const device,
+    WGPUTexture const* const textures,
+    std::size_t const texture_count,
+    bool const is_srgb) const
+{
+    WGPUCommandEncoder const encoder = wgpuDeviceCreateCommandEncoder(device, nullptr);
+    generate(device, encoder, textures, texture_count, is_srgb);
+
+    WGPUCommandBuffer const cmds = wgpuCommandEncoderFinish(encoder, nullptr);
+    wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &cmds);
+    wgpuCommandBufferRelease(cmds);
+    wgpuCommandEncoderRelease(encoder);
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Usage required by textures passed to MipmapGenerator
+constexpr WGPUTextureUsage mipmap_texture_usage =
+    WGPUTextureUsage_TextureBinding | WGPUTextureUsage_StorageBinding;
+
+// Returns the number of levels in a full mip chain for the given size
+std::uint32_t get_mip_level_count(std::uint32_t width, std::uint32_t height);
+
+// Fills the mip chain of RGBA8Unorm textures on the GPU. Each level is downsampled from the one
+// above it with a box filter in a compute dispatch. When a source dimension is odd, each
+// destination texel covers three source texels with weights proportional to their overlap so
+// that non-power-of-two textures don't shift or drop texels.
+//
+// With is_srgb set, texels are treated as sRGB encoded: they're converted to linear before
+// filtering and back afterwards. Storage textures can't use sRGB formats so this is done in the
+// shader rather than through an sRGB view.
+struct MipmapGenerator
+{
+    static constexpr std::uint32_t workgroup_size = 8;
+
+    WGPUComputePipeline pipelines[2]; // Linear, sRGB
+
+    static MipmapGenerator make(WGPUDevice device);
+
+    static void release(MipmapGenerator& generator);
+
+    // Records a compute pass that generates levels 1 and up of each texture from level 0. Level 0
+    // must already be written, e.g. with wgpuQueueWriteTexture before the encoder is submitted.
+    // Textures must be RGBA8Unorm with mipmap_texture_usage.
+    void generate(
+        WGPUDevice device,
+        WGPUCommandEncoder encoder,
+        WGPUTexture const* textures,
+        std::size_t texture_count,
+        bool is_srgb) const;
+
+    // Generates mips for a batch of textures in a single submission
+    void generate(
+        WGPUDevice device,
+        WGPUTexture const* textures,
+        std::size_t texture_count,
+        bool is_srgb) const;
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,231 @@
+#include "wgpu_offscreen.hpp"
+
+#include <cassert>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+WGPUTexture make_texture(
+    WGPUDevice const device,
+    std::uint32_t const width,
+    std::uint32_t const height,
+    WGPUTextureFormat const format,
+    WGPUTextureUsage const usage)
+{
+    WGPUTextureDescriptor const desc{
+        .usage = usage,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {width, height, 1},
+        .format = format,
+        .mipLevelCount = 1,
+        .sampleCount = 1,
+    };
+    return wgpuDeviceCreateTexture(device, &desc);
+}
+
+WGPUTextureView make_view(WGPUTexture const texture)
+{
+    WGPUTextureViewDescriptor const desc{
+        .format = wgpuTextureGetFormat(texture),
+        .dimension = WGPUTextureViewDimension_2D,
+        .mipLevelCount = 1,
+        .arrayLayerCount = 1,
+    };
+    return wgpuTextureCreateView(texture, &desc);
+}
+
+} // namespace
+
+OffscreenTarget OffscreenTarget::make(
+    WGPUDevice const device,
+    std::uint32_t const width,
+    std::uint32_t const height,
+    WGPUTextureFormat const color_format,
+    WGPUTextureFormat const depth_format)
+{
+    OffscreenTarget result{};
+
+    result.color = make_texture(
+        device,
+        width,
+        height,
+        color_format,
+        WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc
+            | WGPUTextureUsage_TextureBinding);
+    assert(result.color);
+
+    result.color_view = make_view(result.color);
+    assert(result.color_view);
+
+    if (depth_format != WGPUTextureFormat_Undefined)
+    {
+        result.depth = make_texture(
+            device,
+            width,
+            height,
+            depth_format,
+            WGPUTextureUsage_RenderAttachment);
+        assert(result.depth);
+
+        result.depth_view = make_view(result.depth);
+        assert(result.depth_view);
+    }
+
+    return result;
+}
+
+void OffscreenTarget::release(OffscreenTarget& target)
+{
+    if (target.depth)
+    {
+        wgpuTextureViewRelease(target.depth_view);
+        wgpuTextureRelease(target.depth);
+    }
+
+    wgpuTextureViewRelease(target.color_view);
+    wgpuTextureRelease(target.color);
+
+    target = {};
+}
+
+void OffscreenTarget::resize(
+    WGPUDevice const device,
+    std::uint32_t const width,
+    std::uint32_t const height)
+{
+    WGPUTextureFormat const color_format = wgpuTextureGetFormat(color);
+    WGPUTextureFormat const depth_format = depth ? wgpuTextureGetFormat(depth)
+                                                 : WGPUTextureFormat_Undefined;
+    release(*this);
+    *this = make(device, width, height, color_format, depth_format);
+}
+
+std::uint32_t OffscreenTarget::width() const { return wgpuTextureGetWidth(color); }
+
+std::uint32_t OffscreenTarget::height() const { return wgpuTextureGetHeight(color); }
+
+FrameReadback FrameReadback::make(
+    WGPUDevice const device,
+    std::uint32_t const width,
+    std::uint32_t const height,
+    WGPUTextureFormat const format,
+    std::size_t const slot_count)
+{
+    FrameReadback result{};
+    result.width = width;
+    result.height = height;
+    result.bytes_per_row =
+        std::uint32_t(align_up(width * get_texel_size(format), copy_row_alignment));
+    result.ring = ReadbackRing::make(
+        device,
+        slot_count,
+        std::uint64_t{result.bytes_per_row} * height);
+
+    return result;
+}
+
+void FrameReadback::release(FrameReadback& readback)
+{
+    ReadbackRing::release(readback.ring);
+    readback = {};
+}
+
+bool FrameReadback::has_free_slot() const { return ring.has_free_slot(); }
+
+bool FrameReadback::enqueue(WGPUCommandEncoder const encoder, WGPUTexture const texture)
+{
+    assert(wgpuTextureGetWidth(texture) == width);
+    assert(wgpuTextureGetHeight(texture) == height);
+
+    WGPUTexelCopyTextureInfo const src{
+        .texture = texture,
+        .aspect = WGPUTextureAspect_All,
+    };
+    ReadbackRing::Handle const handle = ring.enqueue(
+        encoder,
+        src,
+        {width, height, 1},
+        bytes_per_row);
+
+    if (!handle.is_valid())
+        return false;
+
+    pending.push_back({handle, frame_count++});
+    return true;
+}
+
+void FrameReadback::submit() { ring.submit(); }
+
+std::size_t FrameReadback::drain(Callback* const callback, void* const userdata)
+{
+    std::size_t count = 0;
+
+    while (!pending.empty() && ring.is_ready(pending.front().handle))
+    {
+        Pending const& front = pending.front();
+
+        if (callback)
+        {
+            Frame const frame{
+                .data = ring.get_data(front.handle),
+                .width = width,
+                .height = height,
+                .bytes_per_row = bytes_per_row,
+                .index = front.frame_index,
+            };
+            callback(frame, userdata);
+        }
+
+        ring.recycle(front.handle);
+        pending.pop_front();
+        ++count;
+    }
+
+    return count;
+}
+
+std::size_t FrameReadback::wait_and_drain(Callback* const callback, void* const userdata)
+{
+    if (pending.empty())
+        return 0;
+
+    ring.wait(pending.front().handle);
+    return drain(callback, userdata);
+}
+
+void FrameReadback::flush(Callback* const callback, void* const userdata)
+{
+    submit();
+
+    while (!pending.empty())
+        wait_and_drain(callback, userdata);
+}
+
+std::size_t FrameReadback::pending_count() const { return pending.size(); }
+
+std::uint32_t get_texel_size(WGPUTextureFormat const format)
+{
+    switch (format)
+    {
+        case WGPUTextureFormat_R8Unorm:
+            return 1;
+        case WGPUTextureFormat_R32Float:
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_RGBA8UnormSrgb:
+        case WGPUTextureFormat_BGRA8Unorm:
+        case WGPUTextureFormat_BGRA8UnormSrgb:
+        case WGPUTextureFormat_Depth32Float:
+            return 4;
+        case WGPUTextureFormat_RGBA16Float:
+            return 8;
+        default:
+            assert(!"Unsupported texture format");
+            return 0;
+    }
+}
+
+} // namespace wgpu::sandbox
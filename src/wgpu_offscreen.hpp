@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+
+#include <webgpu/webgpu.h>
+
+#include "wgpu_readback.hpp"
+
+namespace wgpu::sandbox
+{
+
+struct OffscreenTarget
+{
+    WGPUTexture color;
+    WGPUTextureView color_view;
+    WGPUTexture depth;
+    WGPUTextureView depth_view;
+
+    static OffscreenTarget make(
+        WGPUDevice device,
+        std::uint32_t width,
+        std::uint32_t height,
+        WGPUTextureFormat color_format,
+        WGPUTextureFormat depth_format = WGPUTextureFormat_Undefined);
+
+    static void release(OffscreenTarget& target);
+
+    void resize(WGPUDevice device, std::uint32_t width, std::uint32_t height);
+
+    std::uint32_t width() const;
+    std::uint32_t height() const;
+};
+
+struct FrameReadback
+{
+    struct Frame
+    {
+        std::span<std::uint8_t const> data; // Empty if the frame couldn't be read back
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t bytes_per_row;
+        std::uint64_t index;
+    };
+
+    using Callback = void(Frame const& frame, void* userdata);
+
+    struct Pending
+    {
+        ReadbackRing::Handle handle;
+        std::uint64_t frame_index;
+    };
+
+    ReadbackRing ring;
+    std::deque<Pending> pending;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t bytes_per_row;
+    std::uint64_t frame_count;
+
+    static FrameReadback make(
+        WGPUDevice device,
+        std::uint32_t width,
+        std::uint32_t height,
+        WGPUTextureFormat format,
+        std::size_t slot_count = 3);
+
+    static void release(FrameReadback& readback);
+
+    // Returns true if a copy can be recorded without waiting on a previous frame
+    bool has_free_slot() const;
+
+    // Records a copy of the given texture into the next free slot. Returns false if no slot is
+    // free, in which case pending frames need to be drained first.
+    bool enqueue(WGPUCommandEncoder encoder, WGPUTexture texture);
+
+    // Requests mapping of all slots recorded since the last call. Must be called after the
+    // command buffer containing the recorded copies has been submitted.
+    void submit();
+
+    // Passes any frames that have finished mapping to the given callback in submission order and
+    // returns their slots to the ring. Returns the number of frames drained.
+    std::size_t drain(Callback* callback, void* userdata);
+
+    // Blocks until the oldest pending frame is ready, then drains it along with any others that
+    // are ready
+    std::size_t wait_and_drain(Callback* callback, void* userdata);
+
+    // Blocks until all submitted frames have been drained
+    void flush(Callback* callback, void* userdata);
+
+    std::size_t pending_count() const;
+};
+
+std::uint32_t get_texel_size(WGPUTextureFormat format);
+
+} // namespace wgpu::sandbox
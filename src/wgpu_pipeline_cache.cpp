@@ -0,0 +1,347 @@
+#include "wgpu_pipeline_cache.hpp"
+
+#include <cassert>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/core.h>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+double get_elapsed_ms(Deadline::Clock::time_point const start)
+{
+    using Ms = std::chrono::duration<double, std::milli>;
+    return Ms(Deadline::Clock::now() - start).count();
+}
+
+std::string_view to_string_view(WGPUStringView const src)
+{
+    // Null data is an empty string (e.g. WGPU_STRING_VIEW_INIT for an omitted entry point)
+    if (!src.data)
+        return {};
+
+    return (src.length == WGPU_STRLEN) ? std::string_view{src.data}
+                                       : std::string_view{src.data, src.length};
+}
+
+// Appends the state a cached object is looked up by to a byte string. Entries compare the full key
+// on a hit so distinct states can't collide.
+struct KeyWriter
+{
+    std::string* dst;
+
+    void add_bytes(void const* const src, std::size_t const size)
+    {
+        dst->append(static_cast<char const*>(src), size);
+    }
+
+    template <typename T>
+    void add(T const& src)
+    {
+        static_assert(std::is_scalar_v<T>);
+        add_bytes(&src, sizeof(T));
+    }
+
+    void add(WGPUStringView const src)
+    {
+        std::string_view const str = to_string_view(src);
+        add(str.size());
+        add_bytes(str.data(), str.size());
+    }
+};
+
+void add_constants(
+    KeyWriter& writer,
+    WGPUConstantEntry const* const constants,
+    std::size_t const count)
+{
+    writer.add(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        writer.add(constants[i].key);
+        writer.add(constants[i].value);
+    }
+}
+
+void add_stencil_face(KeyWriter& writer, WGPUStencilFaceState const& state)
+{
+    writer.add(state.compare);
+    writer.add(state.failOp);
+    writer.add(state.depthFailOp);
+    writer.add(state.passOp);
+}
+
+void add_blend_component(KeyWriter& writer, WGPUBlendComponent const& comp)
+{
+    writer.add(comp.operation);
+    writer.add(comp.srcFactor);
+    writer.add(comp.dstFactor);
+}
+
+template <typename Handle>
+void add_keyed_refs(PipelineCache::PipelineEntry<Handle> const& entry)
+{
+    if (entry.layout)
+        wgpuPipelineLayoutAddRef(entry.layout);
+
+    for (WGPUShaderModule const module : entry.modules)
+    {
+        if (module)
+            wgpuShaderModuleAddRef(module);
+    }
+}
+
+template <typename Handle>
+void release_keyed_refs(PipelineCache::PipelineEntry<Handle> const& entry)
+{
+    if (entry.layout)
+        wgpuPipelineLayoutRelease(entry.layout);
+
+    for (WGPUShaderModule const module : entry.modules)
+    {
+        if (module)
+            wgpuShaderModuleRelease(module);
+    }
+}
+
+} // namespace
+
+PipelineCache PipelineCache::make(WGPUDevice const device)
+{
+    PipelineCache result{};
+    result.device = device;
+    return result;
+}
+
+void PipelineCache::release(PipelineCache& cache)
+{
+    for (auto& [key, entry] : cache.modules)
+        wgpuShaderModuleRelease(entry.handle);
+
+    for (auto& [key, entry] : cache.render_pipelines)
+    {
+        wgpuRenderPipelineRelease(entry.handle);
+        release_keyed_refs(entry);
+    }
+
+    for (auto& [key, entry] : cache.compute_pipelines)
+    {
+        wgpuComputePipelineRelease(entry.handle);
+        release_keyed_refs(entry);
+    }
+
+    cache = {};
+}
+
+WGPUShaderModule PipelineCache::get_shader_module(WGPUStringView const wgsl_src)
+{
+    scratch.assign(to_string_view(wgsl_src));
+
+    auto const it = modules.find(scratch);
+    if (it != modules.end())
+    {
+        ++stats.module_hits;
+        stats.est_saved_ms += it->second.create_ms;
+        wgpuShaderModuleAddRef(it->second.handle);
+        return it->second.handle;
+    }
+
+    auto const start = Deadline::Clock::now();
+
+    WGPUShaderSourceWGSL src_desc{
+        .chain = {.sType = WGPUSType_ShaderSourceWGSL},
+        .code = wgsl_src,
+    };
+    WGPUShaderModuleDescriptor const desc{
+        .nextInChain = reinterpret_cast<WGPUChainedStruct*>(&src_desc),
+    };
+    WGPUShaderModule const module = wgpuDeviceCreateShaderModule(device, &desc);
+    assert(module);
+
+    double const create_ms = get_elapsed_ms(start);
+    ++stats.module_misses;
+    stats.create_ms += create_ms;
+
+    modules.emplace(scratch, ModuleEntry{module, create_ms});
+
+    wgpuShaderModuleAddRef(module);
+    return module;
+}
+
+WGPURenderPipeline PipelineCache::get_render_pipeline(WGPURenderPipelineDescriptor const& desc)
+{
+    scratch.clear();
+    KeyWriter writer{&scratch};
+    writer.add(desc.layout);
+
+    // Vertex state
+    {
+        auto const& vert = desc.vertex;
+        writer.add(vert.module);
+        writer.add(vert.entryPoint);
+        add_constants(writer, vert.constants, vert.constantCount);
+
+        writer.add(vert.bufferCount);
+        for (std::size_t i = 0; i < vert.bufferCount; ++i)
+        {
+            auto const& buf = vert.buffers[i];
+            writer.add(buf.stepMode);
+            writer.add(buf.arrayStride);
+            writer.add(buf.attributeCount);
+
+            for (std::size_t j = 0; j < buf.attributeCount; ++j)
+            {
+                auto const& attr = buf.attributes[j];
+                writer.add(attr.format);
+                writer.add(attr.offset);
+                writer.add(attr.shaderLocation);
+            }
+        }
+    }
+
+    // Primitive state
+    {
+        auto const& prim = desc.primitive;
+        writer.add(prim.topology);
+        writer.add(prim.stripIndexFormat);
+        writer.add(prim.frontFace);
+        writer.add(prim.cullMode);
+        writer.add(prim.unclippedDepth);
+    }
+
+    // Depth stencil state
+    writer.add(desc.depthStencil != nullptr);
+    if (desc.depthStencil)
+    {
+        auto const& ds = *desc.depthStencil;
+        writer.add(ds.format);
+        writer.add(ds.depthWriteEnabled);
+        writer.add(ds.depthCompare);
+        add_stencil_face(writer, ds.stencilFront);
+        add_stencil_face(writer, ds.stencilBack);
+        writer.add(ds.stencilReadMask);
+        writer.add(ds.stencilWriteMask);
+        writer.add(ds.depthBias);
+        writer.add(ds.depthBiasSlopeScale);
+        writer.add(ds.depthBiasClamp);
+    }
+
+    // Multisample state
+    {
+        auto const& ms = desc.multisample;
+        writer.add(ms.count);
+        writer.add(ms.mask);
+        writer.add(ms.alphaToCoverageEnabled);
+    }
+
+    // Fragment state
+    writer.add(desc.fragment != nullptr);
+    if (desc.fragment)
+    {
+        auto const& frag = *desc.fragment;
+        writer.add(frag.module);
+        writer.add(frag.entryPoint);
+        add_constants(writer, frag.constants, frag.constantCount);
+
+        writer.add(frag.targetCount);
+        for (std::size_t i = 0; i < frag.targetCount; ++i)
+        {
+            auto const& targ = frag.targets[i];
+            writer.add(targ.format);
+            writer.add(targ.writeMask);
+
+            writer.add(targ.blend != nullptr);
+            if (targ.blend)
+            {
+                add_blend_component(writer, targ.blend->color);
+                add_blend_component(writer, targ.blend->alpha);
+            }
+        }
+    }
+
+    auto const it = render_pipelines.find(scratch);
+    if (it != render_pipelines.end())
+    {
+        ++stats.pipeline_hits;
+        stats.est_saved_ms += it->second.create_ms;
+        wgpuRenderPipelineAddRef(it->second.handle);
+        return it->second.handle;
+    }
+
+    auto const start = Deadline::Clock::now();
+    WGPURenderPipeline const pipeline = wgpuDeviceCreateRenderPipeline(device, &desc);
+    assert(pipeline);
+
+    double const create_ms = get_elapsed_ms(start);
+    ++stats.pipeline_misses;
+    stats.create_ms += create_ms;
+
+    PipelineEntry<WGPURenderPipeline> const entry{
+        pipeline,
+        desc.layout,
+        {desc.vertex.module, desc.fragment ? desc.fragment->module : nullptr},
+        create_ms,
+    };
+    add_keyed_refs(entry);
+    render_pipelines.emplace(scratch, entry);
+
+    wgpuRenderPipelineAddRef(pipeline);
+    return pipeline;
+}
+
+WGPUComputePipeline PipelineCache::get_compute_pipeline(WGPUComputePipelineDescriptor const& desc)
+{
+    scratch.clear();
+    KeyWriter writer{&scratch};
+    writer.add(desc.layout);
+    writer.add(desc.compute.module);
+    writer.add(desc.compute.entryPoint);
+    add_constants(writer, desc.compute.constants, desc.compute.constantCount);
+
+    auto const it = compute_pipelines.find(scratch);
+    if (it != compute_pipelines.end())
+    {
+        ++stats.pipeline_hits;
+        stats.est_saved_ms += it->second.create_ms;
+        wgpuComputePipelineAddRef(it->second.handle);
+        return it->second.handle;
+    }
+
+    auto const start = Deadline::Clock::now();
+    WGPUComputePipeline const pipeline = wgpuDeviceCreateComputePipeline(device, &desc);
+    assert(pipeline);
+
+    double const create_ms = get_elapsed_ms(start);
+    ++stats.pipeline_misses;
+    stats.create_ms += create_ms;
+
+    PipelineEntry<WGPUComputePipeline> const entry{
+        pipeline,
+        desc.layout,
+        {desc.compute.module, nullptr},
+        create_ms,
+    };
+    add_keyed_refs(entry);
+    compute_pipelines.emplace(scratch, entry);
+
+    wgpuComputePipelineAddRef(pipeline);
+    return pipeline;
+}
+
+void PipelineCache::report() const
+{
+    fmt::println("Pipeline cache:");
+    fmt::println("\tshader modules: {} hits, {} misses", stats.module_hits, stats.module_misses);
+    fmt::println("\tpipelines: {} hits, {} misses", stats.pipeline_hits, stats.pipeline_misses);
+    fmt::println(
+        "\tcreate time: {:.2f} ms (est. {:.2f} ms saved)",
+        stats.create_ms,
+        stats.est_saved_ms);
+}
+
+} // namespace wgpu::sandbox
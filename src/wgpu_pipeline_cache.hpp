@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Deduplicates shader modules and pipelines created from identical sources and descriptors.
+// Shader modules are keyed by their source. Pipelines are keyed by their full descriptor state
+// where the layout and shader modules are identified by handle. Each pipeline entry holds a
+// reference to the layout and modules in its key so their handles can't be reused by other
+// objects while the entry exists.
+//
+// All objects returned by the cache are new references which must be released by the caller as
+// if they had been created directly.
+struct PipelineCache
+{
+    struct ModuleEntry
+    {
+        WGPUShaderModule handle;
+        double create_ms;
+    };
+
+    template <typename Handle>
+    struct PipelineEntry
+    {
+        Handle handle;
+        WGPUPipelineLayout layout; // Null if the pipeline uses an auto layout
+        WGPUShaderModule modules[2]; // Null if the stage isn't used
+        double create_ms;
+    };
+
+    struct Stats
+    {
+        std::uint32_t module_hits;
+        std::uint32_t module_misses;
+        std::uint32_t pipeline_hits;
+        std::uint32_t pipeline_misses;
+        double create_ms;
+        double est_saved_ms; // Creation time of cached objects summed over hits
+    };
+
+    WGPUDevice device;
+    std::unordered_map<std::string, ModuleEntry> modules;
+    std::unordered_map<std::string, PipelineEntry<WGPURenderPipeline>> render_pipelines;
+    std::unordered_map<std::string, PipelineEntry<WGPUComputePipeline>> compute_pipelines;
+    std::string scratch; // Reused between lookups to avoid allocating a key per call
+    Stats stats;
+
+    static PipelineCache make(WGPUDevice device);
+
+    static void release(PipelineCache& cache);
+
+    WGPUShaderModule get_shader_module(WGPUStringView wgsl_src);
+
+    WGPURenderPipeline get_render_pipeline(WGPURenderPipelineDescriptor const& desc);
+
+    WGPUComputePipeline get_compute_pipeline(WGPUComputePipelineDescriptor const& desc);
+
+    void report() const;
+};
+
+} // namespace wgpu::sandbox
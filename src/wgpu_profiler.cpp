@@ -0,0 +1,200 @@
+#include "wgpu_profiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+float get_elapsed_ms(Deadline::Clock::time_point const start)
+{
+    using Ms = std::chrono::duration<float, std::milli>;
+    return Ms(Deadline::Clock::now() - start).count();
+}
+
+} // namespace
+
+void GpuProfiler::Samples::push(float const value)
+{
+    values[head] = value;
+    head = (head + 1) % history_size;
+    count = std::min(count + 1, history_size);
+}
+
+float GpuProfiler::Samples::get_average() const
+{
+    if (count == 0)
+        return 0.0f;
+
+    float sum = 0.0f;
+    for (std::uint32_t i = 0; i < count; ++i)
+        sum += values[i];
+
+    return sum / count;
+}
+
+float GpuProfiler::Samples::get_latest() const
+{
+    return (count > 0) ? values[(head + history_size - 1) % history_size] : 0.0f;
+}
+
+GpuProfiler GpuProfiler::make(
+    WGPUDevice const device,
+    std::uint32_t const max_scope_count,
+    std::uint32_t const frame_lag)
+{
+    assert(max_scope_count > 0);
+    assert(frame_lag > 0);
+
+    GpuProfiler result{};
+    result.max_scope_count = max_scope_count;
+    result.has_timestamps = wgpuDeviceHasFeature(device, WGPUFeatureName_TimestampQuery);
+
+    // Fall back to CPU timing only if timestamps aren't supported
+    if (!result.has_timestamps)
+        return result;
+
+    std::uint32_t const query_count = max_scope_count * 2;
+    std::uint64_t const resolve_size = query_count * sizeof(std::uint64_t);
+
+    WGPUQuerySetDescriptor const query_desc{
+        .type = WGPUQueryType_Timestamp,
+        .count = query_count,
+    };
+    result.query_set = wgpuDeviceCreateQuerySet(device, &query_desc);
+    assert(result.query_set);
+
+    WGPUBufferDescriptor const buf_desc{
+        .usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc,
+        .size = resolve_size,
+    };
+    result.resolve_buffer = wgpuDeviceCreateBuffer(device, &buf_desc);
+    assert(result.resolve_buffer);
+
+    result.readback = ReadbackRing::make(device, frame_lag, resolve_size);
+
+    result.timestamp_writes.resize(max_scope_count);
+    for (std::uint32_t i = 0; i < max_scope_count; ++i)
+    {
+        result.timestamp_writes[i] = {
+            .querySet = result.query_set,
+            .beginningOfPassWriteIndex = i * 2,
+            .endOfPassWriteIndex = i * 2 + 1,
+        };
+    }
+
+    return result;
+}
+
+void GpuProfiler::release(GpuProfiler& profiler)
+{
+    if (profiler.has_timestamps)
+    {
+        // Readbacks still in flight refer to the ring so wait for them before releasing it
+        for (Frame const& frame : profiler.frames)
+            profiler.readback.wait(frame.readback);
+
+        ReadbackRing::release(profiler.readback);
+        wgpuBufferRelease(profiler.resolve_buffer);
+        wgpuQuerySetRelease(profiler.query_set);
+    }
+
+    profiler = {};
+}
+
+void GpuProfiler::begin_frame()
+{
+    assert(scopes.empty());
+
+    // Collect timestamps from frames that have been read back, oldest first
+    while (!frames.empty() && readback.is_ready(frames.front().readback))
+    {
+        Frame const& frame = frames.front();
+        std::span<std::uint8_t const> const data = readback.get_data(frame.readback);
+
+        // Timings are dropped for the frame if its timestamps couldn't be read back
+        for (std::size_t i = 0; i < frame.timings.size() && !data.empty(); ++i)
+        {
+            std::uint64_t ticks[2];
+            std::memcpy(ticks, data.data() + i * sizeof(ticks), sizeof(ticks));
+
+            // NOTE(dr): Timestamps are in nanoseconds as per the WebGPU spec. They aren't
+            // guaranteed to be monotonic so negative durations are clamped.
+            std::uint64_t const dt = (ticks[1] > ticks[0]) ? ticks[1] - ticks[0] : 0;
+            timings[frame.timings[i]].gpu_ms.push(float(dt * 1.0e-6));
+        }
+
+        readback.recycle(frame.readback);
+        frames.pop_front();
+    }
+
+    // Only time passes on the GPU this frame if there's somewhere to read the results back to
+    is_frame_timed = has_timestamps && readback.has_free_slot();
+}
+
+WGPUPassTimestampWrites const* GpuProfiler::begin_pass(char const* const name)
+{
+    assert(scopes.size() < max_scope_count);
+
+    std::size_t const index = scopes.size();
+    scopes.push_back({get_timing(name), Deadline::Clock::now()});
+
+    return is_frame_timed ? &timestamp_writes[index] : nullptr;
+}
+
+void GpuProfiler::end_pass()
+{
+    assert(!scopes.empty());
+    Scope const& scope = scopes.back();
+    timings[scope.timing].cpu_ms.push(get_elapsed_ms(scope.cpu_start));
+}
+
+void GpuProfiler::end_frame(WGPUCommandEncoder const encoder)
+{
+    if (is_frame_timed && !scopes.empty())
+    {
+        std::uint32_t const query_count = std::uint32_t(scopes.size() * 2);
+        wgpuCommandEncoderResolveQuerySet(encoder, query_set, 0, query_count, resolve_buffer, 0);
+
+        Frame& frame = frames.emplace_back();
+        frame.readback = readback.enqueue(
+            encoder,
+            resolve_buffer,
+            0,
+            query_count * sizeof(std::uint64_t));
+        assert(frame.readback.is_valid());
+
+        for (Scope const& scope : scopes)
+            frame.timings.push_back(scope.timing);
+    }
+
+    scopes.clear();
+}
+
+void GpuProfiler::submit()
+{
+    if (has_timestamps)
+        readback.submit();
+}
+
+GpuProfiler::Timing const* GpuProfiler::find(char const* const name) const
+{
+    auto const it = std::find_if(timings.begin(), timings.end(), [&](Timing const& timing) {
+        return timing.name == name;
+    });
+    return (it != timings.end()) ? &*it : nullptr;
+}
+
+std::uint32_t GpuProfiler::get_timing(char const* const name)
+{
+    if (Timing const* const timing = find(name))
+        return std::uint32_t(timing - timings.data());
+
+    timings.push_back({.name = name});
+    return std::uint32_t(timings.size() - 1);
+}
+
+} // namespace wgpu::sandbox
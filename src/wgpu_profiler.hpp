@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+#include "wgpu_readback.hpp"
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Measures time spent in named render and compute passes. When the device supports timestamp
+// queries, each pass writes GPU timestamps which are resolved at the end of the frame and read
+// back a few frames later without stalling the queue. CPU time spent encoding each pass is
+// always measured so there's something to show when timestamps aren't available.
+struct GpuProfiler
+{
+    static constexpr std::uint32_t history_size = 64;
+
+    // Rolling window of recent samples
+    struct Samples
+    {
+        float values[history_size];
+        std::uint32_t head;
+        std::uint32_t count;
+
+        void push(float value);
+        float get_average() const;
+        float get_latest() const;
+    };
+
+    struct Timing
+    {
+        std::string name;
+        Samples gpu_ms;
+        Samples cpu_ms;
+    };
+
+    struct Scope
+    {
+        std::uint32_t timing;
+        Deadline::Clock::time_point cpu_start;
+    };
+
+    struct Frame
+    {
+        ReadbackRing::Handle readback;
+        std::vector<std::uint32_t> timings;
+    };
+
+    WGPUQuerySet query_set;
+    WGPUBuffer resolve_buffer;
+    ReadbackRing readback;
+    std::vector<WGPUPassTimestampWrites> timestamp_writes;
+    std::vector<Timing> timings;
+    std::vector<Scope> scopes;
+    std::deque<Frame> frames;
+    std::uint32_t max_scope_count;
+    bool has_timestamps;
+    bool is_frame_timed;
+
+    // Makes a profiler for up to max_scope_count passes per frame with timestamps read back up
+    // to frame_lag frames later
+    static GpuProfiler make(
+        WGPUDevice device,
+        std::uint32_t max_scope_count = 16,
+        std::uint32_t frame_lag = 3);
+
+    static void release(GpuProfiler& profiler);
+
+    // Collects timestamps from earlier frames that have been read back and starts a new frame
+    void begin_frame();
+
+    // Starts timing a pass. Returns timestamp writes to add to the pass descriptor or nullptr if
+    // the pass can't be timed on the GPU this frame.
+    WGPUPassTimestampWrites const* begin_pass(char const* name);
+
+    // Stops timing the current pass. Must be called after the pass has been ended.
+    void end_pass();
+
+    // Records resolution of the frame's timestamps. Must be called on the frame's last command
+    // encoder before it's finished.
+    void end_frame(WGPUCommandEncoder encoder);
+
+    // Must be called after the command buffer passed to end_frame has been submitted
+    void submit();
+
+    Timing const* find(char const* name) const;
+
+  private:
+    std::uint32_t get_timing(char const* name);
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,315 @@
+#include "wgpu_readback.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr std::uint64_t min_slot_size = 256;
+
+std::uint64_t round_up_pow2(std::uint64_t value)
+{
+    std::uint64_t result = min_slot_size;
+    while (result < value)
+        result <<= 1;
+
+    return result;
+}
+
+WGPUBuffer make_buffer(WGPUDevice const device, std::uint64_t const size)
+{
+    WGPUBufferDescriptor const desc{
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+        .size = size,
+    };
+    return wgpuDeviceCreateBuffer(device, &desc);
+}
+
+std::span<std::uint8_t const> get_slot_data(ReadbackRing::Slot const& slot)
+{
+    if (slot.state == ReadbackRing::Slot::State::Failed)
+        return {};
+
+    assert(slot.state == ReadbackRing::Slot::State::Mapped);
+    auto const data = static_cast<std::uint8_t const*>(
+        wgpuBufferGetConstMappedRange(slot.buffer, 0, slot.size));
+    assert(data);
+
+    return {data, slot.size};
+}
+
+void recycle_slot(ReadbackRing::Slot& slot)
+{
+    if (slot.state == ReadbackRing::Slot::State::Mapped)
+        wgpuBufferUnmap(slot.buffer);
+    else
+        assert(slot.state == ReadbackRing::Slot::State::Failed);
+
+    slot.state = ReadbackRing::Slot::State::Free;
+    slot.callback = nullptr;
+    slot.userdata = nullptr;
+}
+
+bool is_mapping(ReadbackRing::Slot const& slot)
+{
+    return slot.state == ReadbackRing::Slot::State::Mapping;
+}
+
+// Returns the submission that has to finish for all maps in flight to complete
+std::uint64_t get_last_mapping_submission(std::vector<ReadbackRing::Slot> const& slots)
+{
+    std::uint64_t result = 0;
+
+    for (ReadbackRing::Slot const& slot : slots)
+    {
+        if (is_mapping(slot))
+            result = std::max(result, slot.submission);
+    }
+
+    return result;
+}
+
+// Returns the submission that has to finish for the next slot to be recycled. Only slots with a
+// callback are recycled as soon as they're mapped.
+std::uint64_t get_next_recycle_submission(std::vector<ReadbackRing::Slot> const& slots)
+{
+    std::uint64_t result = ~std::uint64_t{0};
+
+    for (ReadbackRing::Slot const& slot : slots)
+    {
+        if (is_mapping(slot) && slot.callback)
+            result = std::min(result, slot.submission);
+    }
+
+    return (result != ~std::uint64_t{0}) ? result : 0;
+}
+
+} // namespace
+
+ReadbackRing ReadbackRing::make(
+    WGPUDevice const device,
+    std::size_t const slot_count,
+    std::uint64_t const slot_size)
+{
+    assert(slot_count > 0);
+
+    ReadbackRing result{};
+    result.device = device;
+    result.slots.resize(slot_count);
+
+    // Buffers are created on first use unless an initial size is given
+    if (slot_size > 0)
+    {
+        for (Slot& slot : result.slots)
+        {
+            slot.buffer = make_buffer(device, round_up_pow2(slot_size));
+            assert(slot.buffer);
+        }
+    }
+
+    return result;
+}
+
+void ReadbackRing::release(ReadbackRing& ring)
+{
+    // Map callbacks refer to their slot so any in flight have to finish before buffers are
+    // released. Their results are no longer wanted.
+    for (Slot& slot : ring.slots)
+        slot.callback = nullptr;
+
+    wait_for_condition(ring.device, get_last_mapping_submission(ring.slots), [&]() {
+        return std::none_of(ring.slots.begin(), ring.slots.end(), is_mapping);
+    });
+
+    for (Slot& slot : ring.slots)
+    {
+        if (!slot.buffer)
+            continue;
+
+        if (slot.state == Slot::State::Mapped)
+            wgpuBufferUnmap(slot.buffer);
+
+        wgpuBufferRelease(slot.buffer);
+    }
+
+    ring = {};
+}
+
+ReadbackRing::Handle ReadbackRing::enqueue(
+    WGPUCommandEncoder const encoder,
+    WGPUBuffer const src,
+    std::uint64_t const offset,
+    std::uint64_t const size,
+    Callback* const callback,
+    void* const userdata)
+{
+    assert(size % 4 == 0);
+
+    Slot* const slot = acquire(size);
+    if (!slot)
+        return {};
+
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, src, offset, slot->buffer, 0, size);
+
+    slot->callback = callback;
+    slot->userdata = userdata;
+    return {std::uint32_t(slot - slots.data()), slot->id};
+}
+
+ReadbackRing::Handle ReadbackRing::enqueue(
+    WGPUCommandEncoder const encoder,
+    WGPUTexelCopyTextureInfo const& src,
+    WGPUExtent3D const& extent,
+    std::uint32_t const bytes_per_row,
+    Callback* const callback,
+    void* const userdata)
+{
+    assert(bytes_per_row % copy_row_alignment == 0);
+
+    std::uint64_t const size = std::uint64_t{bytes_per_row} * extent.height
+        * extent.depthOrArrayLayers;
+
+    Slot* const slot = acquire(size);
+    if (!slot)
+        return {};
+
+    WGPUTexelCopyBufferInfo const dst{
+        .layout{
+            .bytesPerRow = bytes_per_row,
+            .rowsPerImage = extent.height,
+        },
+        .buffer = slot->buffer,
+    };
+    wgpuCommandEncoderCopyTextureToBuffer(encoder, &src, &dst, &extent);
+
+    slot->callback = callback;
+    slot->userdata = userdata;
+    return {std::uint32_t(slot - slots.data()), slot->id};
+}
+
+void ReadbackRing::submit()
+{
+    SubmissionIndex const submission = get_submission_index(wgpuDeviceGetQueue(device));
+
+    for (Slot& slot : slots)
+    {
+        if (slot.state != Slot::State::Recorded)
+            continue;
+
+        slot.submission = submission;
+
+        WGPUBufferMapCallbackInfo cb_info{};
+        cb_info.userdata1 = &slot;
+        cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+        cb_info.callback = //
+            [](WGPUMapAsyncStatus status,
+               WGPUStringView /*msg*/,
+               void* userdata1,
+               void* /*userdata2*/) {
+                auto& slot = *static_cast<Slot*>(userdata1);
+                slot.state = (status == WGPUMapAsyncStatus_Success) ? Slot::State::Mapped
+                                                                    : Slot::State::Failed;
+
+                // Deliver the result immediately if a callback was given
+                if (slot.callback)
+                {
+                    slot.callback(get_slot_data(slot), slot.id, slot.userdata);
+                    recycle_slot(slot);
+                }
+            };
+
+        slot.state = Slot::State::Mapping;
+        wgpuBufferMapAsync(slot.buffer, WGPUMapMode_Read, 0, slot.size, cb_info);
+    }
+}
+
+bool ReadbackRing::has_free_slot() const
+{
+    return std::any_of(slots.begin(), slots.end(), [](Slot const& slot) {
+        return slot.state == Slot::State::Free;
+    });
+}
+
+bool ReadbackRing::is_ready(Handle const handle) const
+{
+    assert(handle.is_valid());
+    Slot const& slot = slots[handle.slot];
+
+    // A recycled slot means the result was already delivered
+    return slot.id != handle.id || slot.state == Slot::State::Mapped
+        || slot.state == Slot::State::Failed || slot.state == Slot::State::Free;
+}
+
+std::span<std::uint8_t const> ReadbackRing::get_data(Handle const handle) const
+{
+    assert(handle.is_valid());
+    Slot const& slot = slots[handle.slot];
+    assert(slot.id == handle.id);
+    return get_slot_data(slot);
+}
+
+void ReadbackRing::recycle(Handle const handle)
+{
+    assert(handle.is_valid());
+    Slot& slot = slots[handle.slot];
+    if (slot.id != handle.id)
+        return;
+
+    recycle_slot(slot);
+}
+
+WGPUWaitStatus ReadbackRing::wait(Handle const handle, std::uint64_t const timeout) const
+{
+    SubmissionIndex const submission = slots[handle.slot].submission;
+    return wait_for_condition(device, submission, [&]() { return is_ready(handle); }, timeout);
+}
+
+WGPUWaitStatus ReadbackRing::wait_for_free_slot(std::uint64_t const timeout) const
+{
+    SubmissionIndex const submission = get_next_recycle_submission(slots);
+    return wait_for_condition(device, submission, [&]() { return has_free_slot(); }, timeout);
+}
+
+std::size_t ReadbackRing::pending_count() const
+{
+    return std::count_if(slots.begin(), slots.end(), [](Slot const& slot) {
+        return slot.state != Slot::State::Free;
+    });
+}
+
+ReadbackRing::Slot* ReadbackRing::acquire(std::uint64_t const size)
+{
+    // Look for a free slot starting after the most recently used one
+    std::size_t const n = slots.size();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        Slot& slot = slots[(next_slot + i) % n];
+        if (slot.state != Slot::State::Free)
+            continue;
+
+        // Grow the slot's buffer if it's too small for this readback
+        if (!slot.buffer || wgpuBufferGetSize(slot.buffer) < size)
+        {
+            if (slot.buffer)
+                wgpuBufferRelease(slot.buffer);
+
+            slot.buffer = make_buffer(device, round_up_pow2(size));
+            assert(slot.buffer);
+        }
+
+        slot.size = size;
+        slot.id = ++next_id;
+        slot.state = Slot::State::Recorded;
+        next_slot = (next_slot + i + 1) % n;
+        return &slot;
+    }
+
+    return nullptr;
+}
+
+} // namespace wgpu::sandbox
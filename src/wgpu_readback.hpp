@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Ring of MapRead staging buffers for reading results back from the GPU without stalling the
+// queue. Each readback copies into a free slot, the slot is mapped once the copy has been
+// submitted, and the result is either passed to a callback or polled via the returned handle.
+// Map callbacks only refer to slots, which live on the heap and are never reallocated, so the ring
+// itself can be moved while maps are in flight.
+struct ReadbackRing
+{
+    using Callback = void(std::span<std::uint8_t const> data, std::uint64_t id, void* userdata);
+
+    struct Handle
+    {
+        std::uint32_t slot{~0u};
+        std::uint64_t id{};
+        bool is_valid() const { return slot != ~0u; }
+    };
+
+    struct Slot
+    {
+        enum class State : std::uint8_t
+        {
+            Free = 0,
+            Recorded,
+            Mapping,
+            Mapped,
+            Failed,
+        };
+
+        WGPUBuffer buffer;
+        std::uint64_t size;
+        std::uint64_t id;
+        std::uint64_t submission; // Queue submission index of the copy into the slot
+        Callback* callback;
+        void* userdata;
+        State state;
+    };
+
+    WGPUDevice device;
+    std::vector<Slot> slots;
+    std::uint64_t next_id;
+    std::size_t next_slot;
+
+    static ReadbackRing make(
+        WGPUDevice device,
+        std::size_t slot_count,
+        std::uint64_t slot_size = 0);
+
+    // Waits for any maps in flight without delivering their results, then releases all buffers
+    static void release(ReadbackRing& ring);
+
+    // Records a copy of a buffer range into a free slot. If a callback is given, it's called
+    // with the result as soon as the slot has been mapped and the slot is recycled afterwards.
+    // The result is empty if the slot couldn't be mapped.
+    // Otherwise the result is polled via the returned handle and must be recycled explicitly.
+    // Returns an invalid handle if no slot is free.
+    Handle enqueue(
+        WGPUCommandEncoder encoder,
+        WGPUBuffer src,
+        std::uint64_t offset,
+        std::uint64_t size,
+        Callback* callback = nullptr,
+        void* userdata = nullptr);
+
+    // Records a copy of a texture region into a free slot. bytes_per_row must be a multiple of
+    // 256.
+    Handle enqueue(
+        WGPUCommandEncoder encoder,
+        WGPUTexelCopyTextureInfo const& src,
+        WGPUExtent3D const& extent,
+        std::uint32_t bytes_per_row,
+        Callback* callback = nullptr,
+        void* userdata = nullptr);
+
+    // Requests mapping of all slots recorded since the last call. Must be called after the
+    // command buffer containing the recorded copies has been submitted.
+    void submit();
+
+    bool has_free_slot() const;
+    bool is_ready(Handle handle) const;
+    // Returns an empty span if the slot couldn't be mapped
+    std::span<std::uint8_t const> get_data(Handle handle) const;
+    void recycle(Handle handle);
+
+    // Blocks until the given readback is ready
+    WGPUWaitStatus wait(Handle handle, std::uint64_t timeout = ~0) const;
+
+    // Blocks until at least one slot is free
+    WGPUWaitStatus wait_for_free_slot(std::uint64_t timeout = ~0) const;
+
+    std::size_t pending_count() const;
+
+  private:
+    Slot* acquire(std::uint64_t size);
+};
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,39 @@
+#include "wgpu_render_bundles.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wgpu::sandbox
+{
+
+void record_render_bundles(
+    TaskPool& pool,
+    WGPUDevice const device,
+    WGPURenderBundleEncoderDescriptor const& desc,
+    std::size_t const item_count,
+    std::span<WGPURenderBundle> const bundles,
+    RecordBundleFn* const record,
+    void* const userdata)
+{
+    assert(bundles.size() > 0);
+
+    pool.run(bundles.size(), [&](std::size_t const index) {
+        // Spread the remainder over the first few bundles
+        std::size_t const count = item_count / bundles.size();
+        std::size_t const rem = item_count % bundles.size();
+        std::size_t const begin = index * count + std::min(index, rem);
+        std::size_t const end = begin + count + (index < rem);
+
+        // NOTE(dr): Device-level create calls are thread safe in wgpu-native and Dawn but a given
+        // encoder must only be used from one thread
+        WGPURenderBundleEncoder const encoder = wgpuDeviceCreateRenderBundleEncoder(device, &desc);
+        record(encoder, begin, end, userdata);
+
+        bundles[index] = wgpuRenderBundleEncoderFinish(encoder, nullptr);
+        assert(bundles[index]);
+
+        wgpuRenderBundleEncoderRelease(encoder);
+    });
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include <webgpu/webgpu.h>
+
+#include "task_pool.hpp"
+
+namespace wgpu::sandbox
+{
+
+// Records draws for items in [begin, end) into a bundle encoder
+using RecordBundleFn = void(
+    WGPURenderBundleEncoder encoder,
+    std::size_t begin,
+    std::size_t end,
+    void* userdata);
+
+// Splits items into contiguous ranges, one per bundle, and records each range on a separate task.
+// Bundles are returned in item order so executing them in sequence draws items in the same order
+// as a single pass would. The caller owns the returned bundles.
+void record_render_bundles(
+    TaskPool& pool,
+    WGPUDevice device,
+    WGPURenderBundleEncoderDescriptor const& desc,
+    std::size_t item_count,
+    std::span<WGPURenderBundle> bundles,
+    RecordBundleFn* record,
+    void* userdata);
+
+template <typename Func>
+void record_render_bundles(
+    TaskPool& pool,
+    WGPUDevice const device,
+    WGPURenderBundleEncoderDescriptor const& desc,
+    std::size_t const item_count,
+    std::span<WGPURenderBundle> const bundles,
+    Func&& record)
+{
+    static_assert(
+        std::is_invocable_v<Func, WGPURenderBundleEncoder, std::size_t, std::size_t>);
+
+    record_render_bundles(
+        pool,
+        device,
+        desc,
+        item_count,
+        bundles,
+        [](WGPURenderBundleEncoder const encoder,
+           std::size_t const begin,
+           std::size_t const end,
+           void* const userdata) {
+            (*static_cast<std::remove_reference_t<Func>*>(userdata))(encoder, begin, end);
+        },
+        &record);
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,95 @@
+#include "wgpu_uniform_ring.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "wgpu_buffer_pool.hpp"
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+
+UniformRing UniformRing::make(
+    WGPUDevice const device,
+    std::uint32_t const capacity,
+    std::uint64_t const element_size,
+    std::uint32_t const frame_count)
+{
+    assert(frame_count > 0);
+
+    UniformRing result{};
+    result.alignment = get_min_offset_alignment(device, WGPUBufferUsage_Uniform);
+    result.frame_size = capacity * align_up(element_size, result.alignment);
+    result.frame_count = frame_count;
+    result.data.resize(result.frame_size);
+
+    WGPUBufferDescriptor const desc{
+        .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+        .size = result.frame_size * frame_count,
+    };
+    result.buffer = wgpuDeviceCreateBuffer(device, &desc);
+    assert(result.buffer);
+
+    return result;
+}
+
+void UniformRing::release(UniformRing& ring)
+{
+    wgpuBufferRelease(ring.buffer);
+    ring = {};
+}
+
+std::uint32_t UniformRing::push(void const* const src, std::uint64_t const size)
+{
+    assert(has_room(size));
+
+    std::uint64_t const offset = head;
+    std::memcpy(data.data() + offset, src, size);
+    head = align_up(offset + size, alignment);
+
+    return std::uint32_t(frame_index * frame_size + offset);
+}
+
+std::uint32_t UniformRing::reserve(std::uint32_t const count, std::uint64_t const element_size)
+{
+    std::uint64_t const size = count * get_stride(element_size);
+    assert(has_room(size));
+
+    std::uint64_t const offset = head;
+    head += size;
+
+    return std::uint32_t(frame_index * frame_size + offset);
+}
+
+void UniformRing::write(
+    std::uint32_t const offset,
+    void const* const src,
+    std::uint64_t const size)
+{
+    std::uint64_t const local_offset = offset - frame_index * frame_size;
+    assert(local_offset + size <= head);
+    std::memcpy(data.data() + local_offset, src, size);
+}
+
+void UniformRing::flush(WGPUQueue const queue)
+{
+    if (head > 0)
+        wgpuQueueWriteBuffer(queue, buffer, frame_index * frame_size, data.data(), head);
+
+    head = 0;
+    frame_index = (frame_index + 1) % frame_count;
+}
+
+void UniformRing::set_frame(std::uint32_t const index)
+{
+    assert(index < frame_count);
+    assert(head == 0);
+    frame_index = index;
+}
+
+std::uint64_t UniformRing::get_stride(std::uint64_t const element_size) const
+{
+    return align_up(element_size, alignment);
+}
+
+} // namespace wgpu::sandbox
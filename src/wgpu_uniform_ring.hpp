@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Per-frame ring of uniform data that's bound once and indexed with dynamic offsets. Uniforms for
+// each draw are appended to a CPU copy of the current frame's region and written to the GPU in
+// one call. Each frame writes to a different region so that writes don't wait on draws from the
+// previous frame.
+struct UniformRing
+{
+    WGPUBuffer buffer;
+    std::vector<std::uint8_t> data;
+    std::uint64_t frame_size;
+    std::uint64_t head;
+    std::uint32_t alignment;
+    std::uint32_t frame_count;
+    std::uint32_t frame_index;
+
+    // Makes a ring with room for the given number of pushes of up to element_size bytes per frame
+    static UniformRing make(
+        WGPUDevice device,
+        std::uint32_t capacity,
+        std::uint64_t element_size,
+        std::uint32_t frame_count = 3);
+
+    static void release(UniformRing& ring);
+
+    // Appends uniforms for a draw and returns the dynamic offset to bind them at
+    std::uint32_t push(void const* src, std::uint64_t size);
+
+    template <typename T>
+    std::uint32_t push(T const& value)
+    {
+        return push(&value, sizeof(T));
+    }
+
+    // Reserves room for count consecutive elements and returns the dynamic offset of the first.
+    // Elements are get_stride(element_size) bytes apart.
+    std::uint32_t reserve(std::uint32_t count, std::uint64_t element_size);
+
+    // Writes uniforms at a dynamic offset returned by reserve. Safe to call from multiple threads
+    // as long as each writes to a different element.
+    void write(std::uint32_t offset, void const* src, std::uint64_t size);
+
+    template <typename T>
+    void write(std::uint32_t const offset, T const& value)
+    {
+        write(offset, &value, sizeof(T));
+    }
+
+    // Writes uniforms pushed since the last call and moves on to the next frame's region. Must be
+    // called before submitting any commands that use them.
+    void flush(WGPUQueue queue);
+
+    // Selects the region for the current frame, e.g. from a frame pacer's slot. Regions are
+    // otherwise used in turn which is only safe if no more than frame_count frames are in flight.
+    // Must be called before any uniforms are pushed for the frame.
+    void set_frame(std::uint32_t index);
+
+    bool has_room(std::uint64_t size) const { return head + size <= frame_size; }
+
+    std::uint64_t get_stride(std::uint64_t element_size) const;
+};
+
+} // namespace wgpu::sandbox
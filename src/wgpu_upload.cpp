@@ -0,0 +1,282 @@
+#include "wgpu_upload.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "wgpu_utils.hpp"
+
+namespace wgpu::sandbox
+{
+namespace
+{
+
+constexpr std::size_t no_chunk = ~std::size_t{0};
+
+bool is_pending(UploadRing::Chunk const& chunk)
+{
+    using State = UploadRing::Chunk::State;
+    return chunk.state == State::InFlight || chunk.state == State::Mapping;
+}
+
+void map_chunk(UploadRing::Chunk& chunk)
+{
+    WGPUBufferMapCallbackInfo cb_info{};
+    cb_info.userdata1 = &chunk;
+    cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+    cb_info.callback = //
+        [](
+            [[maybe_unused]] WGPUMapAsyncStatus status,
+            WGPUStringView /*msg*/,
+            void* userdata1,
+            void* /*userdata2*/) {
+            auto& chunk = *static_cast<UploadRing::Chunk*>(userdata1);
+            assert(status == WGPUMapAsyncStatus_Success);
+
+            chunk.data = static_cast<std::uint8_t*>(
+                wgpuBufferGetMappedRange(chunk.buffer, 0, chunk.size));
+            assert(chunk.data);
+
+            chunk.offset = 0;
+            chunk.state = UploadRing::Chunk::State::Free;
+        };
+
+    chunk.state = UploadRing::Chunk::State::Mapping;
+    wgpuBufferMapAsync(chunk.buffer, WGPUMapMode_Write, 0, chunk.size, cb_info);
+}
+
+// Returns the submission that has to finish for all pending chunks to be remapped
+std::uint64_t get_last_pending_submission(std::deque<UploadRing::Chunk> const& chunks)
+{
+    std::uint64_t result = 0;
+
+    for (UploadRing::Chunk const& chunk : chunks)
+    {
+        if (is_pending(chunk))
+            result = std::max(result, chunk.submission);
+    }
+
+    return result;
+}
+
+// Returns the submission that has to finish for the next pending chunk to be remapped
+std::uint64_t get_first_pending_submission(std::deque<UploadRing::Chunk> const& chunks)
+{
+    std::uint64_t result = ~std::uint64_t{0};
+
+    for (UploadRing::Chunk const& chunk : chunks)
+    {
+        if (is_pending(chunk))
+            result = std::min(result, chunk.submission);
+    }
+
+    return (result != ~std::uint64_t{0}) ? result : 0;
+}
+
+} // namespace
+
+UploadRing UploadRing::make(
+    WGPUDevice const device,
+    std::uint64_t const chunk_size,
+    std::size_t const max_chunk_count)
+{
+    assert(chunk_size % copy_alignment == 0);
+    assert(max_chunk_count > 0);
+
+    UploadRing result{};
+    result.device = device;
+    result.chunk_size = chunk_size;
+    result.max_chunk_count = max_chunk_count;
+    result.active = no_chunk;
+
+    return result;
+}
+
+void UploadRing::release(UploadRing& ring)
+{
+    // Map callbacks refer to chunks so wait for any in flight before releasing
+    wait_for_condition(ring.device, get_last_pending_submission(ring.chunks), [&]() {
+        return std::none_of(ring.chunks.begin(), ring.chunks.end(), is_pending);
+    });
+
+    for (Chunk& chunk : ring.chunks)
+    {
+        if (chunk.data)
+            wgpuBufferUnmap(chunk.buffer);
+
+        wgpuBufferRelease(chunk.buffer);
+    }
+
+    ring = {};
+}
+
+std::span<std::uint8_t> UploadRing::stage(
+    WGPUBuffer const dst,
+    std::uint64_t const dst_offset,
+    std::uint64_t const size)
+{
+    assert(dst_offset % copy_alignment == 0);
+
+    std::uint64_t const copy_size = align_up(size, copy_alignment);
+    assert(dst_offset + copy_size <= wgpuBufferGetSize(dst));
+
+    Chunk& chunk = acquire(copy_size);
+    std::uint64_t const src_offset = chunk.offset;
+    chunk.offset += copy_size;
+
+    // Extend the previous copy if this one continues it in both buffers
+    Copy* const prev = copies.empty() ? nullptr : &copies.back();
+    if (prev && prev->src == chunk.buffer && prev->dst == dst
+        && prev->src_offset + prev->size == src_offset
+        && prev->dst_offset + prev->size == dst_offset)
+    {
+        prev->size += copy_size;
+    }
+    else
+    {
+        copies.push_back({chunk.buffer, src_offset, dst, dst_offset, copy_size});
+    }
+
+    stats.bytes_staged += copy_size;
+    return {chunk.data + src_offset, copy_size};
+}
+
+void UploadRing::write(
+    WGPUBuffer const dst,
+    std::uint64_t const dst_offset,
+    void const* const data,
+    std::uint64_t const size)
+{
+    std::span<std::uint8_t> const staged = stage(dst, dst_offset, size);
+    std::memcpy(staged.data(), data, size);
+}
+
+void UploadRing::finish(WGPUCommandEncoder const encoder)
+{
+    for (Copy const& copy : copies)
+    {
+        wgpuCommandEncoderCopyBufferToBuffer(
+            encoder,
+            copy.src,
+            copy.src_offset,
+            copy.dst,
+            copy.dst_offset,
+            copy.size);
+    }
+
+    stats.copies_recorded += copies.size();
+    copies.clear();
+
+    // Chunks must be unmapped before the copies are submitted
+    for (Chunk& chunk : chunks)
+    {
+        if (chunk.state != Chunk::State::Active)
+            continue;
+
+        wgpuBufferUnmap(chunk.buffer);
+        chunk.data = nullptr;
+        chunk.state = Chunk::State::Recorded;
+    }
+
+    active = no_chunk;
+}
+
+void UploadRing::submit()
+{
+    WGPUQueue const queue = wgpuDeviceGetQueue(device);
+    SubmissionIndex const submission = get_submission_index(queue);
+
+    for (Chunk& chunk : chunks)
+    {
+        if (chunk.state != Chunk::State::Recorded)
+            continue;
+
+        chunk.submission = submission;
+        chunk.state = Chunk::State::InFlight;
+
+        // Remap the chunk once the GPU is done with the submission that reads from it
+        WGPUQueueWorkDoneCallbackInfo cb_info{};
+        cb_info.userdata1 = &chunk;
+        cb_info.mode = WGPUCallbackMode_AllowSpontaneous;
+        cb_info.callback =
+#ifdef __EMSCRIPTEN__
+            // NOTE(dr): Callback from webgpu.h in Emdawnwebgpu has a different signature
+            [](
+                [[maybe_unused]] WGPUQueueWorkDoneStatus status,
+                WGPUStringView /*msg*/,
+                void* userdata1,
+                void* /*userdata2*/) {
+#else
+            [](
+                [[maybe_unused]] WGPUQueueWorkDoneStatus status,
+                void* userdata1,
+                void* /*userdata2*/) {
+#endif
+                assert(status == WGPUQueueWorkDoneStatus_Success);
+                map_chunk(*static_cast<Chunk*>(userdata1));
+            };
+        wgpuQueueOnSubmittedWorkDone(queue, cb_info);
+    }
+}
+
+UploadRing::Chunk& UploadRing::acquire(std::uint64_t const size)
+{
+    // Keep filling the active chunk while it has room
+    if (active != no_chunk)
+    {
+        Chunk& chunk = chunks[active];
+        if (chunk.offset + size <= chunk.size)
+            return chunk;
+    }
+
+    auto const find_free = [&]() {
+        return std::find_if(chunks.begin(), chunks.end(), [&](Chunk const& chunk) {
+            return chunk.state == Chunk::State::Free && chunk.size >= size;
+        });
+    };
+
+    auto it = find_free();
+
+    // Wait for a chunk to come back if the ring is at capacity. This is only possible if some
+    // chunks are in flight, otherwise the ring has to grow.
+    if (it == chunks.end() && chunks.size() >= max_chunk_count
+        && std::any_of(chunks.begin(), chunks.end(), is_pending))
+    {
+        ++stats.stall_count;
+        wait_for_condition(device, get_first_pending_submission(chunks), [&]() {
+            return std::any_of(chunks.begin(), chunks.end(), [](Chunk const& chunk) {
+                return chunk.state == Chunk::State::Free;
+            });
+        });
+        it = find_free();
+    }
+
+    if (it == chunks.end())
+    {
+        // Uploads larger than the chunk size get a chunk of their own
+        Chunk& chunk = chunks.emplace_back();
+        chunk.size = std::max(chunk_size, size);
+
+        WGPUBufferDescriptor const desc{
+            .usage = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc,
+            .size = chunk.size,
+            .mappedAtCreation = true,
+        };
+        chunk.buffer = wgpuDeviceCreateBuffer(device, &desc);
+        assert(chunk.buffer);
+
+        chunk.data = static_cast<std::uint8_t*>(
+            wgpuBufferGetMappedRange(chunk.buffer, 0, chunk.size));
+        assert(chunk.data);
+
+        it = chunks.end() - 1;
+    }
+
+    // Any room left in the previous active chunk is abandoned until it's recycled
+    it->state = Chunk::State::Active;
+    active = std::size_t(it - chunks.begin());
+
+    return *it;
+}
+
+} // namespace wgpu::sandbox
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+
+namespace wgpu::sandbox
+{
+
+// Linear staging allocator for uploading buffer data. Writes are packed into large MapWrite
+// chunks and the resulting copies are recorded in one go. Chunks used by a submission are
+// remapped and reused once the queue reports that the submission is done. Queue and map callbacks
+// only refer to chunks, which live in a deque and are never relocated, so the ring itself can be
+// moved while submissions are pending.
+//
+// Typical use per frame: write/stage any number of uploads, call finish to record copies before
+// any commands that read the destinations, submit the command buffer, then call submit.
+struct UploadRing
+{
+    struct Chunk
+    {
+        enum class State : std::uint8_t
+        {
+            Free = 0,
+            Active,
+            Recorded,
+            InFlight,
+            Mapping,
+        };
+
+        WGPUBuffer buffer;
+        std::uint8_t* data;
+        std::uint64_t size;
+        std::uint64_t offset;
+        std::uint64_t submission; // Queue submission index of the copies reading from the chunk
+        State state;
+    };
+
+    struct Copy
+    {
+        WGPUBuffer src;
+        std::uint64_t src_offset;
+        WGPUBuffer dst;
+        std::uint64_t dst_offset;
+        std::uint64_t size;
+    };
+
+    struct Stats
+    {
+        std::uint64_t bytes_staged;
+        std::uint64_t copies_recorded;
+        std::uint64_t stall_count;
+    };
+
+    WGPUDevice device;
+    std::deque<Chunk> chunks;
+    std::vector<Copy> copies;
+    std::uint64_t chunk_size;
+    std::size_t max_chunk_count;
+    std::size_t active;
+    Stats stats;
+
+    static UploadRing make(
+        WGPUDevice device,
+        std::uint64_t chunk_size = 1 << 20,
+        std::size_t max_chunk_count = 4);
+
+    static void release(UploadRing& ring);
+
+    // Returns staging memory for an upload of the given size to dst. The returned memory is
+    // rounded up to a multiple of 4 bytes and all of it is copied, so dst must have room for the
+    // padding.
+    std::span<std::uint8_t> stage(WGPUBuffer dst, std::uint64_t dst_offset, std::uint64_t size);
+
+    // Copies data into staging memory for an upload to dst
+    void write(WGPUBuffer dst, std::uint64_t dst_offset, void const* data, std::uint64_t size);
+
+    // Records copies for all uploads staged since the last call and unmaps their chunks
+    void finish(WGPUCommandEncoder encoder);
+
+    // Schedules chunks recorded by finish to be remapped. Must be called after the command buffer
+    // containing the recorded copies has been submitted.
+    void submit();
+
+    void reset_stats() { stats = {}; }
+
+  private:
+    Chunk& acquire(std::uint64_t size);
+};
+
+} // namespace wgpu::sandbox
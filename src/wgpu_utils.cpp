@@ -1,12 +1,19 @@
 #include "wgpu_utils.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <thread>
 
 #include <fmt/core.h>
 
 #ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+
 #include "emsc_utils.hpp"
 #else
+#include <webgpu/wgpu.h>
+
 #include "wgpu_glfw.h"
 #endif
 
@@ -96,6 +103,75 @@ WGPUWaitStatus wait_for_future(
     return wgpuInstanceWaitAny(instance, 1, &info, timeout);
 }
 
+void Backoff::pause()
+{
+    // Sleep duration doubles with each pause from 50us up to 2ms
+    constexpr std::uint32_t min_us = 50;
+    constexpr std::uint32_t max_us = 2000;
+    std::uint32_t const us = std::min(min_us << std::min(count, 6u), max_us);
+    ++count;
+
+#ifdef __EMSCRIPTEN__
+    // Yield to the browser's event loop so that pending callbacks can run
+    emscripten_sleep(std::max(us / 1000, 1u));
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+#endif
+}
+
+bool poll_device([[maybe_unused]] WGPUDevice const device, [[maybe_unused]] bool const wait)
+{
+#ifdef __EMSCRIPTEN__
+    // NOTE(dr): Device polling isn't available on the web. Work is driven by the browser's event
+    // loop instead.
+    emscripten_sleep(0);
+    return true;
+#else
+    return wgpuDevicePoll(device, wait, nullptr);
+#endif
+}
+
+SubmissionIndex get_submission_index([[maybe_unused]] WGPUQueue const queue)
+{
+#ifdef __EMSCRIPTEN__
+    return 0;
+#else
+    // An empty submission is ordered after all previous ones
+    return wgpuQueueSubmitForIndex(queue, 0, nullptr);
+#endif
+}
+
+void wait_for_submission(
+    [[maybe_unused]] WGPUDevice const device,
+    [[maybe_unused]] SubmissionIndex const index)
+{
+#ifdef __EMSCRIPTEN__
+    emscripten_sleep(0);
+#else
+    wgpuDevicePoll(device, true, &index);
+#endif
+}
+
+void Hasher::add(WGPUStringView const src)
+{
+    // Null data is an empty string (e.g. WGPU_STRING_VIEW_INIT for an omitted entry point)
+    std::size_t const size =
+        !src.data ? 0 : (src.length == WGPU_STRLEN) ? std::strlen(src.data) : src.length;
+    add(size);
+    add_bytes(src.data, size);
+}
+
+WGPUWaitStatus WaitGroup::wait(WGPUDevice const device, std::uint64_t const timeout) const
+{
+    SubmissionIndex const submission = get_submission_index(wgpuDeviceGetQueue(device));
+    return wait_for_condition(device, submission, [&]() { return is_done(); }, timeout);
+}
+
+WGPUWaitStatus WaitGroup::wait(WGPUInstance const instance, std::uint64_t const timeout) const
+{
+    return wait_for_condition(instance, [&]() { return is_done(); }, timeout);
+}
+
 WGPUAdapter request_adapter(
     WGPUInstance const instance,
     WGPURequestAdapterOptions const* const options)
@@ -264,6 +340,67 @@ void report_surface_capabilities(WGPUSurface const surface, WGPUAdapter const ad
         fmt::println("\t\t{}", to_string(cap.presentModes[i]));
 }
 
+bool is_supported(WGPUSurfaceCapabilities const& caps, WGPUPresentMode const mode)
+{
+    return std::find(caps.presentModes, caps.presentModes + caps.presentModeCount, mode)
+        != caps.presentModes + caps.presentModeCount;
+}
+
+bool is_supported(WGPUSurfaceCapabilities const& caps, WGPUTextureFormat const format)
+{
+    return std::find(caps.formats, caps.formats + caps.formatCount, format)
+        != caps.formats + caps.formatCount;
+}
+
+WGPUPresentMode select_present_mode(
+    WGPUSurfaceCapabilities const& caps,
+    PresentPolicy const policy)
+{
+    static constexpr WGPUPresentMode low_latency[]{
+        WGPUPresentMode_Mailbox,
+        WGPUPresentMode_Immediate,
+        WGPUPresentMode_FifoRelaxed,
+    };
+    static constexpr WGPUPresentMode balanced[]{
+        WGPUPresentMode_FifoRelaxed,
+    };
+
+    auto const select = [&](auto const& preferred) {
+        for (WGPUPresentMode const mode : preferred)
+        {
+            if (is_supported(caps, mode))
+                return mode;
+        }
+        return WGPUPresentMode_Fifo;
+    };
+
+    switch (policy)
+    {
+        case PresentPolicy::LowLatency:
+            return select(low_latency);
+        case PresentPolicy::Balanced:
+            return select(balanced);
+        default:
+            return WGPUPresentMode_Fifo;
+    }
+}
+
+WGPUTextureFormat select_surface_format(
+    WGPUSurfaceCapabilities const& caps,
+    WGPUTextureFormat const* const preferred,
+    std::size_t const preferred_count)
+{
+    for (std::size_t i = 0; i < preferred_count; ++i)
+    {
+        if (is_supported(caps, preferred[i]))
+            return preferred[i];
+    }
+
+    // First format is the surface's preferred one
+    assert(caps.formatCount > 0);
+    return caps.formats[0];
+}
+
 char const* to_string(WGPUFeatureName const value)
 {
     static constexpr char const* names[]{
@@ -498,6 +635,16 @@ char const* to_string(WGPUPresentMode const value)
     return names[value];
 }
 
+char const* to_string(PresentPolicy const value)
+{
+    static constexpr char const* names[]{
+        "LowLatency",
+        "Balanced",
+        "LowPower",
+    };
+    return names[int(value)];
+}
+
 char const* to_string(WGPUMapAsyncStatus value)
 {
     static constexpr char const* names[]{
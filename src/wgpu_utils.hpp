@@ -1,7 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <thread>
 #include <type_traits>
 
 #include <GLFW/glfw3.h>
@@ -11,6 +12,18 @@
 namespace wgpu::sandbox
 {
 
+// Required alignment of offsets and sizes in buffer copies
+inline constexpr std::uint64_t copy_alignment = 4;
+
+// Required alignment of bytes per row in copies between buffers and textures
+inline constexpr std::uint32_t copy_row_alignment = 256;
+
+// Rounds value up to the nearest multiple of alignment
+constexpr std::uint64_t align_up(std::uint64_t const value, std::uint64_t const alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
 struct SurfaceSource
 {
     GLFWwindow* window;
@@ -24,18 +37,152 @@ WGPUWaitStatus wait_for_future(
     WGPUFuture future,
     std::uint64_t timeout = ~0);
 
+// Sleeps for exponentially increasing durations between polls so that waiting threads don't
+// occupy a core while nothing is ready
+struct Backoff
+{
+    std::uint32_t count{};
+
+    void pause();
+    void reset() { count = 0; }
+};
+
+// Returns false once the given timeout (in nanoseconds) has elapsed. Default timeout never
+// expires.
+struct Deadline
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start{Clock::now()};
+    std::uint64_t timeout{~std::uint64_t{0}};
+
+    bool is_infinite() const { return timeout == ~std::uint64_t{0}; }
+    bool has_expired() const
+    {
+        using std::chrono::duration_cast, std::chrono::nanoseconds;
+        return !is_infinite()
+            && std::uint64_t(duration_cast<nanoseconds>(Clock::now() - start).count()) >= timeout;
+    }
+};
+
+// Processes pending device events. If wait is true, blocks until all submitted work on the
+// device's queue is done. Returns true if the queue has no work left in flight.
+bool poll_device(WGPUDevice device, bool wait);
+
+// Identifies a queue submission so that work can be waited on without waiting for anything
+// submitted after it.
+//
+// NOTE(dr): Submissions can't be waited on individually on the web so indices are always 0 there
+using SubmissionIndex = std::uint64_t;
+
+// Returns the index of the most recent submission to the queue. Waiting on it waits for all work
+// submitted so far.
+SubmissionIndex get_submission_index(WGPUQueue queue);
+
+// Blocks until the given submission is done and processes pending device events. On the web, only
+// yields to the browser's event loop.
+void wait_for_submission(WGPUDevice device, SubmissionIndex index);
+
 // TODO(dr): Remove this once waiting on futures is implemented in wgpu-native
 template <typename Condition>
-void wait_for_condition(WGPUInstance const instance, Condition&& cond)
+WGPUWaitStatus wait_for_condition(
+    WGPUInstance const instance,
+    Condition&& cond,
+    std::uint64_t const timeout = ~0)
 {
     static_assert(std::is_invocable_r_v<bool, Condition>);
+
+    Deadline const deadline{.timeout = timeout};
+    Backoff backoff{};
+
     while (!cond())
     {
+        if (deadline.has_expired())
+            return WGPUWaitStatus_TimedOut;
+
         wgpuInstanceProcessEvents(instance);
-        std::this_thread::yield();
+        if (!cond())
+            backoff.pause();
     }
+
+    return WGPUWaitStatus_Success;
 }
 
+// Waits on a condition that is satisfied by callbacks for work up to and including the given
+// submission. On native, the calling thread blocks in the device poll until the submission is done
+// without waiting on later ones, so the timeout is only checked between polls. On the web, the
+// calling thread sleeps between polls.
+template <typename Condition>
+WGPUWaitStatus wait_for_condition(
+    WGPUDevice const device,
+    [[maybe_unused]] SubmissionIndex const submission,
+    Condition&& cond,
+    std::uint64_t const timeout = ~0)
+{
+    static_assert(std::is_invocable_r_v<bool, Condition>);
+
+    Deadline const deadline{.timeout = timeout};
+#ifdef __EMSCRIPTEN__
+    Backoff backoff{};
+#endif
+
+    while (!cond())
+    {
+        if (deadline.has_expired())
+            return WGPUWaitStatus_TimedOut;
+
+#ifdef __EMSCRIPTEN__
+        poll_device(device, false);
+        if (!cond())
+            backoff.pause();
+#else
+        wait_for_submission(device, submission);
+#endif
+    }
+
+    return WGPUWaitStatus_Success;
+}
+
+// Counts outstanding async operations so that any number of callbacks can be waited on at once.
+// Call add before issuing each request and done from its callback.
+struct WaitGroup
+{
+    std::atomic<std::int32_t> pending{};
+
+    void add(std::int32_t const count = 1) { pending.fetch_add(count); }
+    void done() { pending.fetch_sub(1); }
+    bool is_done() const { return pending.load() <= 0; }
+
+    // Callbacks must be for work submitted before the call
+    WGPUWaitStatus wait(WGPUDevice device, std::uint64_t timeout = ~0) const;
+    WGPUWaitStatus wait(WGPUInstance instance, std::uint64_t timeout = ~0) const;
+};
+
+// Incremental FNV-1a hash of plain values, used to key caches of device objects by their
+// descriptors
+struct Hasher
+{
+    std::uint64_t value{0xcbf29ce484222325};
+
+    void add_bytes(void const* const src, std::size_t const size)
+    {
+        auto const bytes = static_cast<std::uint8_t const*>(src);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            value ^= bytes[i];
+            value *= 0x100000001b3;
+        }
+    }
+
+    template <typename T>
+    void add(T const& src)
+    {
+        static_assert(std::is_scalar_v<T>);
+        add_bytes(&src, sizeof(T));
+    }
+
+    void add(WGPUStringView src);
+};
+
 WGPUAdapter request_adapter(
     WGPUInstance instance,
     WGPURequestAdapterOptions const* options = nullptr);
@@ -57,6 +204,29 @@ void report_device_limits(WGPUDevice device);
 
 void report_surface_capabilities(WGPUSurface surface, WGPUAdapter adapter);
 
+// Trade-off between latency and power used when picking a surface's present mode
+enum class PresentPolicy : std::uint8_t
+{
+    LowLatency = 0, // Mailbox, Immediate, FifoRelaxed, then Fifo
+    Balanced,       // FifoRelaxed, then Fifo
+    LowPower,       // Fifo
+};
+
+bool is_supported(WGPUSurfaceCapabilities const& caps, WGPUPresentMode mode);
+
+bool is_supported(WGPUSurfaceCapabilities const& caps, WGPUTextureFormat format);
+
+// Returns the most preferred present mode for the given policy that's supported by the surface.
+// Fifo is always supported.
+WGPUPresentMode select_present_mode(WGPUSurfaceCapabilities const& caps, PresentPolicy policy);
+
+// Returns the first of the preferred formats that's supported by the surface or the surface's
+// own preferred format if there's no match
+WGPUTextureFormat select_surface_format(
+    WGPUSurfaceCapabilities const& caps,
+    WGPUTextureFormat const* preferred,
+    std::size_t preferred_count);
+
 char const* to_string(WGPUFeatureName value);
 
 char const* to_string(WGPUAdapterType value);
@@ -75,6 +245,8 @@ char const* to_string(WGPUCompositeAlphaMode value);
 
 char const* to_string(WGPUPresentMode value);
 
+char const* to_string(PresentPolicy value);
+
 char const* to_string(WGPUMapAsyncStatus value);
 
 } // namespace wgpu::sandbox